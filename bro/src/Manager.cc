@@ -2,7 +2,10 @@
 // TODO: This is getting very messy. The Manager needs a refactoring
 // to split out the Spicy part and get rid of the PIMPLing.
 
+#include <algorithm>
 #include <memory>
+#include <sstream>
+#include <thread>
 
 #include <glob.h>
 
@@ -181,6 +184,13 @@ struct bro::hilti::SpicyEventInfo {
     accessor_list expr_accessors;      // One HILTI function per expression to access the value.
 };
 
+// A HILTI module waiting to be compiled into LLVM.
+struct PendingHiltiModule {
+    shared_ptr<::hilti::CompilerContext> context; // The context to compile the module with.
+    shared_ptr<::hilti::Module> module;           // The module.
+    bool save_llvm;                               // True to save the LLVM code if requested.
+};
+
 // Implementation of the Manager class attributes.
 struct Manager::PIMPL {
     typedef std::list<shared_ptr<SpicyModuleInfo>> spicy_module_list;
@@ -209,6 +219,11 @@ struct Manager::PIMPL {
     bool save_hilti; // Saves all HILTI modules into a file, set from BifConst::Hilti::save_hilti.
     bool save_llvm;  // Saves the final linked LLVM code into a file, set from
                      // BifConst::Hilti::save_llvm.
+    string save_shared; // Compiles the final code into a shared library, set from
+                        // BifConst::Hilti::save_shared.
+    string load_shared; // Loads the final code from a shared library, set from
+                        // BifConst::Hilti::load_shared.
+    bool use_shared;    // True if load_shared matches the code and will be used.
     bool spicy_to_compiler;     // If compiling scripts, raise event hooks from Spicy code directly.
     unsigned int profile;       // True to enable run-time profiling.
     unsigned int hilti_workers; // Number of HILTI worker threads to spawn.
@@ -234,10 +249,20 @@ struct Manager::PIMPL {
     shared_ptr<::hilti::CompilerContextJIT<::spicy::JIT>> hilti_context = nullptr;
     shared_ptr<::spicy::CompilerContext> spicy_context = nullptr;
 
+    // All HILTI modules that make up the final code. We compile them into
+    // LLVM only once we know that we don't have the result cached.
+    std::list<PendingHiltiModule> pending_hilti_modules;
+
     // All compiled LLVM modules. These will eventually be linked into
     // the final code.
     llvm_module_list llvm_modules;
 
+    // The key identifying the final code in the module cache.
+    ::util::cache::FileCache::Key cache_key;
+
+    // The native code that CheckCache() found in the cache, if any.
+    std::string cached_object_code;
+
     // All HILTI modules (loaded and compiled, including
     // intermediaries.). This is for debugging/printing only, they won't
     // be used further.
@@ -332,6 +357,12 @@ bool Manager::InitPostScripts()
     for ( auto t : ::util::strsplit(BifConst::Hilti::cg_debug->CheckString(), ":") )
         cg_debug.insert(t);
 
+    // Zero means to use all available cores.
+    unsigned int compile_jobs = BifConst::Hilti::compile_jobs;
+
+    if ( ! compile_jobs )
+        compile_jobs = std::max(std::thread::hardware_concurrency(), 1u);
+
     pimpl->compile_all = BifConst::Hilti::compile_all;
     pimpl->compile_scripts = BifConst::Hilti::compile_scripts;
     pimpl->profile = BifConst::Hilti::profile;
@@ -342,6 +373,9 @@ bool Manager::InitPostScripts()
     pimpl->save_spicy = BifConst::Hilti::save_spicy;
     pimpl->save_hilti = BifConst::Hilti::save_hilti;
     pimpl->save_llvm = BifConst::Hilti::save_llvm;
+    pimpl->save_shared = BifConst::Hilti::save_shared->CheckString();
+    pimpl->load_shared = BifConst::Hilti::load_shared->CheckString();
+    pimpl->use_shared = false;
     pimpl->spicy_to_compiler = BifConst::Hilti::spicy_to_compiler;
     pimpl->hilti_workers = BifConst::Hilti::hilti_workers;
 
@@ -352,6 +386,21 @@ bool Manager::InitPostScripts()
     pimpl->hilti_options->verify = ! BifConst::Hilti::no_verify;
     pimpl->hilti_options->cg_debug = cg_debug;
     pimpl->hilti_options->module_cache = BifConst::Hilti::use_cache ? ".cache" : "";
+    pimpl->hilti_options->jobs = compile_jobs;
+    pimpl->hilti_options->jit_lazy = BifConst::Hilti::jit_lazy;
+    pimpl->hilti_options->jit_tiered = BifConst::Hilti::jit_tiered;
+    pimpl->hilti_options->jit_native_runtime = BifConst::Hilti::jit_native_runtime;
+    pimpl->hilti_options->pgo_generate = BifConst::Hilti::pgo_generate;
+    pimpl->hilti_options->pgo_use = BifConst::Hilti::pgo_use->CheckString();
+
+    for ( auto t : ::util::strsplit(BifConst::Hilti::enable_optimizations->CheckString(), ":") ) {
+        if ( t.empty() )
+            continue;
+
+        if ( ! (pimpl->hilti_options->enableOptimization(t) &&
+                pimpl->spicy_options->enableOptimization(t)) )
+            reporter::error(::util::fmt("unknown optional optimization '%s'", t));
+    }
 
     pimpl->spicy_options->jit = true;
     pimpl->spicy_options->debug = BifConst::Hilti::debug;
@@ -360,6 +409,12 @@ bool Manager::InitPostScripts()
     pimpl->spicy_options->verify = ! BifConst::Hilti::no_verify;
     pimpl->spicy_options->cg_debug = cg_debug;
     pimpl->spicy_options->module_cache = BifConst::Hilti::use_cache ? ".cache" : "";
+    pimpl->spicy_options->jobs = compile_jobs;
+    pimpl->spicy_options->jit_lazy = BifConst::Hilti::jit_lazy;
+    pimpl->spicy_options->jit_tiered = BifConst::Hilti::jit_tiered;
+    pimpl->spicy_options->jit_native_runtime = BifConst::Hilti::jit_native_runtime;
+    pimpl->spicy_options->pgo_generate = BifConst::Hilti::pgo_generate;
+    pimpl->spicy_options->pgo_use = BifConst::Hilti::pgo_use->CheckString();
 
     pimpl->jit = nullptr;
 
@@ -578,9 +633,20 @@ bool Manager::Compile()
     assert(pre_scripts_init_run);
     assert(post_scripts_init_run);
 
+    // We report the wall-clock time spent in each phase of compilation.
+    auto phase_start = ::util::currentTime();
+
+    auto end_phase = [&phase_start](const char* phase) {
+        auto now = ::util::currentTime();
+        PLUGIN_DBG_LOG(HiltiPlugin, "Compile phase '%s' took %.2fs", phase, now - phase_start);
+        phase_start = now;
+    };
+
     if ( ! CompileBroScripts() )
         return false;
 
+    end_phase("scripts");
+
     for ( auto a : pimpl->spicy_analyzers ) {
         if ( a->unit_name_orig.size() ) {
             a->unit_orig = pimpl->spicy_ast->LookupUnit(a->unit_name_orig);
@@ -633,19 +699,19 @@ bool Manager::Compile()
     for ( auto m : pimpl->spicy_modules ) {
         // Compile the *.spicy module itself.
         shared_ptr<::hilti::Module> hilti_module_out;
-        auto llvm_module = m->context->compile(m->module, &hilti_module_out);
+        m->context->compile(m->module, &hilti_module_out, true);
 
-        if ( ! llvm_module )
+        if ( ! hilti_module_out )
             return false;
 
-        if ( pimpl->save_hilti && hilti_module_out ) {
+        if ( pimpl->save_hilti ) {
             ofstream out(::util::fmt("bro.spicy.%s.hlt", hilti_module_out->id()->name()));
             pimpl->hilti_context->print(hilti_module_out, out);
             out.close();
         }
 
-        pimpl->llvm_modules.push_back(std::move(llvm_module));
-        // m->llvm_modules.push_back(llvm_module);
+        pimpl->pending_hilti_modules.push_back(
+            {m->context->hiltiContext(), hilti_module_out, false});
 
         // Compile the generated hooks *.spicy module.
         if ( pimpl->dump_code_pre_finalize ) {
@@ -673,16 +739,15 @@ bool Manager::Compile()
             pimpl->spicy_context->print(m->spicy_module, std::cerr);
         }
 
-        llvm_module = pimpl->spicy_context->compile(m->spicy_module, &m->spicy_hilti_module);
+        pimpl->spicy_context->compile(m->spicy_module, &m->spicy_hilti_module, true);
 
-        if ( ! llvm_module )
+        if ( ! m->spicy_hilti_module )
             return false;
 
-        pimpl->llvm_modules.push_back(std::move(llvm_module));
-        // m->llvm_modules.push_back(llvm_module);
+        pimpl->pending_hilti_modules.push_back(
+            {pimpl->spicy_context->hiltiContext(), m->spicy_hilti_module, false});
 
-        if ( m->spicy_hilti_module )
-            pimpl->hilti_modules.push_back(m->spicy_hilti_module);
+        pimpl->hilti_modules.push_back(m->spicy_hilti_module);
 
         if ( pimpl->save_spicy ) {
             ofstream out(::util::fmt("bro.%s.spicy", m->spicy_module->id()->name()));
@@ -752,17 +817,7 @@ bool Manager::Compile()
         pimpl->hilti_context->importModule(std::make_shared<::hilti::ID>("LibBro"));
         pimpl->hilti_context->finalize(hilti_module);
 
-        auto llvm_hilti_module = m->hilti_context->compile(hilti_module);
-
-        if ( ! llvm_hilti_module ) {
-            reporter::error("compiling LibBro library module failed");
-            return false;
-        }
-
-        pimpl->llvm_modules.push_back(std::move(llvm_hilti_module));
-
-        // m->llvm_modules.push_back(llvm_hilti_module);
-        // pimpl->hilti_context->updateCache(m->key, m->llvm_modules);
+        pimpl->pending_hilti_modules.push_back({m->hilti_context, hilti_module, false});
     }
 
     if ( pimpl->save_hilti ) {
@@ -779,29 +834,72 @@ bool Manager::Compile()
     if ( ! CompileHiltiModule(glue) )
         return false;
 
-    // Compile and link all the HILTI modules into LLVM. We use the
-    // Spicy context here to make sure we gets its additional
-    // libraries linked.
-    //
-    PLUGIN_DBG_LOG(HiltiPlugin, "Compiling & linking all HILTI code into a single LLVM module");
+    end_phase("spicy-to-hilti");
 
-    auto llvm_module =
-        pimpl->spicy_context->linkModules("__bro_linked__", std::move(pimpl->llvm_modules));
+    std::unique_ptr<llvm::Module> llvm_module;
 
-    if ( ! llvm_module ) {
-        reporter::error("linking failed");
-        return false;
-    }
+    BuildCodeKey();
 
-    if ( pimpl->save_llvm ) {
-        ofstream out("bro.ll");
-        pimpl->hilti_context->printBitcode(llvm_module.get(), out);
-        out.close();
-    }
+    // When saving a shared library, we need the LLVM code.
+    auto cached = false;
+
+    if ( pimpl->load_shared.size() )
+        pimpl->use_shared = CheckSharedObject();
+
+    if ( ! pimpl->use_shared && pimpl->save_shared.empty() )
+        cached = CheckCache();
+
+    end_phase("cache");
+
+    if ( ! (cached || pimpl->use_shared) ) {
+        // Compile and link all the HILTI modules into LLVM. We use the
+        // Spicy context here to make sure we gets its additional
+        // libraries linked.
+        //
+        PLUGIN_DBG_LOG(HiltiPlugin,
+                       "Compiling & linking all HILTI code into a single LLVM module");
+
+        if ( ! CompilePendingHiltiModules() )
+            return false;
+
+        end_phase("hilti-to-llvm");
+
+        llvm_module =
+            pimpl->spicy_context->linkModules("__bro_linked__", std::move(pimpl->llvm_modules));
+
+        if ( ! llvm_module ) {
+            reporter::error("linking failed");
+            return false;
+        }
+
+        end_phase("link");
+
+        if ( pimpl->save_llvm ) {
+            ofstream out("bro.ll");
+            pimpl->hilti_context->printBitcode(llvm_module.get(), out);
+            out.close();
+        }
+
+        llvm_module->setModuleIdentifier("__bro_linked__");
+
+        if ( pimpl->save_shared.size() ) {
+            PLUGIN_DBG_LOG(HiltiPlugin, "Compiling final code into %s",
+                           pimpl->save_shared.c_str());
+
+            if ( ! pimpl->hilti_context->compileSharedObject(llvm_module.get(),
+                                                             pimpl->save_shared,
+                                                             pimpl->cache_key) ) {
+                reporter::error(
+                    ::util::fmt("cannot create shared library %s", pimpl->save_shared));
+                return false;
+            }
 
-    llvm_module->setModuleIdentifier("__bro_linked__");
+            end_phase("shared");
+        }
+    }
 
     auto result = RunJIT(std::move(llvm_module));
+    end_phase("jit");
     PLUGIN_DBG_LOG(HiltiPlugin, "Done with compilation");
 
     PLUGIN_DBG_LOG(HiltiPlugin, "Registering analyzers through events");
@@ -843,22 +941,89 @@ bool Manager::CompileBroScripts()
 
 bool Manager::CompileHiltiModule(std::shared_ptr<::hilti::Module> m)
 {
-    // TODO: Add caching.
-    auto lm = pimpl->hilti_context->compile(m);
+    pimpl->pending_hilti_modules.push_back({pimpl->hilti_context, m, true});
+    pimpl->hilti_modules.push_back(m);
+    return true;
+}
 
-    if ( ! lm ) {
-        reporter::error(::util::fmt("compiling script module %s failed", m->id()->name()));
+bool Manager::CompilePendingHiltiModules()
+{
+    // The modules are independent until linking, so the HILTI context can
+    // compile them concurrently.
+    std::list<shared_ptr<::hilti::Module>> modules;
+
+    for ( auto p : pimpl->pending_hilti_modules )
+        modules.push_back(p.module);
+
+    auto compiled = pimpl->hilti_context->compile(modules);
+
+    if ( compiled.empty() ) {
+        reporter::error("compiling HILTI modules failed");
         return false;
     }
 
-    if ( pimpl->save_llvm ) {
-        ofstream out(::util::fmt("bro.%s.ll", m->id()->name()));
-        pimpl->hilti_context->printBitcode(lm.get(), out);
-        out.close();
+    auto p = pimpl->pending_hilti_modules.begin();
+
+    for ( auto& lm : compiled ) {
+        if ( pimpl->save_llvm && p->save_llvm ) {
+            ofstream out(::util::fmt("bro.%s.ll", p->module->id()->name()));
+            pimpl->hilti_context->printBitcode(lm.get(), out);
+            out.close();
+        }
+
+        pimpl->llvm_modules.push_back(std::move(lm));
+        ++p;
     }
 
-    pimpl->llvm_modules.push_back(std::move(lm));
-    pimpl->hilti_modules.push_back(m);
+    pimpl->pending_hilti_modules.clear();
+    return true;
+}
+
+void Manager::BuildCodeKey()
+{
+    // We key the final code on the HILTI code going into it, which
+    // captures everything from the *.spicy and *.evt files to the Bro
+    // scripts. In addition, we add the Spicy sources themselves to pick up
+    // the compiler's identity.
+    auto key = &pimpl->cache_key;
+    key->scope = "bro";
+    key->name = "__bro_linked__";
+    pimpl->spicy_options->toCacheKey(key);
+
+    for ( auto m : pimpl->spicy_modules )
+        m->context->toCacheKey(m->module, key);
+
+    for ( auto p : pimpl->pending_hilti_modules ) {
+        std::ostringstream s;
+        p.context->print(p.module, s);
+        key->hashes.insert(::util::cache::hash(s.str()));
+    }
+}
+
+bool Manager::CheckCache()
+{
+    if ( ! pimpl->hilti_context->fileCache() )
+        return false;
+
+    auto code = &pimpl->cached_object_code;
+
+    if ( ! pimpl->hilti_context->checkObjectCache(pimpl->cache_key, code) )
+        return false;
+
+    PLUGIN_DBG_LOG(HiltiPlugin, "Found compiled code in cache, skipping compilation");
+    return true;
+}
+
+bool Manager::CheckSharedObject()
+{
+    if ( ! pimpl->hilti_context->checkSharedObject(pimpl->load_shared, pimpl->cache_key) ) {
+        reporter::warning(::util::fmt("%s does not match the current analyzers, compiling instead",
+                                      pimpl->load_shared));
+        return false;
+    }
+
+    PLUGIN_DBG_LOG(HiltiPlugin, "Using precompiled code from %s, skipping compilation",
+                   pimpl->load_shared.c_str());
     return true;
 }
 
@@ -872,9 +1037,23 @@ bool Manager::RunJIT(std::unique_ptr<llvm::Module> llvm_module)
     cfg.num_workers = pimpl->hilti_workers;
     hlt_config_set(&cfg);
 
-    PLUGIN_DBG_LOG(HiltiPlugin, "Running JIT on LLVM module");
+    std::unique_ptr<::spicy::JIT> jit;
+
+    if ( pimpl->use_shared ) {
+        PLUGIN_DBG_LOG(HiltiPlugin, "Loading shared library %s", pimpl->load_shared.c_str());
+        jit = pimpl->hilti_context->jitSharedObject(pimpl->load_shared, pimpl->cache_key);
+    }
+
+    else if ( llvm_module ) {
+        PLUGIN_DBG_LOG(HiltiPlugin, "Running JIT on LLVM module");
+        jit = pimpl->hilti_context->jit(std::move(llvm_module), pimpl->cache_key);
+    }
 
-    auto jit = pimpl->hilti_context->jit(std::move(llvm_module));
+    else {
+        PLUGIN_DBG_LOG(HiltiPlugin, "Running JIT on cached native code");
+        auto object_code = std::move(pimpl->cached_object_code);
+        jit = pimpl->hilti_context->jitObject(object_code);
+    }
 
     if ( ! jit ) {
         reporter::error("jit failed");
@@ -2960,6 +3139,8 @@ void Manager::DumpMemoryStatistics()
     uint64_t total_refs = stats.num_refs;
     uint64_t current_allocs = stats.num_allocs - stats.num_deallocs;
 
+    hlt_fiber_stats fstats = hlt_fiber_statistics(hlt_global_execution_context());
+
     fprintf(stderr, "%" PRIu64
                     "M heap, "
                     "%" PRIu64
@@ -2969,7 +3150,10 @@ void Manager::DumpMemoryStatistics()
                     "%" PRIu64
                     " allocations, "
                     "%" PRIu64
-                    " totals refs"
+                    " totals refs, "
+                    "%" PRIu64 "/%" PRIu64
+                    " fiber pool hits/misses"
                     "\n",
-            heap, alloced, size_stacks, num_stacks, current_allocs, total_refs);
+            heap, alloced, size_stacks, num_stacks, current_allocs, total_refs, fstats.hits,
+            fstats.misses);
 }
@@ -461,15 +461,44 @@ protected:
     /**
      * JIT's and executes the final linked module.
      *
-     * @param llvm_module The code to jit and run.
+     * @param llvm_module The code to jit and run. If null, uses the native
+     * code that CheckSharedObject() or CheckCache() found.
      */
     bool RunJIT(std::unique_ptr<llvm::Module> llvm_module);
 
     /**
-     * XXX
+     * Schedules a HILTI module for compilation into the final code.
      */
     bool CompileHiltiModule(std::shared_ptr<::hilti::Module> m);
 
+    /**
+     * Compiles all HILTI modules scheduled so far into LLVM.
+     */
+    bool CompilePendingHiltiModules();
+
+    /**
+     * Computes the key identifying the final code from all HILTI modules
+     * scheduled for compilation. Both the cache and shared libraries with
+     * precompiled code use this key.
+     */
+    void BuildCodeKey();
+
+    /**
+     * Looks up the native code for the key that BuildCodeKey() computed
+     * in the cache.
+     *
+     * @return True if the code was found in the cache.
+     */
+    bool CheckCache();
+
+    /**
+     * Checks if the shared library set through Hilti::load_shared
+     * matches the key that BuildCodeKey() computed.
+     *
+     * @return True if the library can be used.
+     */
+    bool CheckSharedObject();
+
     /**
      * XXX
      */
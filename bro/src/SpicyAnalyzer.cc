@@ -82,6 +82,17 @@ static inline void debug_msg(analyzer::Analyzer* analyzer, const char* msg, int
 #endif
 }
 
+// Returns a heap copy of a chunk for the bytes object to take ownership of.
+// Unlike data that the bytes object copies itself, which it stores inline,
+// this lets hlt_bytes_sub() hand out views into the chunk rather than
+// copying fields out of it once more.
+static inline int8_t* copy_chunk(const u_char* data, int len)
+{
+    int8_t* copy = (int8_t*)hlt_malloc_no_init(len);
+    memcpy(copy, data, len);
+    return copy;
+}
+
 int Spicy_Analyzer::FeedChunk(int len, const u_char* data, bool is_orig, bool eod)
 {
     hlt_execution_context* ctx = hlt_global_execution_context();
@@ -121,7 +132,8 @@ int Spicy_Analyzer::FeedChunk(int len, const u_char* data, bool is_orig, bool eo
         // First chunk.
         debug_msg(endp->cookie.protocol_cookie.analyzer, "initial chunk", len, data, is_orig);
 
-        endp->data = hlt_bytes_new_from_data_copy((const int8_t*)data, len, &excpt, ctx);
+        endp->data = len ? hlt_bytes_new_from_data(copy_chunk(data, len), len, &excpt, ctx) :
+                           hlt_bytes_new(&excpt, ctx);
         GC_CCTOR(endp->data, hlt_bytes, ctx);
 
         if ( eod )
@@ -147,7 +159,7 @@ int Spicy_Analyzer::FeedChunk(int len, const u_char* data, bool is_orig, bool eo
         assert(endp->data && endp->resume);
 
         if ( len )
-            hlt_bytes_append_raw_copy(endp->data, (int8_t*)data, len, &excpt, ctx);
+            hlt_bytes_append_raw(endp->data, copy_chunk(data, len), len, &excpt, ctx);
 
         if ( eod )
             hlt_bytes_freeze(endp->data, 1, &excpt, ctx);
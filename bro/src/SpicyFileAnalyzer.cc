@@ -37,6 +37,16 @@ static inline void debug_msg(file_analysis::Analyzer* analyzer, const char* msg,
 #endif
 }
 
+// Returns a heap copy of a chunk that the bytes object takes over, so that
+// sub-ranges parsed out of it can be views (see copy_chunk() in
+// SpicyAnalyzer.cc).
+static inline int8_t* copy_chunk(const u_char* data, int len)
+{
+    int8_t* copy = (int8_t*)hlt_malloc_no_init(len);
+    memcpy(copy, data, len);
+    return copy;
+}
+
 Spicy_FileAnalyzer::Spicy_FileAnalyzer(RecordVal* arg_args, file_analysis::File* arg_file)
     : file_analysis::Analyzer(arg_args, arg_file)
 {
@@ -112,7 +122,8 @@ int Spicy_FileAnalyzer::FeedChunk(int len, const u_char* chunk, bool eod)
         // First chunk.
         debug_msg(this, "initial chunk", len, chunk);
 
-        data = hlt_bytes_new_from_data_copy((const int8_t*)chunk, len, &excpt, ctx);
+        data = len ? hlt_bytes_new_from_data(copy_chunk(chunk, len), len, &excpt, ctx) :
+                     hlt_bytes_new(&excpt, ctx);
 
         if ( eod )
             hlt_bytes_freeze(data, 1, &excpt, ctx);
@@ -137,7 +148,7 @@ int Spicy_FileAnalyzer::FeedChunk(int len, const u_char* chunk, bool eod)
         assert(data && resume);
 
         if ( len )
-            hlt_bytes_append_raw_copy(data, (int8_t*)chunk, len, &excpt, ctx);
+            hlt_bytes_append_raw(data, copy_chunk(chunk, len), len, &excpt, ctx);
 
         if ( eod )
             hlt_bytes_freeze(data, 1, &excpt, ctx);
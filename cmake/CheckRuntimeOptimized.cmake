@@ -0,0 +1,22 @@
+#
+# Verifies that a native runtime library was built with optimization, as
+# indicated by the __hlt_runtime_optimized marker that libhilti defines
+# only when compiled with __OPTIMIZE__.
+#
+# Usage: cmake -DLIBRARY=<path> [-DNM=<nm>] -P CheckRuntimeOptimized.cmake
+
+if ( NOT NM )
+    set(NM nm)
+endif ()
+
+execute_process(COMMAND ${NM} -D ${LIBRARY}
+                OUTPUT_VARIABLE symbols
+                RESULT_VARIABLE result)
+
+if ( NOT result EQUAL 0 )
+    message(FATAL_ERROR "cannot read symbols of ${LIBRARY}")
+endif ()
+
+if ( NOT symbols MATCHES "__hlt_runtime_optimized" )
+    message(FATAL_ERROR "${LIBRARY} is not optimized")
+endif ()
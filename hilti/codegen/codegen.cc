@@ -1,4 +1,6 @@
 
+#include <limits>
+
 #include <util/util.h>
 
 #include "../module.h"
@@ -6,6 +8,7 @@
 #include "../statement.h"
 
 #include "../builder/nodes.h"
+#include "../context.h"
 #include "../passes/collector.h"
 #include "abi.h"
 #include "codegen.h"
@@ -14,6 +17,7 @@
 #include "field-builder.h"
 #include "loader.h"
 #include "packer.h"
+#include "pgo.h"
 #include "stmt-builder.h"
 #include "storer.h"
 #include "type-builder.h"
@@ -25,7 +29,7 @@
 using namespace hilti;
 using namespace codegen;
 
-CodeGen::CodeGen(CompilerContext* ctx, const path_list& libdirs)
+CodeGen::CodeGen(CompilerContext* ctx, const path_list& libdirs, llvm::LLVMContext* llvm_context)
     : _loader(new Loader(this)),
       _storer(new Storer(this)),
       _unpacker(new Unpacker(this)),
@@ -38,6 +42,7 @@ CodeGen::CodeGen(CompilerContext* ctx, const path_list& libdirs)
       _collector(new passes::Collector())
 {
     _ctx = ctx;
+    _llvm_context = llvm_context ? llvm_context : &ctx->llvmContext();
     _libdirs = libdirs;
     setLoggerName("codegen");
 }
@@ -58,13 +63,14 @@ const Options& CodeGen::options() const
 
 llvm::LLVMContext& CodeGen::llvmContext()
 {
-    return _ctx->llvmContext();
+    return *_llvm_context;
 }
 
 std::unique_ptr<llvm::Module> CodeGen::generateLLVM(shared_ptr<hilti::Module> hltmod)
 {
     _hilti_module = hltmod;
     _functions.clear();
+    _pgo_counters.clear();
 
     if ( options().cgDebugging("codegen") )
         debugSetLevel(1);
@@ -271,15 +277,14 @@ string CodeGen::scopedNameGlobal(Variable* var) const
 
 llvm::Value* CodeGen::llvmGlobal(Variable* var)
 {
-    // The linker will replace this code with the actual global value.
-    llvm::Value* dummy = builder()->CreateAlloca(llvmTypePtr(llvmType(var->type())));
-    auto ins = builder()->CreateLoad(dummy);
-
-    auto name = util::llvmMetadata(llvmContext(), scopedNameGlobal(var));
-    auto tuple = util::llvmMetadata(llvmContext(), {name});
-    llvm::cast<llvm::Instruction>(ins)->setMetadata("global-access", tuple);
+    // The linker will replace this call with the global's actual address.
+    // As the function remains opaque until then, optimizing the module
+    // before linking leaves the call and the name we pass in place.
+    auto ftype = llvm::FunctionType::get(llvmTypePtr(), {llvmTypePtr()}, false);
+    auto func = _module->getOrInsertFunction(symbols::FuncGlobalAccess, ftype);
+    auto addr = builder()->CreateCall(func, {llvmConstAsciizPtr(scopedNameGlobal(var))});
 
-    return ins;
+    return builder()->CreateBitCast(addr, llvmTypePtr(llvmType(var->type())));
 }
 
 llvm::Value* CodeGen::llvmValue(shared_ptr<Expression> expr, shared_ptr<hilti::Type> coerce_to,
@@ -648,6 +653,9 @@ void CodeGen::finishInitFunction()
     // state.
     assert(function() == _module_init_func);
 
+    if ( options().pgo_generate && ! block()->getTerminator() )
+        llvmPGORegisterCounters();
+
     if ( ! functionEmpty() ) {
 #if 0
         // Add a terminator to the function.
@@ -1694,6 +1702,33 @@ llvm::Function* CodeGen::llvmFunctionHookRun(shared_ptr<Hook> hook)
     return func;
 }
 
+llvm::GlobalVariable* CodeGen::llvmHookImplemented(shared_ptr<Hook> hook)
+{
+    auto func = llvmFunctionHookRun(hook);
+    auto name = func->getName().str() + symbols::SuffixHookImplemented;
+
+    auto glob = _module->getGlobalVariable(name);
+
+    if ( glob )
+        return glob;
+
+    return new llvm::GlobalVariable(*_module, llvm::Type::getInt1Ty(llvmContext()), true,
+                                    llvm::GlobalValue::ExternalLinkage, nullptr, name);
+}
+
+llvm::GlobalVariable* CodeGen::llvmHookGroupChecked(int64_t group)
+{
+    auto name = string(symbols::PrefixHookGroupChecked) + std::to_string(group);
+
+    auto glob = _module->getGlobalVariable(name);
+
+    if ( glob )
+        return glob;
+
+    return new llvm::GlobalVariable(*_module, llvm::Type::getInt1Ty(llvmContext()), true,
+                                    llvm::GlobalValue::ExternalLinkage, nullptr, name);
+}
+
 void CodeGen::llvmAddHookMetaData(shared_ptr<Hook> hook, llvm::Value* llvm_func)
 {
     std::vector<llvm::Value*> vals;
@@ -1719,6 +1754,16 @@ void CodeGen::llvmAddHookMetaData(shared_ptr<Hook> hook, llvm::Value* llvm_func)
     util::llvmAddGlobalMetadata(_module.get(), symbols::MetaHookImpls, mds, true);
 }
 
+void CodeGen::llvmAddHookGroupDisabledMetaData(int64_t group)
+{
+    std::vector<llvm::Metadata*> mds = {
+        util::llvmMetadata(llvmContext(), llvmConstInt(group, 64)) // Hook group
+    };
+
+    // The linker will merge all the entries.
+    util::llvmAddGlobalMetadata(_module.get(), symbols::MetaHookGroupsDisabled, mds, true);
+}
+
 llvm::Function* CodeGen::llvmFunction(shared_ptr<ID> id)
 {
     auto expr = _hilti_module->body()->scope()->lookupUnique(id);
@@ -4593,6 +4638,120 @@ void CodeGen::llvmProfilerUpdate(const string& tag, int64_t arg)
     llvmProfilerUpdate(ltag, larg);
 }
 
+void CodeGen::llvmPGOFunctionEntry()
+{
+    auto func = function();
+    auto key = ::util::fmt("entry/%s/%s", _module->getName().str(), func->getName().str());
+
+    if ( options().pgo_generate )
+        llvmPGOIncrement(builder(), llvmPGOCounter(key));
+
+    auto profile = _ctx->pgoProfile();
+    uint64_t count;
+
+    if ( ! (profile && profile->lookup(key, &count)) )
+        return;
+
+    func->setEntryCount(count);
+
+    if ( count == 0 )
+        func->addFnAttr(llvm::Attribute::Cold);
+
+    else if ( count >= profile->hotThreshold() )
+        func->addFnAttr(llvm::Attribute::InlineHint);
+}
+
+void CodeGen::llvmPGOBranch(llvm::TerminatorInst* branch)
+{
+    auto profile = _ctx->pgoProfile();
+
+    if ( ! (options().pgo_generate || profile) )
+        return;
+
+    auto state = _functions.back().get();
+    auto key = ::util::fmt("edge/%s/%s/%d", _module->getName().str(),
+                           state->function->getName().str(), ++state->pgo_branches);
+
+    if ( profile ) {
+        std::vector<uint64_t> counts;
+        uint64_t max = 0;
+
+        for ( unsigned int i = 0; i < branch->getNumSuccessors(); i++ ) {
+            uint64_t count;
+
+            if ( ! profile->lookup(::util::fmt("%s/%u", key, i), &count) )
+                break;
+
+            counts.push_back(count);
+            max = std::max(max, count);
+        }
+
+        // Branch weights are 32-bit, so scale down if necessary. Like
+        // clang, we add one to each so that no edge is considered
+        // impossible. If the branch never ran, we leave it alone.
+        if ( counts.size() == branch->getNumSuccessors() && max > 0 ) {
+            uint64_t scale = max / std::numeric_limits<uint32_t>::max() + 1;
+            std::vector<uint32_t> weights;
+
+            for ( auto c : counts )
+                weights.push_back(static_cast<uint32_t>(c / scale + 1));
+
+            llvm::MDBuilder md(llvmContext());
+            branch->setMetadata(llvm::LLVMContext::MD_prof, md.createBranchWeights(weights));
+        }
+    }
+
+    if ( options().pgo_generate ) {
+        // Count each edge in a block of its own that we insert in between.
+        for ( unsigned int i = 0; i < branch->getNumSuccessors(); i++ ) {
+            auto edge = newBuilder("pgo-edge");
+            llvmPGOIncrement(edge, llvmPGOCounter(::util::fmt("%s/%u", key, i)));
+            edge->CreateBr(branch->getSuccessor(i));
+            branch->setSuccessor(i, edge->GetInsertBlock());
+        }
+    }
+}
+
+llvm::GlobalVariable* CodeGen::llvmPGOCounter(const string& key)
+{
+    auto counter = llvmAddGlobal("pgo", llvmTypeInt(64));
+    _pgo_counters.push_back(std::make_pair(key, counter));
+    return counter;
+}
+
+void CodeGen::llvmPGOIncrement(IRBuilder* builder, llvm::GlobalVariable* counter)
+{
+    // Not atomic, as for the other runtime profiling. With multiple
+    // threads, counts may be a bit off, which is fine for our purposes.
+    auto val = builder->CreateLoad(counter);
+    builder->CreateStore(builder->CreateAdd(val, llvmConstInt(1, 64)), counter);
+}
+
+void CodeGen::llvmPGORegisterCounters()
+{
+    if ( _pgo_counters.empty() )
+        return;
+
+    constant_list keys;
+    constant_list counters;
+
+    for ( auto c : _pgo_counters ) {
+        keys.push_back(llvmConstAsciizPtr(c.first));
+        counters.push_back(c.second);
+    }
+
+    auto keys_array = llvmAddConst("pgo-keys", llvmConstArray(llvmTypePtr(), keys));
+    auto counters_array =
+        llvmAddConst("pgo-counters", llvmConstArray(llvmTypePtr(llvmTypeInt(64)), counters));
+
+    value_list args = {
+        builder()->CreateBitCast(keys_array, llvmTypePtr(llvmTypePtr())),
+        builder()->CreateBitCast(counters_array, llvmTypePtr(llvmTypePtr(llvmTypeInt(64)))),
+        llvmConstInt(_pgo_counters.size(), 64)};
+
+    llvmCallC("__hlt_profiler_pgo_register", args, false, false);
+}
+
 string CodeGen::llvmGetModuleIdentifier(llvm::Module* module)
 {
     auto mds = util::llvmGetGlobalMetadata(module, symbols::MetaModuleName);
@@ -76,7 +76,11 @@ public:
     ///
     /// libdirs: Path where to find library modules that the code generator
     /// may need.
-    CodeGen(CompilerContext* ctx, const path_list& libdirs);
+    ///
+    /// llvm_context: The LLVM context to create the generated code in. If
+    /// not given, the compiler context's is used.
+    CodeGen(CompilerContext* ctx, const path_list& libdirs,
+            llvm::LLVMContext* llvm_context = nullptr);
     virtual ~CodeGen();
 
     /// Returns the compiler context the code generator is used with.
@@ -432,6 +436,26 @@ public:
     /// Returns: The function with the corresponding signature.
     llvm::Function* llvmFunctionHookRun(shared_ptr<Hook> hook);
 
+    /// Returns a global boolean that indicates whether any functions
+    /// implementing a hook have been linked in. The global is only declared
+    /// here; the linker defines it as a constant once it has seen all hook
+    /// implementations.
+    ///
+    /// hook: The hook.
+    ///
+    /// Returns: The global, of LLVM type ``i1``.
+    llvm::GlobalVariable* llvmHookImplemented(shared_ptr<Hook> hook);
+
+    /// Returns a global boolean that indicates whether implementations of
+    /// a hook group need to check at run-time whether the group is enabled.
+    /// The global is only declared here; the linker defines it as a
+    /// constant once it has seen which groups the program may disable.
+    ///
+    /// group: The hook group.
+    ///
+    /// Returns: The global, of LLVM type ``i1``.
+    llvm::GlobalVariable* llvmHookGroupChecked(int64_t group);
+
     /// Returns the LLVM value for a HILTI expression.
     ///
     /// This method branches out the Loader to do its work.
@@ -1367,6 +1391,14 @@ public:
     /// llvm_func: The LLVM function corresponding to the hook implementation.
     void llvmAddHookMetaData(shared_ptr<Hook> hook, llvm::Value* llvm_func);
 
+    /// Adds meta data recording that the code may disable a hook group.
+    /// The linker evaluates it to remove the run-time checks for all groups
+    /// that remain enabled. This is primarily meant for being called from
+    /// the statement builder.
+    ///
+    /// group: The hook group, or -1 if not known at compile time.
+    void llvmAddHookGroupDisabledMetaData(int64_t group);
+
     /// Inserts code that checks with a \c C-HILTI function has raised an
     /// exception. If so, the code will reraise that as a HILTI exception.
     ///
@@ -2324,6 +2356,22 @@ public:
     /// arg: The argument for the update.
     void llvmProfilerUpdate(const string& tag, int64_t arg);
 
+    /// Adds support for profile-guided optimization to the entry of the
+    /// current function. With Options::pgo_generate, this counts the
+    /// function's executions. With Options::pgo_use, it sets the function's
+    /// entry count from the profile and marks the function as hot or cold.
+    /// Must be called right after pushing the function.
+    void llvmPGOFunctionEntry();
+
+    /// Adds support for profile-guided optimization to a branch or switch
+    /// instruction that has just been created inside the current function.
+    /// With Options::pgo_generate, this counts how often control goes to
+    /// each of the instruction's successors. With Options::pgo_use, it
+    /// attaches corresponding branch weights from the profile.
+    ///
+    /// branch: The instruction.
+    void llvmPGOBranch(llvm::TerminatorInst* branch);
+
     /// XXX
     void prepareCall(shared_ptr<Expression> func, shared_ptr<Expression> args,
                      CodeGen::expr_list* call_params, bool before_call);
@@ -2352,6 +2400,16 @@ private:
     // Creates a function that initializes the module's global variables.
     void createGlobalsInitFunction();
 
+    // Returns a new counter for profile-guided optimization.
+    llvm::GlobalVariable* llvmPGOCounter(const string& key);
+
+    // Increments a counter for profile-guided optimization.
+    void llvmPGOIncrement(IRBuilder* builder, llvm::GlobalVariable* counter);
+
+    // Registers all the counters for profile-guided optimization with the
+    // runtime. To be called from the module's init function.
+    void llvmPGORegisterCounters();
+
     // Creates the module-specific information for our custom linker pass.
     void createLinkerData();
 
@@ -2496,6 +2554,7 @@ private:
 
     shared_ptr<hilti::Module> _hilti_module = nullptr;
     CompilerContext* _ctx = nullptr;
+    llvm::LLVMContext* _llvm_context = nullptr;
     llvm::DataLayout* _data_layout = nullptr;
     llvm::Function* _module_init_func = nullptr;
     llvm::Function* _globals_init_func = nullptr;
@@ -2503,6 +2562,8 @@ private:
     llvm::Value* _globals_base_func = nullptr;
     llvm::Type* _globals_type = nullptr;
 
+    std::list<std::pair<string, llvm::GlobalVariable*>> _pgo_counters;
+
     typedef std::list<std::pair<shared_ptr<Expression>, shared_ptr<type::Exception>>> handler_list;
     typedef std::list<IRBuilder*> builder_list;
     typedef std::map<string, int> label_map;
@@ -2538,6 +2599,7 @@ private:
         handler_list catches;
         type::function::CallingConvention cc;
         int stackmap_id = 0;
+        int pgo_branches = 0;
     };
 
     typedef std::list<std::unique_ptr<FunctionState>> function_list;
@@ -2,6 +2,7 @@
 #include <hilti/hilti-intern.h>
 
 #include "../stmt-builder.h"
+#include "../type-builder.h"
 
 using namespace hilti;
 using namespace codegen;
@@ -16,10 +17,17 @@ void StatementBuilder::visit(statement::instruction::channel::New* i)
     if ( ! op2 )
         op2 = builder::integer::create(0);
 
+    bool spsc = false;
+
+    if ( auto op3 = i->op3() ) {
+        auto c = ast::rtti::checkedCast<expression::Constant>(op3);
+        spsc = ast::rtti::checkedCast<constant::Bool>(c->constant())->value();
+    }
+
     CodeGen::expr_list args;
     args.push_back(op1);
     args.push_back(op2);
-    auto result = cg()->llvmCall("hlt::channel_new", args);
+    auto result = cg()->llvmCall(spsc ? "hlt::channel_new_spsc" : "hlt::channel_new", args);
     cg()->llvmStore(i, result);
 }
 
@@ -51,6 +59,31 @@ void StatementBuilder::visit(statement::instruction::channel::ReadTry* i)
     _readFinish(cg(), i, val);
 }
 
+static llvm::Value* _readBatchTry(CodeGen* cg, statement::Instruction* i)
+{
+    auto rtype = ast::rtti::checkedCast<type::Reference>(i->op1()->type());
+    auto etype = ast::rtti::checkedCast<type::Channel>(rtype->argType())->argType();
+    auto def = builder::codegen::create(etype, cg->typeInfo(etype)->init_val);
+
+    auto op2 = i->op2();
+
+    if ( ! op2 )
+        op2 = builder::integer::create(0);
+
+    CodeGen::expr_list args = {i->op1(), op2, def};
+    return cg->llvmCall("hlt::channel_read_batch_try", args, false, false);
+}
+
+static void _readBatchFinish(CodeGen* cg, statement::Instruction* i, llvm::Value* result)
+{
+    cg->llvmStore(i, result);
+}
+
+void StatementBuilder::visit(statement::instruction::channel::ReadBatch* i)
+{
+    cg()->llvmBlockingInstruction(i, _readBatchTry, _readBatchFinish);
+}
+
 void StatementBuilder::visit(statement::instruction::channel::Size* i)
 {
     CodeGen::expr_list args;
@@ -87,3 +120,14 @@ void StatementBuilder::visit(statement::instruction::channel::WriteTry* i)
 
     _writeFinish(cg(), i, val);
 }
+
+static llvm::Value* _writeBatchTry(CodeGen* cg, statement::Instruction* i)
+{
+    CodeGen::expr_list args = {i->op1(), i->op2()};
+    return cg->llvmCall("hlt::channel_write_batch_try", args, false, false);
+}
+
+void StatementBuilder::visit(statement::instruction::channel::WriteBatch* i)
+{
+    cg()->llvmBlockingInstruction(i, _writeBatchTry, _writeFinish);
+}
@@ -247,7 +247,8 @@ void StatementBuilder::visit(statement::instruction::flow::IfElse* i)
 
     cg()->llvmBuildInstructionCleanup();
 
-    cg()->builder()->CreateCondBr(op1, op2_bb, op3_bb);
+    auto branch = cg()->builder()->CreateCondBr(op1, op2_bb, op3_bb);
+    cg()->llvmPGOBranch(branch);
 }
 
 void StatementBuilder::visit(statement::instruction::flow::Jump* i)
@@ -297,6 +298,8 @@ void StatementBuilder::visit(statement::instruction::flow::Switch* i)
             assert(c);
             switch_->addCase(c, a.second);
         }
+
+        cg()->llvmPGOBranch(switch_);
     }
 
     else {
@@ -351,6 +354,8 @@ void StatementBuilder::visit(statement::instruction::flow::Switch* i)
         for ( auto a : alts )
             switch_->addCase(cg()->llvmConstInt(n++, 64), a.second);
 
+        cg()->llvmPGOBranch(switch_);
+
         cg()->popBuilder();
     }
 }
@@ -420,5 +425,7 @@ void StatementBuilder::visit(statement::instruction::flow::DispatchUnion* i)
     for ( auto a : alts )
         switch_->addCase(cg()->llvmConstInt(n++, 64), a.second);
 
+    cg()->llvmPGOBranch(switch_);
+
     cg()->popBuilder();
 }
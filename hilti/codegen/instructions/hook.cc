@@ -9,6 +9,17 @@ using namespace codegen;
 
 void StatementBuilder::visit(statement::instruction::hook::DisableGroup* i)
 {
+    // Let the linker know that the group's implementations need to check
+    // whether it's enabled.
+    int64_t group = -1;
+
+    if ( auto c = ast::rtti::tryCast<expression::Constant>(i->op1()) ) {
+        if ( auto ci = ast::rtti::tryCast<constant::Integer>(c->constant()) )
+            group = ci->value();
+    }
+
+    cg()->llvmAddHookGroupDisabledMetaData(group);
+
     CodeGen::expr_list args;
     args.push_back(i->op1());
     args.push_back(builder::boolean::create(0));
@@ -33,6 +44,16 @@ void StatementBuilder::visit(statement::instruction::hook::GroupEnabled* i)
     cg()->llvmStore(i, result);
 }
 
+void StatementBuilder::visit(statement::instruction::hook::Implemented* i)
+{
+    auto func = ast::rtti::tryCast<expression::Function>(i->op1())->function();
+    auto hook = ast::rtti::tryCast<Hook>(func);
+    assert(hook);
+
+    auto result = builder()->CreateLoad(cg()->llvmHookImplemented(hook));
+    cg()->llvmStore(i, result);
+}
+
 void StatementBuilder::visit(statement::instruction::hook::Run* i)
 {
     auto func = ast::rtti::tryCast<expression::Function>(i->op1())->function();
@@ -145,6 +145,47 @@ void StatementBuilder::visit(statement::instruction::ioSource::Read* i)
                                   });
 }
 
+static llvm::Value* _readBatchTry(CodeGen* cg, statement::Instruction* i)
+{
+    auto op2 = i->op2();
+
+    if ( ! op2 )
+        op2 = builder::integer::create(0);
+
+    CodeGen::expr_list args = {i->op1(), op2, builder::boolean::create(false)};
+    return cg->llvmCall("hlt::iosrc_read_batch_try", args, false, false);
+}
+
+static void _readBatchFinish(CodeGen* cg, statement::Instruction* i, llvm::Value* result)
+{
+    auto exhausted = cg->llvmCreateIsNull(result);
+
+    auto builder_exhausted = cg->newBuilder("excpt");
+    auto builder_cont = cg->newBuilder("cont");
+
+    cg->llvmCreateCondBr(exhausted, builder_exhausted, builder_cont);
+
+    cg->pushBuilder(builder_exhausted);
+    cg->llvmRaiseException("Hilti::IOSrcExhausted", i->location());
+    cg->llvmCreateBr(builder_cont);
+    cg->popBuilder();
+
+    cg->pushBuilder(builder_cont);
+    cg->llvmStore(i, result);
+}
+
+void StatementBuilder::visit(statement::instruction::ioSource::ReadBatch* i)
+{
+    cg()->llvmBlockingInstruction(i, _readBatchTry, _readBatchFinish);
+}
+
+void StatementBuilder::visit(statement::instruction::ioSource::FlowVid* i)
+{
+    CodeGen::expr_list args = {i->op1()};
+    auto result = cg()->llvmCall("hlt::iosrc_flow_vid", args);
+    cg()->llvmStore(i, result);
+}
+
 void StatementBuilder::visit(statement::instruction::iterIOSource::Begin* i)
 {
     cg()->llvmBlockingInstruction(i,
@@ -10,8 +10,8 @@
 using namespace hilti;
 using namespace codegen;
 
-// LLVM pass that replaces all calls to @hlt.globals.base.<Module> with code
-// computing base address for the module's globals.
+// LLVM pass that replaces all calls to @hlt.global.access(<name>) with code
+// computing the address of the named global.
 class GlobalsPass : public llvm::BasicBlockPass {
 public:
     GlobalsPass(llvm::LLVMContext& ctx, ast::Logger* logger)
@@ -96,13 +96,29 @@ bool GlobalsPass::runOnBasicBlock(llvm::BasicBlock& bb)
     std::list<std::tuple<llvm::Instruction*, std::string>> replace;
 
     for ( auto ins = bb.begin(); ins != bb.end(); ++ins ) {
-        auto md = ins->getMetadata("global-access");
+        auto call = llvm::dyn_cast<llvm::CallInst>(&(*ins));
 
-        if ( ! md )
+        if ( ! call )
+            continue;
+
+        auto callee = call->getCalledValue()->stripPointerCasts();
+
+        if ( callee->getName() != symbols::FuncGlobalAccess )
             continue;
 
-        auto name = codegen::util::llvmMetadataAsString(md->getOperand(0));
-        replace.push_back(std::make_tuple(&(*ins), name));
+        // The argument is a pointer to a constant string with the global's
+        // name.
+        auto gv = llvm::dyn_cast<llvm::GlobalVariable>(call->getArgOperand(0)->stripPointerCasts());
+        auto name = gv && gv->hasInitializer() ?
+                        llvm::dyn_cast<llvm::ConstantDataSequential>(gv->getInitializer()) :
+                        nullptr;
+
+        if ( ! (name && name->isCString()) ) {
+            logger->internalError("unexpected argument in access to global");
+            continue;
+        }
+
+        replace.push_back(std::make_tuple(&(*ins), name->getAsCString().str()));
     }
 
     if ( ! replace.size() )
@@ -274,21 +290,22 @@ std::unique_ptr<llvm::Module> Linker::link(string output,
         // The LLVM linker doesn't seem to pay attention to weak symbols: if
         // there's a weak function in a library it will overwrite any
         // function of the same name we already have, even if that has normal
-        // linkage. So remove weak functions manually here.
-        std::list<llvm::Function*> to_remove;
-
+        // linkage. So turn weak functions into declarations manually here,
+        // which then link against what we have. (Just removing them would
+        // leave the library's callers referencing the detached function.)
         for ( auto& f : (*m)->functions() ) {
-            if ( f.hasWeakLinkage() && composite->getFunction(f.getName()) ) {
-                to_remove.push_back(&f);
-            }
+            if ( f.hasWeakLinkage() && composite->getFunction(f.getName()) )
+                f.deleteBody();
         }
 
-        for ( auto f : to_remove )
-            f->removeFromParent();
-
         linkInModule(&linker, std::move(*m));
     }
 
+    // Link in the inlinable parts of runtime libraries.
+
+    for ( auto i : _inline_bcs )
+        linkInModule(&linker, loadRuntimeInlines(i));
+
     // Link native library.
 
     for ( auto i : _natives )
@@ -306,6 +323,140 @@ std::unique_ptr<llvm::Module> Linker::link(string output,
     return composite;
 }
 
+// Runtime functions that loadRuntimeInlines() pulls in for inlining. A
+// trailing '*' matches all functions with that prefix.
+static const char* RuntimeInlines[] = {"__hlt_object_ref",
+                                       "__hlt_object_unref",
+                                       "__hlt_iterator_bytes_*",
+                                       "hlt_iterator_bytes_*",
+                                       "__hlt_exception_match",
+                                       "hlt_exception_is_yield",
+                                       "hlt_exception_is_termination",
+                                       nullptr};
+
+static bool isRuntimeInline(llvm::StringRef name)
+{
+    for ( auto p = RuntimeInlines; *p; ++p ) {
+        llvm::StringRef pattern(*p);
+
+        if ( pattern.endswith("*") ? name.startswith(pattern.drop_back()) : name == pattern )
+            return true;
+    }
+
+    return false;
+}
+
+// Collects all global values that a constant refers to.
+static void collectReferences(const llvm::Constant* c, std::set<const llvm::GlobalValue*>* refs)
+{
+    if ( auto gv = llvm::dyn_cast<llvm::GlobalValue>(c) ) {
+        refs->insert(gv);
+        return;
+    }
+
+    for ( auto& op : c->operands() ) {
+        if ( auto oc = llvm::dyn_cast<llvm::Constant>(op) )
+            collectReferences(oc, refs);
+    }
+}
+
+std::unique_ptr<llvm::Module> Linker::loadRuntimeInlines(const string& path)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path.c_str());
+
+    if ( ! buffer )
+        fatalError("reading bitcode failed", path);
+
+    // Load lazily so that we parse only the bodies we need.
+    auto m = llvm::getLazyBitcodeModule(std::move(*buffer), llvmContext());
+
+    if ( ! m )
+        fatalError("parsing bitcode failed", path, m.getError().message());
+
+    auto module = std::move(*m);
+
+    // For each candidate, determine everything we need to copy along with
+    // it. Internal functions and constants can be copied over, but if it
+    // refers to internal state, we leave the candidate to the native
+    // library.
+    std::set<const llvm::GlobalValue*> keep;
+    std::list<llvm::Function*> roots;
+
+    for ( auto& f : module->functions() ) {
+        if ( ! isRuntimeInline(f.getName()) || f.isDeclaration() || ! f.hasExternalLinkage() )
+            continue;
+
+        std::set<const llvm::GlobalValue*> closure;
+        std::list<llvm::GlobalValue*> todo = {&f};
+        bool ok = true;
+
+        while ( ok && todo.size() ) {
+            auto gv = todo.front();
+            todo.pop_front();
+
+            if ( ! closure.insert(gv).second )
+                continue;
+
+            std::set<const llvm::GlobalValue*> refs;
+
+            if ( auto func = llvm::dyn_cast<llvm::Function>(gv) ) {
+                if ( auto ec = func->materialize() )
+                    fatalError("loading function failed", path, ec.message());
+
+                for ( auto& b : *func ) {
+                    for ( auto& i : b ) {
+                        for ( auto& op : i.operands() ) {
+                            if ( auto c = llvm::dyn_cast<llvm::Constant>(op) )
+                                collectReferences(c, &refs);
+                        }
+                    }
+                }
+            }
+
+            else if ( auto var = llvm::dyn_cast<llvm::GlobalVariable>(gv) ) {
+                if ( var->hasInitializer() )
+                    collectReferences(var->getInitializer(), &refs);
+            }
+
+            for ( auto r : refs ) {
+                if ( ! r->hasLocalLinkage() )
+                    continue;
+
+                auto var = llvm::dyn_cast<llvm::GlobalVariable>(r);
+
+                if ( llvm::isa<llvm::GlobalAlias>(r) || (var && ! var->isConstant()) ) {
+                    ok = false;
+                    break;
+                }
+
+                todo.push_back(const_cast<llvm::GlobalValue*>(r));
+            }
+        }
+
+        if ( ! ok ) {
+            debug(1, ::util::fmt("not inlining runtime function %s", f.getName().str()));
+            continue;
+        }
+
+        debug(1, ::util::fmt("inlining runtime function %s", f.getName().str()));
+        keep.insert(closure.begin(), closure.end());
+        roots.push_back(&f);
+    }
+
+    llvm::ValueToValueMapTy vmap;
+    auto inlines = llvm::CloneModule(module.get(), vmap, [&](const llvm::GlobalValue* gv) {
+        return keep.find(gv) != keep.end();
+    });
+
+    for ( auto f : roots )
+        llvm::cast<llvm::Function>(vmap[f])->setLinkage(
+            llvm::GlobalValue::AvailableExternallyLinkage);
+
+    llvm::StripDebugInfo(*inlines);
+
+    return inlines;
+}
+
 bool Linker::isHiltiModule(llvm::Module* module)
 {
     string id = CodeGen::llvmGetModuleIdentifier(module);
@@ -335,12 +486,12 @@ void Linker::joinFunctions(llvm::Module* dst, const char* new_func, const char*
         return;
 
     // If a function under that name already exists with weak linkage,
-    // replace it.
+    // replace it. We release its name here and delete it once all uses
+    // refer to the new function.
     auto old_func = dst->getFunction(new_func);
 
-    if ( old_func ) {
-        old_func->removeFromParent();
-    }
+    if ( old_func )
+        old_func->setName("");
 
     for ( int i = 0; i < md->getNumOperands(); ++i ) {
         auto op = md->getOperand(i);
@@ -377,6 +528,9 @@ void Linker::joinFunctions(llvm::Module* dst, const char* new_func, const char*
 
     assert(builder);
     builder->CreateRetVoid();
+
+    if ( old_func )
+        old_func->eraseFromParent();
 }
 
 struct HookImpl {
@@ -413,8 +567,21 @@ void Linker::makeHooks(llvm::Module* module, const std::list<string>& module_nam
     auto decls = codegen::util::llvmGetGlobalMetadata(module, symbols::MetaHookDecls);
     auto impls = codegen::util::llvmGetGlobalMetadata(module, symbols::MetaHookImpls);
 
+    // Determine which hook groups the program may disable. Implementations
+    // in any other group can skip checking whether their group is enabled.
+    // We do that only when optimizing, as it's the optimizer that then
+    // removes the checks.
+    std::set<int64_t> disabled;
+    bool all_checked = true;
+
+    if ( options().optimize && options().optimizing("hookgroups") )
+        all_checked = collectHookGroupsDisabled(module, &disabled);
+
+    defineHookGroupsChecked(module, disabled, all_checked);
+
     if ( ! decls ) {
         debug(1, "no hooks declared in any module");
+        defineHooksImplemented(module, std::set<string>());
         return;
     }
 
@@ -483,6 +650,17 @@ void Linker::makeHooks(llvm::Module* module, const std::list<string>& module_nam
 
     _debugDumpHooks(this, hooks);
 
+    // Tell the generated code which hooks have implementations, so that the
+    // optimizer can remove anything guarded by an empty one.
+    std::set<string> implemented;
+
+    for ( auto h : hooks ) {
+        if ( h.second.impls.size() )
+            implemented.insert(h.second.func->getName().str());
+    }
+
+    defineHooksImplemented(module, implemented);
+
     // Finally, we can build the functions that call the hook implementations.
 
     auto true_ = llvm::ConstantInt::get(llvm::Type::getIntNTy(llvmContext(), 1), 1);
@@ -528,6 +706,93 @@ void Linker::makeHooks(llvm::Module* module, const std::list<string>& module_nam
         next->CreateRet(false_);
         stopped->CreateRet(true_);
         func->getBasicBlockList().push_back(stopped->GetInsertBlock());
+
+        // If there's just a single implementation that doesn't need to
+        // check its group, suggest to the optimizer to call it directly
+        // from the sites running the hook. We leave the final decision to
+        // the inliner's cost model, as hooks may run from many places.
+        if ( decl.impls.size() == 1 && ! all_checked &&
+             disabled.find(decl.impls.front().group) == disabled.end() ) {
+            func->addFnAttr(llvm::Attribute::InlineHint);
+            llvm::cast<llvm::Function>(decl.impls.front().func)
+                ->addFnAttr(llvm::Attribute::InlineHint);
+        }
+    }
+}
+
+bool Linker::collectHookGroupsDisabled(llvm::Module* module, std::set<int64_t>* disabled)
+{
+    auto md = codegen::util::llvmGetGlobalMetadata(module, symbols::MetaHookGroupsDisabled);
+
+    if ( ! md )
+        return false;
+
+    for ( int i = 0; i < md->getNumOperands(); ++i ) {
+        auto entry = codegen::util::llvmMetadataAsTuple(md->getOperand(i));
+        auto group = llvm::cast<llvm::ConstantInt>(
+                         codegen::util::llvmMetadataAsValue(entry->getOperand(0)))
+                         ->getSExtValue();
+
+        if ( group < 0 ) {
+            // Not known at compile time, could be any.
+            debug(1, "program may disable any hook group");
+            return true;
+        }
+
+        disabled->insert(group);
+    }
+
+    return false;
+}
+
+void Linker::defineHookGroupsChecked(llvm::Module* module, const std::set<int64_t>& disabled,
+                                     bool all)
+{
+    string prefix = symbols::PrefixHookGroupChecked;
+
+    for ( auto& g : module->globals() ) {
+        if ( ! g.isDeclaration() )
+            continue;
+
+        auto name = g.getName().str();
+
+        if ( ! ::util::startsWith(name, prefix) )
+            continue;
+
+        int64_t group = std::stoll(name.substr(prefix.size()));
+        bool checked = (all || disabled.find(group) != disabled.end());
+
+        debug(1, ::util::fmt("hook group %" PRId64 " is %schecked at run-time", group,
+                             checked ? "" : "not "));
+
+        g.setInitializer(llvm::ConstantInt::get(llvm::Type::getInt1Ty(llvmContext()), checked));
+        g.setConstant(true);
+        g.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+}
+
+void Linker::defineHooksImplemented(llvm::Module* module, const std::set<string>& implemented)
+{
+    string suffix = symbols::SuffixHookImplemented;
+
+    for ( auto& g : module->globals() ) {
+        if ( ! g.isDeclaration() )
+            continue;
+
+        auto name = g.getName().str();
+
+        if ( ! ::util::endsWith(name, suffix) )
+            continue;
+
+        auto func = name.substr(0, name.size() - suffix.size());
+        bool have_impls = (implemented.find(func) != implemented.end());
+
+        debug(1, ::util::fmt("hook function %s has %simplementations", func.c_str(),
+                             have_impls ? "" : "no "));
+
+        g.setInitializer(llvm::ConstantInt::get(llvm::Type::getInt1Ty(llvmContext()), have_impls));
+        g.setConstant(true);
+        g.setLinkage(llvm::GlobalValue::InternalLinkage);
     }
 }
 
@@ -584,9 +849,8 @@ void Linker::addGlobalsInfo(llvm::Module* module, const std::list<string>& modul
     // it.
     auto old_func = module->getFunction(symbols::FunctionGlobalsSize);
 
-    if ( old_func ) {
-        old_func->removeFromParent();
-    }
+    if ( old_func )
+        old_func->setName("");
 
     auto gftype = llvm::FunctionType::get(llvm::Type::getIntNTy(llvmContext(), 64), false);
     auto gfunc = llvm::Function::Create(gftype, llvm::Function::ExternalLinkage,
@@ -596,8 +860,10 @@ void Linker::addGlobalsInfo(llvm::Module* module, const std::list<string>& modul
                                              llvm::BasicBlock::Create(llvmContext(), "", gfunc));
     builder->CreateRet(size);
 
-    if ( old_func )
+    if ( old_func ) {
         old_func->replaceAllUsesWith(gfunc);
+        old_func->eraseFromParent();
+    }
 
     // Create a map of all global IDs to the GEP index inside their
     // individual global structs.
@@ -644,6 +910,11 @@ void Linker::addGlobalsInfo(llvm::Module* module, const std::list<string>& modul
     llvm::legacy::PassManager mgr;
     mgr.add(pass);
     mgr.run(*module);
+
+    if ( auto access = module->getFunction(symbols::FuncGlobalAccess) ) {
+        if ( access->use_empty() )
+            access->eraseFromParent();
+    }
 }
 
 void hilti::codegen::Linker::linkInModule(llvm::Linker* linker,
@@ -57,6 +57,19 @@ public:
         _bcs.push_back(path);
     }
 
+    /// Adds the runtime library's bitcode file for linking against a
+    /// natively compiled version of the library. Rather than linking in
+    /// everything, link() then pulls in just a small set of frequently used
+    /// functions as \c available_externally, so that they remain available
+    /// for inlining. All other references resolve against the native
+    /// library at runtime.
+    ///
+    /// path: The full path to the runtime's ``*.bc`` file.
+    void addRuntimeInlines(const string& path)
+    {
+        _inline_bcs.push_back(path);
+    }
+
     /// Links a set of compiled HILTI modules together.
     ///
     /// output: The name of the output module.
@@ -82,7 +95,12 @@ private:
                        llvm::FunctionType* default_ftype, const std::list<string>& module_names,
                        llvm::Module* module);
     void makeHooks(llvm::Module* module, const std::list<string>& module_names);
+    void defineHooksImplemented(llvm::Module* module, const std::set<string>& implemented);
+    bool collectHookGroupsDisabled(llvm::Module* module, std::set<int64_t>* disabled);
+    void defineHookGroupsChecked(llvm::Module* module, const std::set<int64_t>& disabled,
+                                 bool all);
     void fatalError(const string& where, const string& file = "", const string& error = "");
+    std::unique_ptr<llvm::Module> loadRuntimeInlines(const string& path);
 
     // These following three abort directly on error.
     void linkInModule(llvm::Linker* linker, std::unique_ptr<llvm::Module> module);
@@ -93,6 +111,7 @@ private:
     path_list _paths;
     path_list _natives;
     path_list _bcs;
+    path_list _inline_bcs;
 };
 }
 }
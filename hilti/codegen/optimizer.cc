@@ -9,6 +9,65 @@
 using namespace hilti;
 using namespace codegen;
 
+// Runtime functions that _specializeTypeInfo() creates specialized
+// versions of. A trailing '*' matches all functions with that prefix.
+static const char* TypeInfoSpecializable[] = {"hlt_map_*", "hlt_set_*", "hlt_list_*",
+                                              "hlt_vector_*", nullptr};
+
+static bool isTypeInfoSpecializable(llvm::StringRef name)
+{
+    for ( auto p = TypeInfoSpecializable; *p; ++p ) {
+        llvm::StringRef pattern(*p);
+
+        if ( pattern.endswith("*") ? name.startswith(pattern.drop_back()) : name == pattern )
+            return true;
+    }
+
+    return false;
+}
+
+// Returns true if a type is a pointer to the type information struct. The
+// runtime library and the generated code use different names for it.
+static bool isTypeInfoPtr(llvm::Type* type)
+{
+    auto ptype = llvm::dyn_cast<llvm::PointerType>(type);
+
+    if ( ! ptype )
+        return false;
+
+    auto stype = llvm::dyn_cast<llvm::StructType>(ptype->getElementType());
+
+    if ( ! (stype && stype->hasName()) )
+        return false;
+
+    return stype->getName().startswith("hlt.type_info") ||
+           stype->getName().startswith("struct.__hlt_type_info");
+}
+
+// Returns true if a value of one type can be passed where the other one is
+// expected by just casting the pointer.
+static bool castable(llvm::Type* from, llvm::Type* to)
+{
+    return from == to || (from->isPointerTy() && to->isPointerTy());
+}
+
+// If a value refers to a type information object whose content is known at
+// link time, returns it. Otherwise returns null.
+static llvm::Constant* constantTypeInfo(llvm::Value* v)
+{
+    auto c = llvm::dyn_cast<llvm::Constant>(v);
+
+    if ( ! c )
+        return nullptr;
+
+    auto gv = llvm::dyn_cast<llvm::GlobalVariable>(c->stripPointerCasts());
+
+    if ( ! (gv && gv->isConstant() && gv->hasDefinitiveInitializer()) )
+        return nullptr;
+
+    return c;
+}
+
 Optimizer::Optimizer(CompilerContext* ctx) : ast::Logger("codegen::Optimizer")
 {
     llvm::InitializeNativeTarget();
@@ -28,42 +87,6 @@ const Options& Optimizer::options() const
 std::unique_ptr<llvm::Module> Optimizer::optimize(std::unique_ptr<llvm::Module> module,
                                                   bool is_linked)
 {
-#if 0
-    std::error_code lerr;
-    llvm::raw_fd_ostream out(std::string("optmodule.bc"), lerr, llvm::sys::fs::F_None);
-    llvm::WriteBitcodeToFile(module.get(), out);
-    out.close();
-#endif
-
-#if 0
-    llvm::LLVMContext nctx;
-
-    auto b = llvm::MemoryBuffer::getFile("optmodule.bc");
-    auto m = llvm::parseBitcodeFile((*b)->getMemBufferRef(), module->getContext());
-#endif
-
-    // TODO: There's some problem with LLVM mixing up debug symbols between
-    // the originating modules if we just go ahead here and optmize the
-    // module that was passed in:
-    //
-    // Global is referenced in a different module!
-    // void (metadata, metadata, metadata)* @llvm.dbg.declare
-    // ; ModuleID = '<JIT code>'
-    // call void @llvm.dbg.declare(metadata i8** %2, metadata <0x5506300>, metadata !6081), !dbg
-    // <0x5501ee8>
-    // void (i8*)* @__hlt_globals_dtor
-    //
-    // [plus a couple more of these]
-    //
-    // To work around that until understood/fixed, we clone the module
-    // through serialization, which then doesn't show the problem anymore.
-    llvm::SmallVector<char, 128> buffer;
-    llvm::raw_svector_ostream os(buffer);
-    llvm::WriteBitcodeToFile(module.get(), os);
-    auto mb = std::make_unique<llvm::ObjectMemoryBuffer>(std::move(buffer));
-    auto nmodule = llvm::parseBitcodeFile((*mb).getMemBufferRef(), module->getContext());
-
-#if 1
     // Logic borrowed heavily from opt.
 
     llvm::PassRegistry& registry = *llvm::PassRegistry::getPassRegistry();
@@ -113,7 +136,7 @@ std::unique_ptr<llvm::Module> Optimizer::optimize(std::unique_ptr<llvm::Module>
             cpu_features.AddFeature(f.first(), f.second);
     }
 
-    llvm::Triple triple((*nmodule)->getTargetTriple());
+    llvm::Triple triple(module->getTargetTriple());
     llvm::TargetOptions topts; // Believe they are all fine with their defaults.
     auto target = llvm::TargetRegistry::lookupTarget(triple.getTriple(), err);
 
@@ -146,38 +169,219 @@ std::unique_ptr<llvm::Module> Optimizer::optimize(std::unique_ptr<llvm::Module>
                          });
 
     std::unique_ptr<llvm::legacy::FunctionPassManager> fpasses;
-    fpasses.reset(new llvm::legacy::FunctionPassManager(&**nmodule));
+    fpasses.reset(new llvm::legacy::FunctionPassManager(module.get()));
     fpasses->add(llvm::createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
 
-    llvm::legacy::PassManager passes;
-    passes.add(llvm::createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
-    passes.add(llvm::createVerifierPass());
-
     builder.populateFunctionPassManager(*fpasses);
-    builder.populateLTOPassManager(passes);
-    builder.populateModulePassManager(passes);
+
+    if ( ! is_linked ) {
+        // Before linking, we simplify each function on its own. We leave
+        // anything crossing function boundaries to the post-link pass, as
+        // the linker still needs to see all the module's functions and
+        // meta data. Doing this per module means that the work can happen
+        // in parallel and gets cached along with the module.
+        fpasses->add(llvm::createInstructionCombiningPass());
+        fpasses->add(llvm::createCFGSimplificationPass());
+        fpasses->add(llvm::createReassociatePass());
+        fpasses->add(llvm::createGVNPass());
+        fpasses->add(llvm::createDeadStoreEliminationPass());
+        fpasses->add(llvm::createInstructionCombiningPass());
+        fpasses->add(llvm::createCFGSimplificationPass());
+    }
 
     // Run function passes.
     fpasses->doInitialization();
 
-    for ( llvm::Function& f : *nmodule.get() )
+    for ( llvm::Function& f : *module )
         fpasses->run(f);
 
     fpasses->doFinalization();
 
+    if ( ! is_linked )
+        return module;
+
+    if ( options().optimizing("typeinfo") )
+        _specializeTypeInfo(module.get());
+
+    // After linking, we do the cross-module work: inlining and
+    // interprocedural optimization across everything that's linked in.
+    llvm::legacy::PassManager passes;
+    passes.add(llvm::createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
+    passes.add(llvm::createVerifierPass());
+
+    builder.populateLTOPassManager(passes);
+
 #if 0
     llvm::AssemblyAnnotationWriter annotator;
     llvm::raw_os_ostream llvm_out(std::cerr);
-    nmodule->print(llvm_out, &annotator);
+    module->print(llvm_out, &annotator);
 #endif
 
     // Check that the module is well-formed on completion of optimization.
     passes.add(llvm::createVerifierPass());
 
-    // Run module passes.
-    if ( passes.run(**nmodule) )
-        return std::move(nmodule.get());
-    else
-        return nullptr;
-#endif
+    // Run module passes. Note that the return value only tells us whether
+    // anything changed; the verifier aborts on errors.
+    passes.run(*module);
+
+    return module;
+}
+
+void Optimizer::_specializeTypeInfo(llvm::Module* module)
+{
+    typedef std::pair<llvm::Function*, std::vector<llvm::Constant*>> Specialization;
+    std::map<Specialization, llvm::Function*> specialized;
+    std::list<std::pair<llvm::CallInst*, Specialization>> calls;
+
+    for ( auto& f : *module ) {
+        for ( auto& bb : f ) {
+            for ( auto& i : bb ) {
+                auto call = llvm::dyn_cast<llvm::CallInst>(&i);
+
+                if ( ! call )
+                    continue;
+
+                auto callee =
+                    llvm::dyn_cast<llvm::Function>(call->getCalledValue()->stripPointerCasts());
+
+                if ( ! callee || callee->isDeclaration() || callee->isVarArg() ||
+                     ! isTypeInfoSpecializable(callee->getName()) )
+                    continue;
+
+                // Generated code declares the runtime functions with its own
+                // types, so its calls generally go through a cast of the
+                // function. We can replicate that as long as the types
+                // differ only in what pointers point to.
+                if ( call->getNumArgOperands() != callee->arg_size() ||
+                     ! castable(call->getType(), callee->getReturnType()) )
+                    continue;
+
+                std::vector<llvm::Constant*> consts;
+                bool found = false;
+                bool ok = true;
+
+                for ( auto& arg : callee->args() ) {
+                    // We remove the bound arguments, which we can't do
+                    // where the ABI attaches semantics to them.
+                    if ( arg.hasByValAttr() || arg.hasStructRetAttr() || arg.hasInAllocaAttr() )
+                        ok = false;
+
+                    auto op = call->getArgOperand(arg.getArgNo());
+
+                    if ( ! castable(op->getType(), arg.getType()) )
+                        ok = false;
+
+                    llvm::Constant* c = nullptr;
+
+                    if ( isTypeInfoPtr(arg.getType()) ) {
+                        if ( (c = constantTypeInfo(op)) )
+                            c = llvm::ConstantExpr::getPointerCast(c, arg.getType());
+                    }
+
+                    consts.push_back(c);
+                    found = (found || c);
+                }
+
+                if ( found && ok )
+                    calls.push_back(std::make_pair(call, Specialization(callee, consts)));
+            }
+        }
+    }
+
+    for ( auto c : calls ) {
+        auto call = c.first;
+        auto callee = c.second.first;
+        auto& consts = c.second.second;
+
+        auto i = specialized.find(c.second);
+        llvm::Function* func = nullptr;
+
+        if ( i != specialized.end() )
+            func = i->second;
+
+        else {
+            // Clone the function with the type information bound to the
+            // constant. The optimizer then resolves the function pointers
+            // that the runtime loads from it, and can inline the targets.
+            llvm::ValueToValueMapTy vmap;
+
+            for ( auto& arg : callee->args() ) {
+                if ( auto ti = consts[arg.getArgNo()] )
+                    vmap[&arg] = ti;
+            }
+
+            func = llvm::CloneFunction(callee, vmap);
+            func->setName(callee->getName() + ".ti");
+            func->setLinkage(llvm::GlobalValue::InternalLinkage);
+            func->setVisibility(llvm::GlobalValue::DefaultVisibility);
+            specialized.insert(std::make_pair(c.second, func));
+
+            if ( options().cgDebugging("optimizer") ) {
+                std::list<string> types;
+
+                for ( auto ti : consts ) {
+                    if ( ti )
+                        types.push_back(ti->stripPointerCasts()->getName().str());
+                }
+
+                std::cerr << ::util::fmt("Optimizer: specialized %s as %s for %s",
+                                         callee->getName().str(), func->getName().str(),
+                                         ::util::strjoin(types, ", "))
+                          << std::endl;
+            }
+        }
+
+        if ( options().cgDebugging("optimizer") )
+            std::cerr << ::util::fmt("Optimizer: redirected call in %s to %s",
+                                     call->getParent()->getParent()->getName().str(),
+                                     func->getName().str())
+                      << std::endl;
+
+        auto& ctx = module->getContext();
+        auto attrs = call->getAttributes();
+        llvm::AttributeSet nattrs;
+        nattrs = nattrs.addAttributes(ctx, llvm::AttributeSet::ReturnIndex,
+                                      attrs.getRetAttributes());
+        nattrs = nattrs.addAttributes(ctx, llvm::AttributeSet::FunctionIndex,
+                                      attrs.getFnAttributes());
+
+        std::vector<llvm::Value*> args;
+        auto param = func->arg_begin();
+
+        for ( unsigned int j = 0; j < call->getNumArgOperands(); j++ ) {
+            if ( consts[j] )
+                continue;
+
+            auto op = call->getArgOperand(j);
+
+            if ( op->getType() != param->getType() )
+                op = llvm::CastInst::CreatePointerCast(op, param->getType(), "", call);
+
+            // Keep attributes such as zeroext/signext, at the argument's
+            // new position.
+            llvm::AttrBuilder pattrs(attrs, j + 1);
+
+            if ( pattrs.hasAttributes() )
+                nattrs = nattrs.addAttributes(ctx, args.size() + 1,
+                                              llvm::AttributeSet::get(ctx, args.size() + 1,
+                                                                      pattrs));
+
+            args.push_back(op);
+            ++param;
+        }
+
+        auto ncall = llvm::CallInst::Create(func, args, "", call);
+        ncall->setCallingConv(call->getCallingConv());
+        ncall->setAttributes(nattrs);
+        ncall->setDebugLoc(call->getDebugLoc());
+
+        llvm::Value* result = ncall;
+
+        if ( call->getType() != ncall->getType() )
+            result = llvm::CastInst::CreatePointerCast(ncall, call->getType(), "", call);
+
+        result->takeName(call);
+        call->replaceAllUsesWith(result);
+        call->eraseFromParent();
+    }
 }
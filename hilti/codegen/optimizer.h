@@ -27,17 +27,29 @@ public:
     /// convienience method that just forwards to the current context.
     const Options& options() const;
 
-    /// Optimizes an LLVM module according to the CompilerContext's options.
+    /// Optimizes an LLVM module in place according to the CompilerContext's
+    /// options.
     ///
     /// module: The module to optimize.
     ///
     /// is_linked: True if this is the final linked module, false if it's
-    /// an individual module that will later be linked.
+    /// an individual module that will later be linked. The latter gets
+    /// only function-local optimizations, leaving everything the linker
+    /// needs in place.
     ///
-    /// Returns: A new, optmized module, or null on error.
+    /// Returns: The optimized module, or null on error.
     std::unique_ptr<llvm::Module> optimize(std::unique_ptr<llvm::Module> module, bool is_linked);
 
 private:
+    // Specializes calls to the runtime's container functions for the type
+    // information passed in. If a call passes a constant hlt_type_info, we
+    // redirect it to a copy of the function with that argument bound. That
+    // allows the subsequent passes to turn the indirect calls through the
+    // type's function pointers (e.g., for hashing and comparing keys) into
+    // direct ones that can then be inlined. Calls with types not known at
+    // link time continue to go to the generic version.
+    void _specializeTypeInfo(llvm::Module* module);
+
     CompilerContext* _ctx;
 };
 }
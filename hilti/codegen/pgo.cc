@@ -0,0 +1,45 @@
+
+#include <fstream>
+
+#include <util/util.h>
+
+#include "pgo.h"
+
+using namespace hilti;
+using namespace codegen;
+
+bool PGOProfile::load(const string& path)
+{
+    std::ifstream in(path);
+
+    if ( ! in.is_open() )
+        return false;
+
+    string key;
+    uint64_t count;
+
+    while ( in >> key >> count ) {
+        auto sum = (_counts[key] += count);
+
+        if ( ::util::startsWith(key, "entry/") && sum > _max_entry )
+            _max_entry = sum;
+    }
+
+    return in.eof();
+}
+
+bool PGOProfile::lookup(const string& key, uint64_t* count) const
+{
+    auto i = _counts.find(key);
+
+    if ( i == _counts.end() )
+        return false;
+
+    *count = i->second;
+    return true;
+}
+
+uint64_t PGOProfile::hotThreshold() const
+{
+    return std::max(_max_entry / 100, static_cast<uint64_t>(1));
+}
@@ -0,0 +1,50 @@
+
+#ifndef HILTI_CODEGEN_PGO_H
+#define HILTI_CODEGEN_PGO_H
+
+#include <map>
+
+#include "common.h"
+
+namespace hilti {
+namespace codegen {
+
+/// A profile for profile-guided optimization, as recorded by code compiled
+/// with Options::pgo_generate. The runtime appends one line "<key> <count>"
+/// per counter to the profile file when it terminates. Keys are of the form
+/// \c entry/<module>/<function> for the number of times a function was
+/// called, and \c edge/<module>/<function>/<branch>/<successor> for the
+/// number of times a branch went to one of its successors.
+class PGOProfile {
+public:
+    /// Reads a profile from disk. If a key appears multiple times, the
+    /// counts are added up so that a file accumulates multiple training
+    /// runs.
+    ///
+    /// path: The file to read.
+    ///
+    /// Returns: True if successful.
+    bool load(const string& path);
+
+    /// Looks up a counter.
+    ///
+    /// key: The counter's key.
+    ///
+    /// count: Set to the count if found.
+    ///
+    /// Returns: True if the profile has the counter.
+    bool lookup(const string& key, uint64_t* count) const;
+
+    /// Returns the entry count from which on we consider a function hot.
+    /// That's currently one percent of the largest entry count in the
+    /// profile.
+    uint64_t hotThreshold() const;
+
+private:
+    std::map<string, uint64_t> _counts;
+    uint64_t _max_entry = 0;
+};
+}
+}
+
+#endif
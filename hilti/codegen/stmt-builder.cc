@@ -289,6 +289,8 @@ void StatementBuilder::visit(declaration::Function* f)
 
     cg()->setLeaveFunc(f);
 
+    cg()->llvmPGOFunctionEntry();
+
     auto name =
         ::util::fmt("%s::%s", cg()->hiltiModule()->id()->name().c_str(), f->id()->name().c_str());
 
@@ -329,17 +331,25 @@ void StatementBuilder::visit(declaration::Function* f)
 
         cg()->pushBuilder(cont);
 
-        // Check whether the hook's group is enabled.
-        CodeGen::expr_list args{
-            builder::integer::create(ftype->attributes().getAsInt(attribute::GROUP, 0))};
-        auto cont2 = cg()->llvmCall("hlt::hook_group_is_enabled", args, false, false);
+        // Check whether the hook's group is enabled. The linker tells us if
+        // the program may ever disable it; if not, the optimizer removes the
+        // check.
+        auto group = ftype->attributes().getAsInt(attribute::GROUP, 0);
+        auto checked = builder()->CreateLoad(cg()->llvmHookGroupChecked(group));
 
         auto disabled = cg()->pushBuilder("disabled");
         cg()->llvmReturn(0, cg()->llvmConstInt(0, 1)); // Return false.
         cg()->popBuilder();
 
+        auto check = cg()->newBuilder("group-check");
         auto enabled = cg()->newBuilder("enabled");
+        cg()->llvmCreateCondBr(checked, check, enabled);
+
+        cg()->pushBuilder(check);
+        CodeGen::expr_list args{builder::integer::create(group)};
+        auto cont2 = cg()->llvmCall("hlt::hook_group_is_enabled", args, false, false);
         cg()->llvmCreateCondBr(cont2, enabled, disabled);
+        cg()->popBuilder();
 
         cg()->pushBuilder(enabled); // Leave on stack.
     }
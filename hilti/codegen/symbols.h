@@ -20,9 +20,11 @@ static const char* MetaGlobalsInit = "hlt.globals.init";
 static const char* MetaGlobalsDtor = "hlt.globals.dtor";
 static const char* MetaHookDecls = "hlt.hook.decls";
 static const char* MetaHookImpls = "hlt.hook.impls";
+static const char* MetaHookGroupsDisabled = "hlt.hook.groups.disabled";
 
 static const char* TypeGlobals = "hlt.globals.type";
 static const char* FuncGlobalsBase = "hlt.globals.base";
+static const char* FuncGlobalAccess = "hlt.global.access";
 
 // Indices of fields in MetaModule.
 static const int MetaModuleVersion = 0;
@@ -36,6 +38,15 @@ static const char* FunctionGlobalsDtor = "__hlt_globals_dtor";
 static const char* FunctionModulesInit = "__hlt_modules_init";
 static const char* FunctionGlobalsSize = "__hlt_globals_size";
 
+// Suffix appended to a hook's entry function to name the global telling
+// whether the hook has any implementations. Defined by the linker.
+static const char* SuffixHookImplemented = ".implemented";
+
+// Prefix prepended to a hook group's ID to name the global telling whether
+// the group's implementations need to check at run-time if it's enabled.
+// Defined by the linker.
+static const char* PrefixHookGroupChecked = "hlt.hook.group.checked.";
+
 // Names for argument added internally for our calling conventions.
 static const char* ArgExecutionContext = "__ctx";
 static const char* ArgException = "__excpt";
@@ -1,5 +1,13 @@
 
+#include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <util/util.h>
 
 // LLVM redefines the DEBUG macro. Sigh.
@@ -17,6 +25,7 @@
 
 #include "codegen/asm-annotater.h"
 #include "codegen/optimizer.h"
+#include "codegen/pgo.h"
 #include "hilti-intern.h"
 #include "hilti/autogen/hilti-config.h"
 #include "jit.h"
@@ -229,8 +238,9 @@ void CompilerContext::_endPass()
     auto cg_time = options().cgDebugging("time");
     auto cg_passes = options().cgDebugging("passes");
 
+    auto delta = util::currentTime() - pass.time;
+
     if ( cg_time || cg_passes ) {
-        auto delta = util::currentTime() - pass.time;
         auto indent = string(_passes.size(), ' ');
 
         if ( cg_passes || delta >= 0.1 )
@@ -239,9 +249,36 @@ void CompilerContext::_endPass()
                       << std::endl;
     }
 
+    if ( _passes.size() == 1 )
+        addPassTime("hilti::" + pass.name, delta);
+
     _passes.pop_back();
 }
 
+void CompilerContext::addPassTime(const string& name, double delta)
+{
+    for ( auto& t : _pass_times ) {
+        if ( t.first == name ) {
+            t.second += delta;
+            return;
+        }
+    }
+
+    _pass_times.push_back(std::make_pair(name, delta));
+}
+
+void CompilerContext::printPassTimes(std::ostream& out) const
+{
+    double total = 0;
+
+    for ( auto t : _pass_times ) {
+        out << util::fmt("(%2.2fs) %s", t.second, t.first) << std::endl;
+        total += t.second;
+    }
+
+    out << util::fmt("(%2.2fs) total", total) << std::endl;
+}
+
 bool CompilerContext::_finalizeModule(shared_ptr<Module> module, bool verify)
 {
     if ( options().cgDebugging("context") )
@@ -458,6 +495,18 @@ bool CompilerContext::_finalize(shared_ptr<Module> module, bool verify)
 
         _endPass();
 
+        // Record the imports for dependencies(). The scope builder has
+        // already made sure that we can find them all.
+        auto& imports = _imports[m.first];
+        imports.clear();
+
+        for ( auto i : module->importedIDs() ) {
+            auto path = searchModule(i);
+
+            if ( path.size() && path != m.first )
+                imports.insert(path);
+        }
+
         if ( options().cgDebugging("scopes") ) {
             _beginPass(module, scope_printer);
             scope_printer.run(module);
@@ -534,9 +583,7 @@ std::list<std::unique_ptr<llvm::Module>> CompilerContext::checkCache(
     const ::util::cache::FileCache::Key& key)
 {
     std::list<std::unique_ptr<llvm::Module>> outputs;
-    return outputs;
 
-#if 0
     if ( ! _cache )
         return outputs;
 
@@ -547,55 +594,49 @@ std::list<std::unique_ptr<llvm::Module>> CompilerContext::checkCache(
     for ( auto d : data ) {
         _beginPass(key.name, "LoadFromCache");
 
-        auto mb = llvm::MemoryBuffer::getMemBuffer(d);
-        assert(mb);
+        auto mb = llvm::MemoryBuffer::getMemBuffer(d, "", false);
+        auto mod = llvm::parseBitcodeFile(mb->getMemBufferRef(), llvmContext());
 
-        string err;
-        llvm::LLVMContext llvm_context;
+        _endPass();
 
-        if ( auto mod = llvm::parseBitcodeFile(mb->getMemBufferRef(), llvm_context) ) {
+        if ( ! mod ) {
             if ( options().cgDebugging("cache") )
-                std::cerr << util::fmt("Reusing cached module for %s.%s (%d/%d)", key.name,
-                                       key.scope, ++idx, data.size())
+                std::cerr << util::fmt("Cached module for %s.%s (%d/%d) did not load: %s",
+                                       key.name, key.scope, ++idx, data.size(),
+                                       mod.getError().message())
                           << std::endl;
 
-            _endPass();
-            outputs.push_back(mod->get());
+            // All or nothing.
+            outputs.clear();
+            break;
         }
-        else {
-            _endPass();
 
-            if ( options().cgDebugging("cache") )
-                std::cerr << util::fmt("Cached module for %s.%s (%d/%d) did not compile", key.name,
-                                       key.scope, ++idx, data.size())
-                          << std::endl;
-        }
+        if ( options().cgDebugging("cache") )
+            std::cerr << util::fmt("Reusing cached module for %s.%s (%d/%d)", key.name, key.scope,
+                                   ++idx, data.size())
+                      << std::endl;
+
+        outputs.push_back(std::move(*mod));
     }
 
     if ( options().cgDebugging("cache") && ! outputs.size() )
         std::cerr << util::fmt("No cached module for %s.%s", key.name, key.scope) << std::endl;
 
     return outputs;
-#endif
 }
 
 void CompilerContext::updateCache(const ::util::cache::FileCache::Key& key,
-                                  std::unique_ptr<llvm::Module> module)
+                                  const llvm::Module* module)
 {
-#if 0
-    return updateCache(key, {module});
-#endif
+    return updateCache(key, std::list<const llvm::Module*>{module});
 }
 
 void CompilerContext::updateCache(const ::util::cache::FileCache::Key& key,
-                                  std::list<std::unique_ptr<llvm::Module>> modules)
+                                  const std::list<const llvm::Module*>& modules)
 {
     if ( ! _cache )
         return;
 
-    return;
-
-#if 0
     std::list<string> outputs;
 
     for ( auto m : modules ) {
@@ -610,13 +651,60 @@ void CompilerContext::updateCache(const ::util::cache::FileCache::Key& key,
     }
 
     _cache->store(key, outputs);
-#endif
+}
+
+// Object code gets its own scope so that it can share keys with bitcode.
+static ::util::cache::FileCache::Key _objectKey(const ::util::cache::FileCache::Key& key)
+{
+    auto okey = key;
+    okey.scope += ".o";
+    return okey;
+}
+
+bool CompilerContext::checkObjectCache(const ::util::cache::FileCache::Key& key,
+                                       std::string* object_code)
+{
+    if ( ! _cache )
+        return false;
+
+    auto data = _cache->lookup(_objectKey(key));
+
+    if ( data.size() != 1 ) {
+        if ( options().cgDebugging("cache") )
+            std::cerr << util::fmt("No cached object code for %s.%s", key.name, key.scope)
+                      << std::endl;
+
+        return false;
+    }
+
+    if ( options().cgDebugging("cache") )
+        std::cerr << util::fmt("Reusing cached object code for %s.%s", key.name, key.scope)
+                  << std::endl;
+
+    *object_code = data.front();
+    return true;
+}
+
+void CompilerContext::updateObjectCache(const ::util::cache::FileCache::Key& key,
+                                        const std::string& object_code)
+{
+    if ( ! _cache )
+        return;
+
+    if ( options().cgDebugging("cache") )
+        std::cerr << util::fmt("Updating cached object code for %s.%s", key.name, key.scope)
+                  << std::endl;
+
+    _cache->store(_objectKey(key), object_code.data(), object_code.size());
 }
 
 void CompilerContext::toCacheKey(shared_ptr<Module> module, ::util::cache::FileCache::Key* key)
 {
-    if ( module->path() != "-" )
+    if ( module->path() != "-" ) {
+        std::ifstream in(module->path());
         key->files.insert(module->path());
+        key->hashes.insert(util::cache::hash(in));
+    }
 
     else {
         std::ostringstream s;
@@ -625,8 +713,13 @@ void CompilerContext::toCacheKey(shared_ptr<Module> module, ::util::cache::FileC
         key->hashes.insert(hash);
     }
 
-    for ( auto d : dependencies(module) )
+    for ( auto d : dependencies(module) ) {
+        std::ifstream in(d);
         key->files.insert(d);
+        key->hashes.insert(util::cache::hash(in));
+    }
+
+    toCacheKeyCompiler(key);
 }
 
 void CompilerContext::toCacheKey(const llvm::Module* module, ::util::cache::FileCache::Key* key)
@@ -635,17 +728,45 @@ void CompilerContext::toCacheKey(const llvm::Module* module, ::util::cache::File
     llvm::raw_string_ostream llvm_out(out);
     llvm::WriteBitcodeToFile(module, llvm_out);
 
-    // We take the size as hash. That's not ideal but (1) the output of
-    // neither bitcode nor assemly writer is stable, (2) writing the whole
-    // module is also pretty slow.
-    auto hash = util::cache::hash(llvm_out.str().size());
+    auto hash = util::cache::hash(llvm_out.str());
     key->hashes.insert(hash);
 }
 
+void CompilerContext::toCacheKeyCompiler(::util::cache::FileCache::Key* key)
+{
+    key->hashes.insert(util::cache::hash(configuration().version));
+    key->files.insert(configuration().runtime_library_bca);
+    key->files.insert(configuration().runtime_library_bca_dbg);
+    key->files.insert(configuration().runtime_library_so);
+    key->files.insert(configuration().runtime_library_so_dbg);
+}
+
 std::list<string> CompilerContext::dependencies(shared_ptr<Module> module)
 {
-    // TODO: Not implementated.
-    return std::list<string>();
+    std::set<string> deps;
+    std::list<string> todo;
+
+    for ( auto i : module->importedIDs() ) {
+        auto path = searchModule(i);
+
+        if ( path.size() )
+            todo.push_back(path);
+    }
+
+    while ( todo.size() ) {
+        auto path = todo.front();
+        todo.pop_front();
+
+        if ( path == module->path() || ! deps.insert(path).second )
+            continue;
+
+        auto i = _imports.find(path);
+
+        if ( i != _imports.end() )
+            todo.insert(todo.end(), i->second.begin(), i->second.end());
+    }
+
+    return std::list<string>(deps.begin(), deps.end());
 }
 
 std::string CompilerContext::llvmGetModuleIdentifier(llvm::Module* module)
@@ -653,6 +774,80 @@ std::string CompilerContext::llvmGetModuleIdentifier(llvm::Module* module)
     return codegen::CodeGen::llvmGetModuleIdentifier(module);
 }
 
+::util::cache::FileCache::Key CompilerContext::_compileKey(shared_ptr<Module> module)
+{
+    // We key the cache on the HILTI code itself, as generated modules
+    // carry the path of whatever they were generated from.
+    std::ostringstream s;
+    print(module, s);
+
+    ::util::cache::FileCache::Key key;
+    key.scope = "hlt";
+    key.name = module->id()->pathAsString();
+    key.hashes.insert(util::cache::hash(s.str()));
+
+    // The generated code also depends on the types, globals, and functions
+    // of the modules this one imports.
+    for ( auto d : dependencies(module) ) {
+        std::ifstream in(d);
+        key.files.insert(d);
+        key.hashes.insert(util::cache::hash(in));
+    }
+
+    options().toCacheKey(&key);
+    toCacheKeyCompiler(&key);
+    return key;
+}
+
+std::unique_ptr<llvm::Module> CompilerContext::_codegen(shared_ptr<Module> module,
+                                                        llvm::LLVMContext& llvm_context)
+{
+    codegen::CodeGen cg(this, module->compilerContext()->options().libdirs_hlt, &llvm_context);
+    auto llvm_module = cg.generateLLVM(module);
+
+    if ( ! llvm_module )
+        return nullptr;
+
+    // Pre-optimize before linking, which can happen in parallel.
+    return _optimize(std::move(llvm_module), false);
+}
+
+static bool _writeAll(int fd, const char* data, size_t len)
+{
+    while ( len ) {
+        auto n = write(fd, data, len);
+
+        if ( n < 0 ) {
+            if ( errno == EINTR )
+                continue;
+
+            return false;
+        }
+
+        data += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+// Returns true if we can tell that the process is running further threads,
+// in which case forking workers isn't safe.
+static bool _multiThreaded()
+{
+#ifdef __linux__
+    std::ifstream in("/proc/self/status");
+    string line;
+
+    while ( std::getline(in, line) ) {
+        if ( line.compare(0, 8, "Threads:") == 0 )
+            return atoi(line.c_str() + 8) > 1;
+    }
+#endif
+
+    return false;
+}
+
 std::unique_ptr<llvm::Module> CompilerContext::compile(shared_ptr<Module> module)
 {
     // module->dump(std::cerr);
@@ -661,30 +856,245 @@ std::unique_ptr<llvm::Module> CompilerContext::compile(shared_ptr<Module> module
         std::cerr << util::fmt("Compiling module %s ...", module->id()->pathAsString())
                   << std::endl;
 
+    ::util::cache::FileCache::Key key;
+
+    if ( _cache ) {
+        key = _compileKey(module);
+
+        auto cached = checkCache(key);
+
+        if ( cached.size() == 1 )
+            return std::move(cached.front());
+    }
+
     _beginPass(module, "CodeGen");
 
-    codegen::CodeGen cg(this, module->compilerContext()->options().libdirs_hlt);
-    auto compiled = cg.generateLLVM(module);
+    auto compiled = _codegen(module, llvmContext());
+
+    _endPass();
 
     if ( ! compiled )
         return nullptr;
 
-    _endPass();
-
-    // We don't optimize the module here. While that could potentially speed
-    // up the final optimization at link time (or not, unknown), it would
-    // also change the instructions the linker is looking for to replace.
-    // Hence we can optimize only after the linker is done with that.
-    //
-    // TODO: There might be ways to get the data stable, such as moving them
-    // into tiny functions and then having the linker replace the function
-    // instead. Not sure if it's worth it, even just doing the LTO passes an
-    // link-time (which we want there, not here, obviously), take most of the
-    // time.
+    if ( _cache )
+        updateCache(key, compiled.get());
 
     return compiled;
 }
 
+std::list<std::unique_ptr<llvm::Module>> CompilerContext::compile(
+    const std::list<shared_ptr<Module>>& modules)
+{
+    std::vector<shared_ptr<Module>> todo(modules.begin(), modules.end());
+    std::vector<std::unique_ptr<llvm::Module>> compiled(todo.size());
+    std::vector<::util::cache::FileCache::Key> keys(todo.size());
+    std::vector<size_t> pending;
+
+    // Cache lookups happen here in this process; only the code generation
+    // runs concurrently.
+    for ( size_t i = 0; i < todo.size(); ++i ) {
+        auto ctx = todo[i]->compilerContext();
+
+        if ( ctx->_cache ) {
+            keys[i] = ctx->_compileKey(todo[i]);
+
+            auto cached = ctx->checkCache(keys[i]);
+
+            if ( cached.size() == 1 ) {
+                compiled[i] = std::move(cached.front());
+                continue;
+            }
+        }
+
+        pending.push_back(i);
+    }
+
+    std::list<std::unique_ptr<llvm::Module>> result;
+
+    auto jobs = std::min(static_cast<size_t>(std::max(options().jobs, 1u)), pending.size());
+
+    if ( jobs > 1 && _multiThreaded() ) {
+        warning("process is running multiple threads, compiling modules sequentially");
+        jobs = 1;
+    }
+
+    if ( jobs <= 1 ) {
+        for ( auto i : pending ) {
+            auto ctx = todo[i]->compilerContext();
+
+            ctx->_beginPass(todo[i], "CodeGen");
+
+            compiled[i] = ctx->_codegen(todo[i], llvmContext());
+
+            ctx->_endPass();
+
+            if ( ! compiled[i] )
+                return result;
+        }
+    }
+
+    else {
+        // The AST isn't safe to share across threads (even code generation
+        // links new nodes into existing ones), so each worker is a forked
+        // process with its own copy of it, and a fresh LLVM context. It
+        // sends back bitcode, framed by module index and size.
+        std::vector<pid_t> pids;
+        std::vector<int> fds;
+        std::vector<string> output(jobs);
+
+        _beginPass(util::fmt("<%d modules, %d jobs>", (int)pending.size(), (int)jobs), "CodeGen");
+
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(nullptr);
+
+        for ( size_t w = 0; w < jobs; ++w ) {
+            int p[2];
+
+            if ( pipe(p) < 0 ) {
+                error(util::fmt("cannot create pipe: %s", strerror(errno)));
+                break;
+            }
+
+            auto pid = fork();
+
+            if ( pid < 0 ) {
+                error(util::fmt("cannot fork: %s", strerror(errno)));
+                close(p[0]);
+                close(p[1]);
+                break;
+            }
+
+            if ( pid == 0 ) {
+                close(p[0]);
+
+                llvm::LLVMContext llvm_context;
+
+                for ( size_t n = w; n < pending.size(); n += jobs ) {
+                    auto i = pending[n];
+                    auto module = todo[i]->compilerContext()->_codegen(todo[i], llvm_context);
+
+                    if ( ! module )
+                        _exit(1);
+
+                    std::ostringstream out;
+                    writeBitcode(module.get(), out);
+
+                    auto data = out.str();
+                    uint64_t hdr[2] = {(uint64_t)i, (uint64_t)data.size()};
+
+                    if ( ! _writeAll(p[1], (const char*)hdr, sizeof(hdr)) ||
+                         ! _writeAll(p[1], data.data(), data.size()) )
+                        _exit(1);
+                }
+
+                _exit(0);
+            }
+
+            close(p[1]);
+            pids.push_back(pid);
+            fds.push_back(p[0]);
+        }
+
+        // Drain all pipes concurrently so that no worker blocks on a full
+        // one.
+        std::vector<pollfd> pfds;
+
+        for ( auto fd : fds )
+            pfds.push_back({fd, POLLIN, 0});
+
+        size_t open = pfds.size();
+
+        while ( open ) {
+            if ( poll(pfds.data(), pfds.size(), -1) < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+
+                break;
+            }
+
+            for ( size_t w = 0; w < pfds.size(); ++w ) {
+                if ( pfds[w].fd < 0 || ! pfds[w].revents )
+                    continue;
+
+                char buffer[65536];
+                auto n = read(pfds[w].fd, buffer, sizeof(buffer));
+
+                if ( n < 0 && errno == EINTR )
+                    continue;
+
+                if ( n > 0 ) {
+                    output[w].append(buffer, n);
+                    continue;
+                }
+
+                close(pfds[w].fd);
+                pfds[w].fd = -1;
+                --open;
+            }
+        }
+
+        bool success = (pids.size() == jobs);
+
+        for ( auto pid : pids ) {
+            int status;
+
+            while ( waitpid(pid, &status, 0) < 0 && errno == EINTR )
+                ;
+
+            if ( ! WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+                success = false;
+        }
+
+        _endPass();
+
+        if ( ! success )
+            return result;
+
+        for ( auto& data : output ) {
+            size_t pos = 0;
+
+            while ( pos + 2 * sizeof(uint64_t) <= data.size() ) {
+                uint64_t hdr[2];
+                memcpy(hdr, data.data() + pos, sizeof(hdr));
+                pos += sizeof(hdr);
+
+                auto i = hdr[0];
+                auto bc = llvm::StringRef(data.data() + pos, hdr[1]);
+                auto mb = llvm::MemoryBuffer::getMemBuffer(bc, "", false);
+                pos += hdr[1];
+
+                auto module = llvm::parseBitcodeFile(mb->getMemBufferRef(), llvmContext());
+
+                if ( ! module ) {
+                    error(util::fmt("cannot load bitcode for module %s: %s",
+                                    todo[i]->id()->pathAsString(), module.getError().message()));
+                    return result;
+                }
+
+                compiled[i] = std::move(*module);
+            }
+        }
+
+        for ( auto i : pending ) {
+            if ( ! compiled[i] )
+                return result;
+        }
+    }
+
+    for ( auto i : pending ) {
+        auto ctx = todo[i]->compilerContext();
+
+        if ( ctx->_cache )
+            ctx->updateCache(keys[i], compiled[i].get());
+    }
+
+    for ( auto& m : compiled )
+        result.push_back(std::move(m));
+
+    return result;
+}
+
 bool CompilerContext::print(shared_ptr<Module> module, std::ostream& out, bool cfg)
 {
     passes::Printer printer(out, false, cfg);
@@ -765,10 +1175,22 @@ std::unique_ptr<llvm::Module> CompilerContext::linkModules(
         auto rlbca = options().debug ? configuration().runtime_library_bca_dbg :
                                        configuration().runtime_library_bca;
 
-        if ( options().cgDebugging("context") )
-            std::cerr << "Linker: adding bitcode runtime library " << rlbca << std::endl;
+        if ( options().jit && options().jit_native_runtime ) {
+            // The JIT links against the native library, we just take what
+            // we want to inline.
+            if ( options().cgDebugging("context") )
+                std::cerr << "Linker: adding inlinable parts of runtime library " << rlbca
+                          << std::endl;
 
-        linker.addBitcodeFile(rlbca);
+            linker.addRuntimeInlines(rlbca);
+        }
+
+        else {
+            if ( options().cgDebugging("context") )
+                std::cerr << "Linker: adding bitcode runtime library " << rlbca << std::endl;
+
+            linker.addBitcodeFile(rlbca);
+        }
 
 // Linker doesn't support native libraries currently, but it doesn't look like we need it actualy.
 #if 0
@@ -817,11 +1239,11 @@ std::unique_ptr<llvm::Module> CompilerContext::linkModules(
 
     auto linked = linker.link(output, modules);
 
+    _endPass();
+
     if ( ! linked )
         return nullptr;
 
-    _endPass();
-
     return _optimize(std::move(linked), true);
 }
 
@@ -831,8 +1253,15 @@ std::unique_ptr<llvm::Module> CompilerContext::_optimize(std::unique_ptr<llvm::M
     if ( ! options().optimize )
         return module;
 
+    // With tiered JIT compilation, optimization happens later, for hot
+    // functions only.
+    if ( options().jit && options().jit_tiered )
+        return module;
+
     if ( options().cgDebugging("context") )
-        std::cerr << "Optimizing final linked module ... " << std::endl;
+        std::cerr << (is_linked ? "Optimizing final linked module ... " :
+                                  "Optimizing module before linking ... ")
+                  << std::endl;
 
     codegen::Optimizer optimizer(this);
 
@@ -845,7 +1274,8 @@ std::unique_ptr<llvm::Module> CompilerContext::_optimize(std::unique_ptr<llvm::M
     return nmodule;
 }
 
-bool CompilerContext::_jit(std::unique_ptr<llvm::Module> module, JIT* jit)
+bool CompilerContext::_jit(std::unique_ptr<llvm::Module> module, JIT* jit,
+                           const ::util::cache::FileCache::Key* key)
 {
     if ( ! options().jit ) {
         error("jitModule() called but options.jit not set\n");
@@ -857,13 +1287,172 @@ bool CompilerContext::_jit(std::unique_ptr<llvm::Module> module, JIT* jit)
 
     _beginPass("<JIT>", "JIT-setup");
 
-    if ( ! jit->jit(std::move(module)) ) {
+    std::string object_code;
+
+    if ( ! jit->jit(std::move(module), (key && _cache) ? &object_code : nullptr) ) {
         error("JITing module failed");
         return false;
     }
 
     _endPass();
 
+    // With lazy compilation, there's no object code to cache.
+    if ( key && _cache && object_code.size() )
+        updateObjectCache(*key, object_code);
+
+    return true;
+}
+
+bool CompilerContext::compileSharedObject(llvm::Module* module, const string& path,
+                                          const ::util::cache::FileCache::Key& key)
+{
+    if ( options().cgDebugging("context") )
+        std::cerr << util::fmt("Compiling module %s into shared library %s ...",
+                               module->getModuleIdentifier(), path)
+                  << std::endl;
+
+    auto bc = path + ".bc";
+
+    // Don't leave a manifest from an earlier build in place should this
+    // one fail.
+    ::unlink((path + ".manifest").c_str());
+
+    {
+        std::ofstream out(bc);
+        writeBitcode(module, out);
+
+        if ( ! out.good() ) {
+            error(util::fmt("cannot write %s", bc));
+            return false;
+        }
+    }
+
+    // We leave code generation and linking to clang.
+    std::vector<string> args = {configuration().path_clang,
+                                "-shared",
+                                "-fPIC",
+                                options().optimize ? "-O2" : "-O0",
+                                bc,
+                                "-o",
+                                path};
+
+#ifdef __APPLE__
+    // Symbols coming from the host application.
+    args.push_back("-Wl,-undefined,dynamic_lookup");
+#else
+    // Bind the library's references to its own symbols, rather than to a
+    // copy of the runtime that the host application may come with.
+    args.push_back("-Wl,-Bsymbolic");
+#endif
+
+    if ( options().jit_native_runtime )
+        args.push_back(options().debug ? configuration().runtime_library_so_dbg :
+                                         configuration().runtime_library_so);
+
+    std::vector<char*> argv;
+
+    for ( auto& a : args )
+        argv.push_back(const_cast<char*>(a.c_str()));
+
+    argv.push_back(nullptr);
+
+    auto pid = fork();
+
+    if ( pid < 0 ) {
+        error("cannot fork compiler process");
+        return false;
+    }
+
+    if ( pid == 0 ) {
+        execv(argv[0], argv.data());
+        _exit(1);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ::unlink(bc.c_str());
+
+    if ( ! WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+        error(util::fmt("compiling shared library %s failed", path));
+        return false;
+    }
+
+    std::ofstream manifest(path + ".manifest");
+    manifest << key;
+
+    if ( ! manifest.good() ) {
+        error(util::fmt("cannot write manifest for %s", path));
+        return false;
+    }
+
+    return true;
+}
+
+bool CompilerContext::checkSharedObject(const string& path,
+                                        const ::util::cache::FileCache::Key& key)
+{
+    auto mpath = path + ".manifest";
+    std::ifstream in(mpath);
+
+    if ( ! in.good() || ! util::pathIsFile(path) )
+        return false;
+
+    ::util::cache::FileCache::Key mkey;
+    in >> mkey;
+
+    // As with the cache, the library is outdated if any of the files going
+    // into it has changed since.
+    mkey._timestamp = util::cache::modificationTime(mpath);
+
+    if ( key != mkey ) {
+        if ( options().cgDebugging("cache") )
+            std::cerr << util::fmt("Shared library %s does not match the code", path)
+                      << std::endl;
+
+        return false;
+    }
+
+    if ( options().cgDebugging("cache") )
+        std::cerr << util::fmt("Shared library %s matches the code", path) << std::endl;
+
+    return true;
+}
+
+bool CompilerContext::_jitSharedObject(const string& path, JIT* jit)
+{
+    if ( ! options().jit ) {
+        error("jitSharedObject() called but options.jit not set\n");
+        return false;
+    }
+
+    _beginPass("<JIT>", "JIT-load-shared");
+
+    if ( ! jit->jitSharedObject(path) ) {
+        error(util::fmt("loading shared library %s failed", path));
+        return false;
+    }
+
+    _endPass();
+
+    return true;
+}
+
+bool CompilerContext::_jitObject(const std::string& object_code, JIT* jit)
+{
+    if ( ! options().jit ) {
+        error("jitCached() called but options.jit not set\n");
+        return false;
+    }
+
+    _beginPass("<JIT>", "JIT-load");
+
+    if ( ! jit->jitObject(object_code) ) {
+        error("loading cached object code failed");
+        return false;
+    }
+
+    _endPass();
+
     return true;
 }
 
@@ -871,3 +1460,24 @@ shared_ptr<util::cache::FileCache> CompilerContext::fileCache() const
 {
     return _cache;
 }
+
+shared_ptr<codegen::PGOProfile> CompilerContext::pgoProfile()
+{
+    auto path = options().pgo_use;
+
+    if ( path.empty() )
+        return nullptr;
+
+    if ( _pgo_profile && _pgo_profile_path == path )
+        return _pgo_profile;
+
+    _pgo_profile = std::make_shared<codegen::PGOProfile>();
+    _pgo_profile_path = path;
+
+    if ( ! _pgo_profile->load(path) ) {
+        warning(util::fmt("cannot read profile %s, compiling without it", path));
+        _pgo_profile = std::make_shared<codegen::PGOProfile>();
+    }
+
+    return _pgo_profile;
+}
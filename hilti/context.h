@@ -16,6 +16,10 @@ namespace hilti {
 
 class JIT;
 
+namespace codegen {
+class PGOProfile;
+}
+
 namespace passes {
 class ScopeBuilder;
 }
@@ -124,6 +128,30 @@ public:
     /// Returns: The HILTI module, or null if errors are encountered.
     std::unique_ptr<llvm::Module> compile(shared_ptr<Module> module);
 
+    /// Compiles a set of ASTs into LLVM modules. This is a variant of
+    /// compile() that runs the code generator on up to Options::jobs
+    /// modules concurrently. Each worker is a forked process with its own
+    /// LLVM context, as the AST cannot be shared across threads; the results
+    /// come back as bitcode that is then loaded into llvmContext(). Each
+    /// module is compiled with the options and cache of its own
+    /// CompilerContext (Module::compilerContext()), which must all share our
+    /// LLVM context.
+    ///
+    /// Note that the workers keep running the full compiler after fork(),
+    /// which is safe only if the calling process has no other threads at
+    /// that time: a lock held by another thread, e.g. inside malloc(),
+    /// would stay locked in the worker forever. Host applications that may
+    /// have started threads must leave Options::jobs at 1. Where we can
+    /// tell that there are other threads (currently on Linux), we compile
+    /// sequentially anyway.
+    ///
+    /// modules: The modules to compile. All must have passed through
+    /// finalize().
+    ///
+    /// Returns: The LLVM modules, in the same order as *modules*; or an
+    /// empty list if errors are encountered with any of them.
+    std::list<std::unique_ptr<llvm::Module>> compile(const std::list<shared_ptr<Module>>& modules);
+
     /// Compiles an AST into a LLVM module. This is a variant of compile()
     /// that takes a prepopulated cache key under which the compiled module
     /// will be stored if caching is enabled. However, this version will
@@ -220,6 +248,11 @@ public:
     /// Returns the file cache the context is using, or null if none.
     shared_ptr<util::cache::FileCache> fileCache() const;
 
+    /// Returns the profile that Options::pgo_use specifies, loading it on
+    /// first access. Returns null if the option isn't set. If the profile
+    /// cannot be read, this warns and returns an empty profile.
+    shared_ptr<codegen::PGOProfile> pgoProfile();
+
     /// Dumps out an AST in (somewhat) readable format for debugging.
     ///
     /// ast: The AST to dump. This can be a partial AST, i.e., it doesn't need
@@ -231,6 +264,7 @@ public:
     bool dump(shared_ptr<Node> ast, std::ostream& out);
 
     /// Check if we have cached LLVM modules associated with a cache key.
+    /// The modules are created inside llvmContext().
     ///
     /// The method is a no-op if the context doesn't use caching.
     ///
@@ -239,28 +273,74 @@ public:
     /// Returns: The cached modules if available, or an empty list if not.
     /// The latter will always be the case if the context is not using
     /// caching.
-    ///
-    /// TODO: Disabled. Always returns an empty list current.
     std::list<std::unique_ptr<llvm::Module>> checkCache(const ::util::cache::FileCache::Key& key);
 
-    /// TODO: Disabled. Always returns an empty list current.
+    /// Stores/updates cached versions of a set of LLVM modules.
+    ///
+    /// key: The key to associate with the modules.
+    ///
+    /// modules: The modules to cache under \a key.
     void updateCache(const ::util::cache::FileCache::Key& key,
-                     std::list<std::unique_ptr<llvm::Module>> module);
+                     const std::list<const llvm::Module*>& modules);
 
     /// Stores/updates cached version of a single LLVM module.
     ///
     /// key: The key to associate with the module.
     ///
     /// module: THe module to cache under \a key.
+    void updateCache(const ::util::cache::FileCache::Key& key, const llvm::Module* module);
+
+    /// Checks if we have native object code cached under a key, as stored
+    /// by updateObjectCache().
     ///
-    /// TODO: Disabled. Always returns an empty list current.
-    void updateCache(const ::util::cache::FileCache::Key& key,
-                     std::unique_ptr<llvm::Module> module);
+    /// key: The key to use.
+    ///
+    /// object_code: Set to the cached code if found.
+    ///
+    /// Returns: True if found. Always false if the context is not using
+    /// caching.
+    bool checkObjectCache(const ::util::cache::FileCache::Key& key, std::string* object_code);
 
-    /// Augments the cache key with values suitable to check if a HILTI
-    /// module (or any of its dependencies) has changed.
+    /// Stores/updates native object code in the cache.
+    ///
+    /// key: The key to associate with the code.
+    ///
+    /// object_code: The code to cache under \a key.
+    void updateObjectCache(const ::util::cache::FileCache::Key& key,
+                           const std::string& object_code);
+
+    /// Compiles a module returned by linkModules() ahead of time into a
+    /// shared library that jitSharedObject() can later load instead of
+    /// JITing the module. Alongside the library, this writes a manifest
+    /// recording the key, which loading checks against.
+    ///
+    /// module: The module to compile.
+    ///
+    /// path: The path of the shared library to create. The manifest goes
+    /// into the same path with \c .manifest appended.
+    ///
+    /// key: A key identifying the code going into the module, computed in
+    /// the same way as for caching.
+    ///
+    /// Returns: True on success.
+    bool compileSharedObject(llvm::Module* module, const string& path,
+                             const ::util::cache::FileCache::Key& key);
+
+    /// Checks if a shared library created by compileSharedObject() matches
+    /// a key, using its manifest.
+    ///
+    /// path: The path of the shared library.
     ///
-    /// \todo Dependencies aren't tracked yet.
+    /// key: The key to check against.
+    ///
+    /// Returns: True if the library exists and matches.
+    bool checkSharedObject(const string& path, const ::util::cache::FileCache::Key& key);
+
+    /// Augments the cache key with values suitable to check if a HILTI
+    /// module (or any of its dependencies) has changed. This hashes the
+    /// content of the module and of everything it imports, and includes
+    /// the compiler's version. It does not include the options in effect,
+    /// use Options::toCacheKey() for that.
     ///
     /// module: The module to update the key for.
     ///
@@ -275,12 +355,18 @@ public:
     /// key: The key to update.
     void toCacheKey(const llvm::Module* module, ::util::cache::FileCache::Key* key);
 
-    /// Returns a list of path names that this module depends on.
-    ///
-    /// \todo This is actually not yet implemented and always returns an
-    /// empty list currently.
+    /// Returns a list of path names that this module depends on. These are
+    /// the paths of all the modules it imports, directly or indirectly.
+    /// Dependencies are recorded when modules get finalized.
     std::list<string> dependencies(shared_ptr<Module> module);
 
+    /// Augments the cache key with the compiler's identity, so that a
+    /// cached entry doesn't survive an update of the compiler or its
+    /// runtime library.
+    ///
+    /// key: The key to update.
+    static void toCacheKeyCompiler(::util::cache::FileCache::Key* key);
+
     /// Returns the name of an LLVM module. This first looks for
     /// corresponding meta-data that the code generator inserts and returns
     /// that if found, and the standard LLVM module name otherwise. The meta
@@ -290,10 +376,37 @@ public:
 
 protected:
     /// Internal version of CompilerJITContext<JIT>::jit() that operates on the
-    /// already instantiated JIT object. Returns true on success.
-    bool _jit(std::unique_ptr<llvm::Module> module, JIT* jit);
+    /// already instantiated JIT object. Returns true on success. If a key is
+    /// given, stores the compiled code in the cache.
+    bool _jit(std::unique_ptr<llvm::Module> module, JIT* jit,
+              const ::util::cache::FileCache::Key* key = nullptr);
+
+    /// Internal version of CompilerJITContext<JIT>::jitCached() that
+    /// operates on the already instantiated JIT object. Returns true on
+    /// success.
+    bool _jitObject(const std::string& object_code, JIT* jit);
+
+    /// Internal version of CompilerJITContext<JIT>::jitSharedObject() that
+    /// operates on the already instantiated JIT object. Returns true on
+    /// success.
+    bool _jitSharedObject(const string& path, JIT* jit);
 
 private:
+    /// Computes the cache key under which compile() stores the LLVM code
+    /// for a module.
+    ::util::cache::FileCache::Key _compileKey(shared_ptr<Module> module);
+
+    /// Runs the code generator on a module, without any caching.
+    ///
+    /// module: The module to compile.
+    ///
+    /// llvm_context: The LLVM context to create the module in. This may
+    /// differ from llvmContext() when running inside a worker process.
+    ///
+    /// Returns: The LLVM module, or null if errors are encountered.
+    std::unique_ptr<llvm::Module> _codegen(shared_ptr<Module> module,
+                                           llvm::LLVMContext& llvm_context);
+
     /// Optimizes an LLVM module according to the CompilerContext's options
     /// (including not at all if the options don't request optimization).
     ///
@@ -302,7 +415,7 @@ private:
     /// is_linked: True if this is the final linked module, false if it's an
     /// individual module that will later be linked.
     ///
-    /// Returns: A new optimized module if successful.
+    /// Returns: The optimized module if successful.
     std::unique_ptr<llvm::Module> _optimize(std::unique_ptr<llvm::Module> module, bool is_linked);
 
     // Backend for finalize().
@@ -340,11 +453,18 @@ private:
 
     shared_ptr<util::cache::FileCache> _cache;
 
+    shared_ptr<codegen::PGOProfile> _pgo_profile;
+    string _pgo_profile_path;
+
     /// We keep global maps of all module nodes and, separately, their
     /// scopes, both indexed by their path. This is for avoiding duplicate
     /// imports, in particular when encountering cycles.
     std::map<string, shared_ptr<Module>> _modules;
 
+    /// The paths imported by each module we have finalized, indexed by the
+    /// module's path.
+    std::map<string, std::set<string>> _imports;
+
     /// TODO: Spicy context needs this, should be doing it differently.
 public:
     // Tracking passes.
@@ -356,8 +476,22 @@ public:
 
     typedef std::list<PassInfo> pass_list;
 
+    /// Accounts wall-clock time to a compiler phase for
+    /// printPassTimes().
+    ///
+    /// name: The name of the phase.
+    ///
+    /// delta: The time spent, in seconds.
+    void addPassTime(const string& name, double delta);
+
+    /// Prints the accumulated wall-clock time per top-level compiler phase
+    /// to an output stream. This is intended for the tools to show where
+    /// compile time went when the \c time debug stream is enabled.
+    void printPassTimes(std::ostream& out) const;
+
 private:
     pass_list _passes;
+    std::list<std::pair<string, double>> _pass_times;
 
 public:
     pass_list& passes()
@@ -388,6 +522,83 @@ public:
         else
             return nullptr;
     }
+
+    /// JITs an LLVM module like jit(), and also stores the resulting native
+    /// code in the cache, if caching is enabled. jitCached() can then later
+    /// retrieve it.
+    ///
+    /// module: The module. The function takes ownership.
+    ///
+    /// key: The key to store the code under. This should describe
+    /// everything that went into the module, including options.
+    ///
+    /// Returns: A JIT instance, or null if there was an error.
+    std::unique_ptr<JIT> jit(std::unique_ptr<llvm::Module> module,
+                             const ::util::cache::FileCache::Key& key)
+    {
+        auto jit = std::make_unique<JIT>(this);
+        if ( _jit(std::move(module), jit.get(), &key) )
+            return jit;
+        else
+            return nullptr;
+    }
+
+    /// Sets up a JIT instance with native code that jit() has stored in
+    /// the cache earlier. This skips code generation, optimization, and
+    /// the compilation to machine code.
+    ///
+    /// key: The key that the code was stored under.
+    ///
+    /// Returns: A JIT instance, or null if there's no code cached under
+    /// the key (or loading failed).
+    std::unique_ptr<JIT> jitCached(const ::util::cache::FileCache::Key& key)
+    {
+        std::string object_code;
+
+        if ( ! checkObjectCache(key, &object_code) )
+            return nullptr;
+
+        return jitObject(object_code);
+    }
+
+    /// Sets up a JIT instance with native code that checkObjectCache()
+    /// has returned. This is the same as jitCached(), except that it
+    /// doesn't look up the code again.
+    ///
+    /// object_code: The native code.
+    ///
+    /// Returns: A JIT instance, or null if loading failed.
+    std::unique_ptr<JIT> jitObject(const std::string& object_code)
+    {
+        auto jit = std::make_unique<JIT>(this);
+        if ( _jitObject(object_code, jit.get()) )
+            return jit;
+        else
+            return nullptr;
+    }
+
+    /// Sets up a JIT instance with native code from a shared library that
+    /// compileSharedObject() created. This involves no code generation at
+    /// all.
+    ///
+    /// path: The path of the shared library.
+    ///
+    /// key: The key the library must have been created with.
+    ///
+    /// Returns: A JIT instance, or null if the library doesn't match the
+    /// key (or loading failed).
+    std::unique_ptr<JIT> jitSharedObject(const string& path,
+                                         const ::util::cache::FileCache::Key& key)
+    {
+        if ( ! checkSharedObject(path, key) )
+            return nullptr;
+
+        auto jit = std::make_unique<JIT>(this);
+        if ( _jitSharedObject(path, jit.get()) )
+            return jit;
+        else
+            return nullptr;
+    }
 };
 }
 
@@ -14,6 +14,10 @@
 ///         writable again. By default, channels are unbounded and can grow
 ///         arbitrarily large.
 ///
+/// * Single producer/consumer. A bounded channel that is known to have
+///         exactly one writer and one reader can be created in a lock-free
+///         ring-buffer mode that avoids any locking on reads and writes.
+///
 /// \cproto hlt_channel*
 ///
 
@@ -22,17 +26,25 @@ iBegin(channel::New, "new")
     iTarget(optype::refChannel);
     iOp1(optype::typeChannel, true);
     iOp2(optype::optional(optype::int64), true);
+    iOp3(optype::optional(optype::boolean), true);
 
     iValidate
     {
         equalTypes(referencedType(target), typedType(op1));
+
+        if ( op3 )
+            isConstant(op3);
     }
 
     iDoc(R"(
          Allocates a new instance of a channel storing elements of type *op1*.
          *op2* defines the channel's capacity, i.e., the maximal number of items
          it can store. The capacity defaults to zero, which creates a channel of
-         unbounded capacity.
+         unbounded capacity. If the constant *op3* is true, the channel is
+         created in single-producer/single-consumer mode: it's then backed by a
+         lock-free ring buffer that must only ever be written by one thread and
+         read by one other. Such channels are always bounded; with a capacity
+         of zero, a default of 1024 items is used.
     )");
 iEnd
 
@@ -68,6 +80,25 @@ iBegin(channel::ReadTry, "channel.read_try")
     )");
 iEnd
 
+iBegin(channel::ReadBatch, "channel.read_batch")
+    iTarget(optype::refVector);
+    iOp1(optype::refChannel, true);
+    iOp2(optype::optional(optype::int64), true);
+
+    iValidate
+    {
+        equalTypes(argType(target), argType(op1));
+    }
+
+    iDoc(R"(
+        Removes up to *op2* items from the channel referenced by *op1* and
+        returns them as a new vector, synchronizing only once for the whole
+        batch. If *op2* is not given or zero, all currently available items
+        are returned. If the channel is empty, the instruction blocks until
+        at least one item becomes available.
+    )");
+iEnd
+
 iBegin(channel::Size, "channel.size")
     iTarget(optype::int64);
     iOp1(optype::refChannel, true);
@@ -110,3 +141,21 @@ iBegin(channel::WriteTry, "channel.write_try")
         full, the instruction raises a ``WouldBlock`` exception.
     )");
 iEnd
+
+iBegin(channel::WriteBatch, "channel.write_batch")
+    iOp1(optype::refChannel, false);
+    iOp2(optype::refVector, true);
+
+    iValidate
+    {
+        equalTypes(argType(op2), argType(op1));
+    }
+
+    iDoc(R"(
+        Writes all items of the vector *op2* into the channel referenced by
+        *op1*, synchronizing only once for the whole batch. If the channel
+        does not have space for all of them, the instruction blocks until it
+        does. Raises ``ValueError`` if the batch is larger than the channel's
+        capacity.
+    )");
+iEnd
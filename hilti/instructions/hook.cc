@@ -114,7 +114,13 @@
 ///
 /// When a hook is run, all currently disabled hook functions are ignored.
 /// Note that groups are indeed fully global, and enabling/disabling is
-/// visible across all threads.
+/// visible across all threads. Checking whether a group is enabled comes
+/// at a cost for each hook function called. With the optional
+/// ``hookgroups`` optimization enabled, the linker hence removes these
+/// checks for all groups that the program never disables; if the group
+/// passed to ``hook.disable_group`` isn't a constant, all groups remain
+/// checked. As host applications can then no longer toggle the other
+/// groups, that optimization must be enabled explicitly.
 
 
 iBegin(hook::DisableGroup, "hook.disable_group")
@@ -155,6 +161,22 @@ iBegin(hook::GroupEnabled, "hook.group_enabled")
     )");
 iEnd
 
+iBegin(hook::Implemented, "hook.implemented")
+    iTarget(optype::boolean);
+    iOp1(optype::hook, true);
+
+    iValidate
+    {
+    }
+
+    iDoc(R"(
+        Sets *target* to ``True`` if at least one function implementing the
+        hook *op1* has been linked in, and to *False* otherwise. As that's
+        known only at link time, the linker turns the result into a
+        constant, allowing code guarded by it to be optimized away.
+    )");
+iEnd
+
 iBegin(hook::Run, "hook.run")
     iTarget(optype::optional(optype::any));
     iOp1(optype::hook, true);
@@ -16,6 +16,13 @@
 /// \cproto hlt_bytes_iter
 ///
 
+// Returns the type of the elements an IOSrc yields, ``(time, ref<bytes>)``.
+static shared_ptr<Type> _elementType()
+{
+    builder::type_list tt = {builder::time::type(),
+                             builder::reference::type(builder::bytes::type())};
+    return builder::tuple::type(tt);
+}
 
 iBegin(iterIOSource::Begin, "begin")
     iTarget(optype::iterIOSource);
@@ -84,11 +91,11 @@ iBegin(iterIOSource::Deref, "deref")
 
     iValidate
     {
-        // TODO:  Check tuple.
+        equalTypes(_elementType(), target->type());
     }
 
     iDoc(R"(
-       Returns the element the iterator is pointing at as a tuple ``(double,
+       Returns the element the iterator is pointing at as a tuple ``(time,
        ref<bytes>)``.
     )");
 iEnd
@@ -133,7 +140,7 @@ iBegin(ioSource::Read, "iosrc.read")
 
     iValidate
     {
-        // TODO:  Check tuple.
+        equalTypes(_elementType(), target->type());
     }
 
     iDoc(R"(
@@ -143,3 +150,43 @@ iBegin(ioSource::Read, "iosrc.read")
         if there is any other problem with returning the next element.
     )");
 iEnd
+
+iBegin(ioSource::ReadBatch, "iosrc.read_batch")
+    iTarget(optype::refVector);
+    iOp1(optype::refIOSource, false);
+    iOp2(optype::optional(optype::int64), true);
+
+    iValidate
+    {
+        equalTypes(_elementType(), elementType(referencedType(target)));
+    }
+
+    iDoc(R"(
+        Returns up to *op2* elements from the I/O source *op1* as a vector
+        of ``(time, ref<bytes>)`` tuples, retrieving everything the source has
+        already buffered at once. If *op2* is not given or zero, a default
+        batch size is used. If currently no element is available, the
+        instruction blocks until at least one is. Raises: ~~IOSrcExhausted if
+        the source has been exhausted. Raises: ~~IOSrcError if there is any
+        other problem with returning the next elements.
+    )");
+iEnd
+
+iBegin(ioSource::FlowVid, "iosrc.flow_vid")
+    iTarget(optype::int64);
+    iOp1(optype::refBytes, true);
+
+    iValidate
+    {
+    }
+
+    iDoc(R"(
+        Returns a virtual thread ID for the IP packet *op1*, derived from its
+        addresses, transport protocol, and ports. Both directions of a flow
+        map to the same ID, and the ID falls into the range of virtual
+        threads configured for scheduling, so that ``thread.schedule`` with
+        it keeps all packets of a flow on the same thread. *op1* must start
+        with the IP header (i.e., the link layer must have been stripped).
+        Non-IP packets all map to the same ID.
+    )");
+iEnd
@@ -7,12 +7,19 @@
 
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
-#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
 #include "llvm/ExecutionEngine/Orc/LambdaResolver.h"
 #include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/Orc/OrcABISupport.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Mangler.h"
+#include "llvm/IR/Verifier.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Memory.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
 #undef DEBUG
@@ -21,9 +28,14 @@
 #endif
 
 #include "codegen/common.h"
+#include "codegen/optimizer.h"
+#include "context.h"
+#include "hilti/autogen/hilti-config.h"
 #include "jit.h"
 #include "options.h"
 
+#include <chrono>
+
 #include <dlfcn.h>
 
 extern "C" {
@@ -33,6 +45,96 @@ extern "C" {
 
 using namespace hilti;
 
+// With tiered compilation, how often the background thread checks for hot
+// functions.
+static const auto TieredInterval = std::chrono::milliseconds(100);
+
+// A version of ORC's LocalJITCompileCallbackManager that holds a lock while
+// running a compile callback. With worker threads, several functions may
+// get called for the first time concurrently, yet neither the callback
+// manager's bookkeeping nor the layers compiling the code are thread-safe.
+// ORC's own manager doesn't give us a hook to take the lock early enough,
+// so this replicates it.
+class JIT::CompileCallbackManager : public llvm::orc::JITCompileCallbackManager {
+public:
+    CompileCallbackManager(std::mutex* mutex)
+        : llvm::orc::JITCompileCallbackManager(0), _mutex(mutex)
+    {
+        std::error_code ec;
+        _resolver = llvm::sys::OwningMemoryBlock(
+            llvm::sys::Memory::allocateMappedMemory(TargetT::ResolverCodeSize, nullptr,
+                                                    llvm::sys::Memory::MF_READ |
+                                                        llvm::sys::Memory::MF_WRITE,
+                                                    ec));
+        assert(! ec && "failed to allocate resolver block");
+
+        TargetT::writeResolverCode(static_cast<uint8_t*>(_resolver.base()), &reenter, this);
+
+        ec = llvm::sys::Memory::protectMappedMemory(_resolver.getMemoryBlock(),
+                                                    llvm::sys::Memory::MF_READ |
+                                                        llvm::sys::Memory::MF_EXEC);
+        assert(! ec && "failed to protect resolver block");
+    }
+
+    // Runs all callbacks still pending, compiling everything that hasn't
+    // been called yet.
+    void runAll()
+    {
+        std::vector<llvm::orc::TargetAddress> pending;
+
+        for ( auto& t : ActiveTrampolines )
+            pending.push_back(t.first);
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+
+        for ( auto t : pending )
+            executeCompileCallback(t);
+    }
+
+private:
+    typedef llvm::orc::OrcX86_64 TargetT;
+
+    static llvm::orc::TargetAddress reenter(void* mgr, void* trampoline)
+    {
+        auto self = static_cast<CompileCallbackManager*>(mgr);
+        std::lock_guard<std::mutex> lock(*self->_mutex);
+        return self->executeCompileCallback(
+            static_cast<llvm::orc::TargetAddress>(reinterpret_cast<uintptr_t>(trampoline)));
+    }
+
+    void grow() override
+    {
+        std::error_code ec;
+        auto block = llvm::sys::OwningMemoryBlock(
+            llvm::sys::Memory::allocateMappedMemory(llvm::sys::Process::getPageSize(), nullptr,
+                                                    llvm::sys::Memory::MF_READ |
+                                                        llvm::sys::Memory::MF_WRITE,
+                                                    ec));
+        assert(! ec && "failed to allocate trampoline block");
+
+        auto num = (llvm::sys::Process::getPageSize() - TargetT::PointerSize) /
+                   TargetT::TrampolineSize;
+
+        auto mem = static_cast<uint8_t*>(block.base());
+        TargetT::writeTrampolines(mem, _resolver.base(), num);
+
+        for ( unsigned int i = 0; i < num; ++i )
+            AvailableTrampolines.push_back(static_cast<llvm::orc::TargetAddress>(
+                reinterpret_cast<uintptr_t>(mem + (i * TargetT::TrampolineSize))));
+
+        ec = llvm::sys::Memory::protectMappedMemory(block.getMemoryBlock(),
+                                                    llvm::sys::Memory::MF_READ |
+                                                        llvm::sys::Memory::MF_EXEC);
+        assert(! ec && "failed to protect trampoline block");
+
+        _trampolines.push_back(std::move(block));
+    }
+
+    std::mutex* _mutex;
+    llvm::sys::OwningMemoryBlock _resolver;
+    std::vector<llvm::sys::OwningMemoryBlock> _trampolines;
+};
+
 JIT::JIT(CompilerContext* ctx)
 {
     _ctx = ctx;
@@ -41,13 +143,16 @@ JIT::JIT(CompilerContext* ctx)
     llvm::InitializeNativeTargetAsmPrinter();
     llvm::InitializeNativeTargetAsmParser();
 
-    auto target = llvm::EngineBuilder().selectTarget();
+    // With tiered compilation, the first tier goes for fast compilation,
+    // which also lets LLVM use FastISel.
+    auto opt_level =
+        _ctx->options().jit_tiered ? llvm::CodeGenOpt::None : llvm::CodeGenOpt::Default;
+
+    auto target = llvm::EngineBuilder().setOptLevel(opt_level).selectTarget();
     _target_machine.reset(target);
 
     _data_layout = std::make_unique<llvm::DataLayout>(_target_machine->createDataLayout());
     _object_layer = std::make_unique<ObjectLayer>();
-    auto compiler = llvm::orc::SimpleCompiler(*_target_machine);
-    _compile_layer = std::make_unique<CompileLayer>(*_object_layer, compiler);
 
     llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
 }
@@ -61,8 +166,11 @@ __attribute__((weak)) void* __hlt_runtime_state_get()
     exit(1);
 }
 
-bool JIT::jit(std::unique_ptr<llvm::Module> module)
+bool JIT::jit(std::unique_ptr<llvm::Module> module, std::string* object_code)
 {
+    if ( ! _loadRuntime() )
+        return false;
+
     // TODO: If we just JIT the module we have received, things will crash
     // badly once the module gets destroyed. Something like this:
     //
@@ -79,36 +187,172 @@ bool JIT::jit(std::unique_ptr<llvm::Module> module)
     llvm::raw_svector_ostream os(buffer);
     WriteBitcodeToFile(module.get(), os);
 
+    if ( _ctx->options().jit_lazy || _ctx->options().jit_tiered ) {
+        // The module must stay around for functions compiled later.
+        _lazy_context = std::make_unique<llvm::LLVMContext>();
+        llvm::ObjectMemoryBuffer omb(std::move(buffer));
+        auto module_clone = llvm::parseBitcodeFile(omb, *_lazy_context);
+
+        if ( ! _ctx->options().jit_tiered )
+            return _jitLazy(std::move(*module_clone));
+
+        _prepareTiering(module_clone->get());
+
+        if ( ! _jitLazy(std::move(*module_clone)) )
+            return false;
+
+        _startTiering();
+        return true;
+    }
+
     llvm::LLVMContext jit_context;
     llvm::ObjectMemoryBuffer omb(std::move(buffer));
     auto module_clone = llvm::parseBitcodeFile(omb, jit_context);
 
+    // We compile to object code ourselves rather than going through an
+    // IRCompileLayer so that we can hand the code out for caching.
+    llvm::orc::SimpleCompiler compiler(*_target_machine);
+    auto object = std::make_unique<Object>(compiler(*module_clone.get()));
+
+    if ( ! object->getBinary() ) {
+        error("compiling module to object code failed");
+        return false;
+    }
+
+    if ( object_code ) {
+        auto data = object->getBinary()->getData();
+        *object_code = std::string(data.data(), data.size());
+    }
+
+    return _jit(std::move(object));
+}
+
+bool JIT::jitObject(const std::string& object_code)
+{
+    if ( ! _loadRuntime() )
+        return false;
+
+    auto buffer = llvm::MemoryBuffer::getMemBufferCopy(object_code);
+    auto object = llvm::object::ObjectFile::createObjectFile(buffer->getMemBufferRef());
+
+    if ( ! object ) {
+        llvm::consumeError(object.takeError());
+        error("cannot load object code");
+        return false;
+    }
+
+    return _jit(std::make_unique<Object>(std::move(*object), std::move(buffer)));
+}
+
+bool JIT::jitSharedObject(const std::string& path)
+{
+    if ( ! _loadRuntime() )
+        return false;
+
+    _shared_object = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+    if ( ! _shared_object ) {
+        error(::util::fmt("cannot load shared library: %s", dlerror()));
+        return false;
+    }
+
+    return _initRuntime();
+}
+
+bool JIT::_jit(std::unique_ptr<Object> object)
+{
     auto resolver = llvm::orc::createLambdaResolver(
         [&](const std::string& name) {
             // Symbol lookup inside the compiled code (is that right???)
-            if ( auto sym = _compile_layer->findSymbol(name, false) )
+            if ( auto sym = _object_layer->findSymbol(name, false) )
                 return sym.toRuntimeDyldSymbol();
             else
                 return llvm::RuntimeDyld::SymbolInfo(nullptr);
         },
 
-        [](const std::string& name) {
-            // Symbol lookup inside the process.
-            if ( auto symaddr = llvm::RTDyldMemoryManager::getSymbolAddressInProcess(name) )
-                return llvm::RuntimeDyld::SymbolInfo(symaddr, llvm::JITSymbolFlags::Exported);
-            else
-                return llvm::RuntimeDyld::SymbolInfo(nullptr);
-        });
+        [this](const std::string& name) { return _findExternal(name); });
 
-    std::vector<std::unique_ptr<llvm::Module>> ms;
-    ms.push_back(std::move(module_clone.get()));
+    std::vector<std::unique_ptr<Object>> objects;
+    objects.push_back(std::move(object));
 
     auto mm = std::make_unique<llvm::SectionMemoryManager>();
-    _compile_layer->addModuleSet(std::move(ms), std::move(mm), std::move(resolver));
+    _object_layer->addObjectSet(std::move(objects), std::move(mm), std::move(resolver));
 
     // TODO: Looks like ORC doesn't have any error reporting yet.
     // https://llvm.org/bugs/show_bug.cgi?id=22612
 
+    return _initRuntime();
+}
+
+bool JIT::_jitLazy(std::unique_ptr<llvm::Module> module)
+{
+    auto triple = _target_machine->getTargetTriple();
+
+    if ( triple.getArch() != llvm::Triple::x86_64 ) {
+        error("lazy compilation is not supported on this platform");
+        return false;
+    }
+
+    _callbacks = std::make_unique<CompileCallbackManager>(&_mutex);
+
+    _compile_layer = std::make_unique<CompileLayer>(*_object_layer,
+                                                    llvm::orc::SimpleCompiler(*_target_machine));
+
+    _lazy_layer = std::make_unique<LazyLayer>(*_compile_layer,
+                                              [this](llvm::Function& f) { return _partition(f); },
+                                              *_callbacks,
+                                              llvm::orc::createLocalIndirectStubsManagerBuilder(
+                                                  triple));
+
+    auto resolver = llvm::orc::createLambdaResolver(
+        [&](const std::string& name) {
+            if ( auto sym = _lazy_layer->findSymbol(name, false) )
+                return sym.toRuntimeDyldSymbol();
+            else
+                return llvm::RuntimeDyld::SymbolInfo(nullptr);
+        },
+
+        [this](const std::string& name) { return _findExternal(name); });
+
+    if ( _ctx->options().cgDebugging("jit") && ! _ctx->options().jit_tiered ) {
+        auto n = 0;
+
+        for ( auto& f : *module ) {
+            if ( ! f.isDeclaration() )
+                ++n;
+        }
+
+        std::cerr << "JIT: preparing " << n << " functions for lazy compilation" << std::endl;
+    }
+
+    std::vector<std::unique_ptr<llvm::Module>> modules;
+    modules.push_back(std::move(module));
+
+    auto mm = std::make_unique<llvm::SectionMemoryManager>();
+    _lazy_layer->addModuleSet(std::move(modules), std::move(mm), std::move(resolver));
+
+    // With tiered compilation, the first tier is complete before anything
+    // runs, so that only the background thread compiles later.
+    if ( _ctx->options().jit_tiered )
+        _callbacks->runAll();
+
+    return _initRuntime();
+}
+
+std::set<llvm::Function*> JIT::_partition(llvm::Function& func)
+{
+    // Each function gets its own partition so that we compile only what
+    // actually runs. With tiered compilation, we use the lazy layer only for
+    // its stubs, through which we later swap in optimized code; _jitLazy()
+    // then compiles all functions right away.
+    if ( _ctx->options().cgDebugging("jit") && ! _ctx->options().jit_tiered )
+        std::cerr << "JIT: compiling " << func.getName().str() << std::endl;
+
+    return {&func};
+}
+
+bool JIT::_initRuntime()
+{
     // Let the JIT use same global libhilti state as the current process
     // image. We use the current state so that any configuration informaiton
     // already set remains valid.
@@ -119,29 +363,364 @@ bool JIT::jit(std::unique_ptr<llvm::Module> module)
 
     (*hrss)(__hlt_runtime_state_get());
 
+    if ( _runtime_library ) {
+        // The native runtime can't see the functions that the linker
+        // generated for the JITed code, so we need to tell it about them.
+        typedef void (*ctx_func)(void*);
+        typedef uint64_t (*size_func)();
+        typedef void (*register_func)(ctx_func, ctx_func, ctx_func, size_func);
+
+        auto hlr = (register_func)nativeFunction("__hlt_linker_register");
+
+        (*hlr)((ctx_func)nativeFunction("__hlt_modules_init", false),
+               (ctx_func)nativeFunction("__hlt_globals_init", false),
+               (ctx_func)nativeFunction("__hlt_globals_dtor", false),
+               (size_func)nativeFunction("__hlt_globals_size", false));
+    }
+
     auto jit_hlt_init = (void (*)())nativeFunction("__hlt_init");
     (*jit_hlt_init)();
 
+    _initialized = true;
+
     _jit_init();
 
     return true;
 }
 
+void JIT::_prepareTiering(llvm::Module* module)
+{
+    // Recompiled code links against the symbols of the original module,
+    // so they all need external names.
+    for ( auto& f : *module ) {
+        if ( ! f.hasLocalLinkage() )
+            continue;
+
+        if ( ! f.hasName() )
+            f.setName("__hlt_tiered");
+
+        f.setLinkage(llvm::GlobalValue::ExternalLinkage);
+    }
+
+    for ( auto& g : module->globals() ) {
+        if ( ! g.hasLocalLinkage() || g.getName().startswith("llvm.") )
+            continue;
+
+        if ( ! g.hasName() )
+            g.setName("__hlt_tiered");
+
+        g.setLinkage(llvm::GlobalValue::ExternalLinkage);
+    }
+
+    llvm::SmallVector<char, 1024> buffer;
+    llvm::raw_svector_ostream os(buffer);
+    WriteBitcodeToFile(module, os);
+    _tiered_bitcode = std::string(buffer.data(), buffer.size());
+
+    // Count calls at function entry. We don't bother with atomic updates,
+    // approximate counts are good enough here.
+    auto i64 = llvm::Type::getInt64Ty(module->getContext());
+    auto one = llvm::ConstantInt::get(i64, 1);
+
+    for ( auto& f : *module ) {
+        if ( f.isDeclaration() )
+            continue;
+
+        TieredFunction tf;
+        tf.name = f.getName();
+        tf.counter = "__hlt_tiered_calls." + tf.name;
+
+        auto counter =
+            new llvm::GlobalVariable(*module, i64, false, llvm::GlobalValue::ExternalLinkage,
+                                     llvm::ConstantInt::get(i64, 0), tf.counter);
+
+        llvm::IRBuilder<> builder(&*f.getEntryBlock().getFirstInsertionPt());
+        auto calls = builder.CreateLoad(counter);
+        builder.CreateStore(builder.CreateAdd(calls, one), counter);
+
+        _tiered_functions.push_back(tf);
+    }
+}
+
+void JIT::_startTiering()
+{
+    for ( auto& tf : _tiered_functions ) {
+        if ( auto sym = _lazy_layer->findSymbol(_mangle(tf.counter), false) )
+            tf.calls = (volatile uint64_t*)sym.getAddress();
+    }
+
+    _tiered_target_machine.reset(llvm::EngineBuilder().selectTarget());
+    _tiered_thread = std::thread([this]() { _tieringLoop(); });
+}
+
+void JIT::_tieringLoop()
+{
+    while ( true ) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _tiered_cv.wait_for(lock, TieredInterval, [this]() { return _tiered_stop; });
+
+            if ( _tiered_stop )
+                return;
+        }
+
+        std::set<std::string> hot;
+        auto threshold = _ctx->options().jit_tiered_threshold;
+
+        for ( auto& tf : _tiered_functions ) {
+            if ( tf.optimized || ! tf.calls || *tf.calls < threshold )
+                continue;
+
+            // We don't retry if recompilation fails.
+            tf.optimized = true;
+            hot.insert(tf.name);
+        }
+
+        if ( hot.size() )
+            _recompile(hot);
+    }
+}
+
+bool JIT::_recompile(const std::set<std::string>& functions)
+{
+    // Everything up to the final linking happens in our own LLVM context
+    // and without holding the lock, so that it runs concurrently with the
+    // code already executing.
+    llvm::LLVMContext context;
+    auto buffer = llvm::MemoryBuffer::getMemBuffer(_tiered_bitcode, "", false);
+    auto parsed = llvm::parseBitcodeFile(buffer->getMemBufferRef(), context);
+
+    if ( ! parsed )
+        return false;
+
+    auto module = std::move(*parsed);
+
+    // We keep the bodies of direct callees around for inlining, but
+    // don't emit them. Everything else turns into declarations that link
+    // against the first tier's code.
+    std::set<const llvm::Function*> callees;
+
+    for ( auto& f : *module ) {
+        if ( ! functions.count(f.getName()) )
+            continue;
+
+        for ( auto& b : f ) {
+            for ( auto& i : b ) {
+                llvm::CallSite cs(&i);
+
+                if ( cs && cs.getCalledFunction() )
+                    callees.insert(cs.getCalledFunction());
+            }
+        }
+    }
+
+    for ( auto& f : *module ) {
+        if ( f.isDeclaration() || functions.count(f.getName()) )
+            continue;
+
+        if ( callees.count(&f) )
+            f.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        else
+            f.deleteBody();
+    }
+
+    std::vector<llvm::GlobalVariable*> special;
+
+    for ( auto& g : module->globals() ) {
+        if ( g.getName().startswith("llvm.") ) {
+            special.push_back(&g);
+            continue;
+        }
+
+        if ( g.isDeclaration() )
+            continue;
+
+        if ( g.isConstant() )
+            g.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+
+        else {
+            g.setInitializer(nullptr);
+            g.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+
+    // Constructors and such are already taken care of by the first tier.
+    for ( auto g : special )
+        g->eraseFromParent();
+
+    llvm::StripDebugInfo(*module);
+
+    if ( llvm::verifyModule(*module) )
+        return false;
+
+    codegen::Optimizer optimizer(_ctx);
+    auto optimized = optimizer.optimize(std::move(module), true);
+
+    if ( ! optimized )
+        return false;
+
+    llvm::orc::SimpleCompiler compiler(*_tiered_target_machine);
+    auto object = std::make_unique<Object>(compiler(*optimized));
+
+    if ( ! object->getBinary() )
+        return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto resolver = llvm::orc::createLambdaResolver(
+        [&](const std::string& name) {
+            // Calls go through the stubs so that they pick up optimized
+            // code as it becomes available.
+            if ( auto sym = _lazy_layer->findSymbol(name, false) )
+                return sym.toRuntimeDyldSymbol();
+            else
+                return llvm::RuntimeDyld::SymbolInfo(nullptr);
+        },
+
+        [this](const std::string& name) { return _findExternal(name); });
+
+    std::vector<std::unique_ptr<Object>> objects;
+    objects.push_back(std::move(object));
+
+    auto mm = std::make_unique<llvm::SectionMemoryManager>();
+    auto handle =
+        _object_layer->addObjectSet(std::move(objects), std::move(mm), std::move(resolver));
+
+    for ( auto f : functions ) {
+        auto name = _mangle(f);
+
+        // Updating the stub is a single pointer write, so code that's
+        // currently executing continues safely with the old version.
+        auto sym = _object_layer->findSymbolIn(handle, name, false);
+
+        if ( ! sym )
+            continue;
+
+        _lazy_layer->updatePointer(name, sym.getAddress());
+
+        if ( _ctx->options().cgDebugging("jit") )
+            std::cerr << "JIT: swapped in optimized code for " << f << std::endl;
+    }
+
+    return true;
+}
+
 JIT::~JIT()
 {
+    if ( _tiered_thread.joinable() ) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tiered_stop = true;
+        }
+
+        _tiered_cv.notify_all();
+        _tiered_thread.join();
+    }
+
+    if ( ! _initialized )
+        return;
+
     auto jit_hlt_done = (void (*)())nativeFunction("__hlt_done");
     (*jit_hlt_done)();
 }
 
-void* JIT::nativeFunction(const string& function, bool must_exist)
+bool JIT::_loadRuntime()
+{
+    if ( ! _ctx->options().jit_native_runtime || _runtime_library )
+        return true;
+
+    auto path = _ctx->options().debug ? configuration().runtime_library_so_dbg :
+                                        configuration().runtime_library_so;
+
+    // We load the library locally so that its symbols don't get mixed up
+    // with any copy of the runtime that the host application comes with.
+    _runtime_library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+    if ( ! _runtime_library ) {
+        error(::util::fmt("cannot load native runtime library: %s", dlerror()));
+        return false;
+    }
+
+    // Catch a library that's missing the runtime, as otherwise we would
+    // silently fall back to symbols from the host process.
+    if ( ! dlsym(_runtime_library, "__hlt_runtime_state_set") ) {
+        error(::util::fmt("native runtime library %s does not provide the runtime", path));
+        dlclose(_runtime_library);
+        _runtime_library = nullptr;
+        return false;
+    }
+
+    // Don't trade the optimized bitcode for an unoptimized library.
+    if ( ! _ctx->options().debug && ! dlsym(_runtime_library, "__hlt_runtime_optimized") ) {
+        error(::util::fmt("native runtime library %s is not optimized", path));
+        dlclose(_runtime_library);
+        _runtime_library = nullptr;
+        return false;
+    }
+
+    if ( _ctx->options().cgDebugging("jit") )
+        std::cerr << "JIT: using native runtime library " << path << std::endl;
+
+    return true;
+}
+
+llvm::RuntimeDyld::SymbolInfo JIT::_findExternal(const std::string& name)
+{
+    if ( _runtime_library ) {
+        // dlsym() wants the name without the platform's symbol prefix.
+        auto cname = name;
+        auto prefix = _data_layout->getGlobalPrefix();
+
+        if ( prefix && cname.size() && cname[0] == prefix )
+            cname = cname.substr(1);
+
+        if ( auto addr = dlsym(_runtime_library, cname.c_str()) )
+            return llvm::RuntimeDyld::SymbolInfo((uint64_t)addr, llvm::JITSymbolFlags::Exported);
+    }
+
+    // Symbol lookup inside the process.
+    if ( auto symaddr = llvm::RTDyldMemoryManager::getSymbolAddressInProcess(name) )
+        return llvm::RuntimeDyld::SymbolInfo(symaddr, llvm::JITSymbolFlags::Exported);
+    else
+        return llvm::RuntimeDyld::SymbolInfo(nullptr);
+}
+
+std::string JIT::_mangle(const std::string& name) const
 {
     std::string mangled;
     llvm::raw_string_ostream mangled_stream(mangled);
-    llvm::Mangler::getNameWithPrefix(mangled_stream, function, *_data_layout);
+    llvm::Mangler::getNameWithPrefix(mangled_stream, name, *_data_layout);
+    return mangled_stream.str();
+}
 
-    if ( auto symbol = _compile_layer->findSymbol(mangled_stream.str(), true) )
+void* JIT::nativeFunction(const string& function, bool must_exist)
+{
+    if ( _shared_object ) {
+        if ( auto addr = dlsym(_shared_object, function.c_str()) )
+            return addr;
+    }
+
+    auto mangled = _mangle(function);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if ( _lazy_layer ) {
+        // This returns a stub that compiles the function on first call.
+        if ( auto symbol = _lazy_layer->findSymbol(mangled, true) )
+            return (void*)symbol.getAddress();
+    }
+
+    if ( auto symbol = _object_layer->findSymbol(mangled, true) )
         return (void*)symbol.getAddress();
 
+    lock.unlock();
+
+    // With the native runtime, the runtime's functions live there.
+    if ( _runtime_library ) {
+        if ( auto addr = dlsym(_runtime_library, function.c_str()) )
+            return addr;
+    }
+
     if ( ! must_exist )
         return nullptr;
 
@@ -151,3 +730,8 @@ void* JIT::nativeFunction(const string& function, bool must_exist)
 void JIT::_jit_init()
 {
 }
+
+bool JIT::initialized() const
+{
+    return _initialized;
+}
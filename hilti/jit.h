@@ -2,6 +2,12 @@
 #ifndef HILTI_JIT_JIT_H
 #define HILTI_JIT_JIT_H
 
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
 #include <ast/logger.h>
 
 // LLVM redefines the DEBUG macro. Sigh.
@@ -10,9 +16,12 @@
 #undef DEBUG
 #endif
 
+#include "llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
 #include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 
 #undef DEBUG
@@ -37,14 +46,54 @@ public:
     /// the runtime library. Afterwards nativeFunction() can be used to
     /// retrieve the address of compiled functions.
     ///
+    /// If Options::jit_lazy is set, this only prepares the module, and
+    /// compiles each function once it's called for the first time. That
+    /// may happen from any thread; compilation is serialized internally. In
+    /// that case, no object code is produced for caching.
+    ///
+    /// If Options::jit_tiered is set, this compiles the module quickly
+    /// without optimization, and then recompiles frequently called
+    /// functions with full optimization on a background thread, swapping
+    /// them in as they become ready. All calls go through stubs for that,
+    /// including those inside the module. No object code is produced for
+    /// caching in that case either.
+    ///
+    /// If Options::jit_native_runtime is set, the module is expected to
+    /// have been linked without the runtime bitcode, and the code links
+    /// against the natively compiled runtime library instead.
+    ///
     /// To set runtime options, the host application can use
     /// hlt_config_get/set() before calling this method.
     ///
     /// module: The module. The function takes ownership.
     ///
+    /// object_code: If given, the native object code compiled for the
+    /// module is copied into it, so that it can later be passed to
+    /// jitObject().
+    ///
     /// Returns: True if JITing succeeded. If *main_run* is true, it will
     /// have finished by the time the function returns.
-    bool jit(std::unique_ptr<llvm::Module> module);
+    bool jit(std::unique_ptr<llvm::Module> module, std::string* object_code = nullptr);
+
+    /// Loads native object code that jit() produced earlier, and then
+    /// initializes the runtime library just like jit() does. This skips
+    /// all code generation.
+    ///
+    /// object_code: The object code.
+    ///
+    /// Returns: True if loading succeeded.
+    bool jitObject(const std::string& object_code);
+
+    /// Loads a shared library that
+    /// CompilerContext::compileSharedObject() produced, and then
+    /// initializes the runtime library just like jit() does. The
+    /// library's functions then become available through
+    /// nativeFunction().
+    ///
+    /// path: The path of the library.
+    ///
+    /// Returns: True if loading succeeded.
+    bool jitSharedObject(const std::string& path);
 
     /// Returns a pointer to a compiled, native function after a module has
     /// beed JITed. Must only be called after jit() signaled success.
@@ -54,6 +103,9 @@ public:
     /// must_exist: If true, the method aborts the process with a fatal error
     /// if the function does not exist in the compiled code.
     ///
+    /// With Options::jit_native_runtime, this also finds functions of the
+    /// native runtime library.
+    ///
     /// Returns: A pointer to the function (which must be suitably casted),
     /// or null if that function doesn't exist and *must_exist* is false.
     void* nativeFunction(const string& function, bool must_exist = true);
@@ -63,16 +115,98 @@ protected:
     // implementations do nothing.
     virtual void _jit_init();
 
+    // Returns true once the runtime library has been initialized.
+    bool initialized() const;
+
 private:
+    typedef llvm::object::OwningBinary<llvm::object::ObjectFile> Object;
+
+    // Provides the lazy layer's compile callbacks, serializing them with
+    // _mutex. Defined in jit.cc.
+    class CompileCallbackManager;
+
+    // Adds compiled code to the JIT and initializes the runtime.
+    bool _jit(std::unique_ptr<Object> object);
+
+    // Adds a module to the JIT for lazy compilation and initializes the
+    // runtime.
+    bool _jitLazy(std::unique_ptr<llvm::Module> module);
+
+    // Initializes the runtime once code has been added.
+    bool _initRuntime();
+
+    // Loads the native runtime library if Options::jit_native_runtime is
+    // set. Does nothing otherwise, or if already loaded.
+    bool _loadRuntime();
+
+    // Resolves a symbol that's not defined by the JITed code itself.
+    llvm::RuntimeDyld::SymbolInfo _findExternal(const std::string& name);
+
+    // Returns the set of functions to compile when *func* is called for
+    // the first time.
+    std::set<llvm::Function*> _partition(llvm::Function& func);
+
+    // Returns the name of a symbol as the JIT's layers know it.
+    std::string _mangle(const std::string& name) const;
+
+    // Prepares a module for tiered compilation by giving all symbols
+    // external names and adding call counters. Stores a copy of the module
+    // without the counters for recompilation.
+    void _prepareTiering(llvm::Module* module);
+
+    // Starts the background thread that recompiles hot functions.
+    void _startTiering();
+
+    // Main loop of the background thread.
+    void _tieringLoop();
+
+    // Recompiles a set of functions with optimization and redirects their
+    // stubs to the new code.
+    bool _recompile(const std::set<std::string>& functions);
+
     CompilerContext* _ctx;
+    bool _initialized = false;
 
     typedef llvm::orc::ObjectLinkingLayer<> ObjectLayer;
     typedef llvm::orc::IRCompileLayer<ObjectLayer> CompileLayer;
+    typedef llvm::orc::CompileOnDemandLayer<CompileLayer> LazyLayer;
 
     std::unique_ptr<llvm::DataLayout> _data_layout;
     std::unique_ptr<llvm::TargetMachine> _target_machine;
     std::unique_ptr<ObjectLayer> _object_layer;
+
+    // Handle of the native runtime library, if loaded. We never unload it.
+    void* _runtime_library = nullptr;
+
+    // Handle of a precompiled shared library, if loaded. We never unload
+    // it either.
+    void* _shared_object = nullptr;
+
+    // Set up only for lazy compilation. The module being compiled lazily
+    // lives in _lazy_context for the lifetime of the JIT.
+    std::unique_ptr<llvm::LLVMContext> _lazy_context;
+    std::unique_ptr<CompileCallbackManager> _callbacks;
     std::unique_ptr<CompileLayer> _compile_layer;
+    std::unique_ptr<LazyLayer> _lazy_layer;
+
+    // Serializes access to the layers once code is running, by compile
+    // callbacks as well as by the tiering thread.
+    mutable std::mutex _mutex;
+
+    // State for tiered compilation.
+    struct TieredFunction {
+        std::string name;                   // Name of the function.
+        std::string counter;                // Name of its call counter.
+        volatile uint64_t* calls = nullptr; // The call counter, once the code is in place.
+        bool optimized = false;             // True once it has been recompiled.
+    };
+
+    std::vector<TieredFunction> _tiered_functions;
+    std::string _tiered_bitcode;
+    std::unique_ptr<llvm::TargetMachine> _tiered_target_machine;
+    std::thread _tiered_thread;
+    std::condition_variable _tiered_cv;
+    bool _tiered_stop = false;
 };
 }
 
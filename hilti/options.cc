@@ -9,6 +9,9 @@ Options::Options()
 {
     optimizations = optimizationLabels();
 
+    for ( auto o : optionalOptimizationLabels() )
+        optimizations.erase(o);
+
     libdirs_hlt.push_back(".");
 
     for ( auto p : hilti::configuration().hilti_library_dirs )
@@ -28,12 +31,29 @@ bool Options::cgDebugging(const string& label) const
 Options::string_set Options::cgDebugLabels() const
 {
     return {"codegen",  "linker",    "parser",   "scanner", "scopes", "context",
-            "dump-ast", "print-ast", "visitors", "cache",   "time",   "liveness"};
+            "dump-ast", "print-ast", "visitors", "cache",   "time",   "liveness",
+            "jit",      "optimizer"};
 }
 
 Options::string_set Options::optimizationLabels() const
 {
-    return string_set();
+    return {"hookgroups", "typeinfo"};
+}
+
+Options::string_set Options::optionalOptimizationLabels() const
+{
+    return {"hookgroups"};
+}
+
+bool Options::enableOptimization(const string& label)
+{
+    auto optional = optionalOptimizationLabels();
+
+    if ( optional.find(label) == optional.end() )
+        return false;
+
+    optimizations.insert(label);
+    return true;
 }
 
 void Options::toCacheKey(::util::cache::FileCache::Key* key) const
@@ -42,6 +62,14 @@ void Options::toCacheKey(::util::cache::FileCache::Key* key) const
     key->options += (optimize ? "O" : "o");
     key->options += (profile ? ::util::fmt("P%d", profile) : "p");
     key->options += (verify ? "V" : "v");
+    key->options += (jit_native_runtime ? "N" : "n");
+    key->options += (jit && jit_tiered ? "T" : "t"); // Skips pre-link optimization.
+    key->options += (pgo_generate ? "G" : "g");
+
+    if ( pgo_use.size() ) {
+        key->options += "U";
+        key->files.insert(pgo_use);
+    }
 
     for ( auto d : libdirs_hlt )
         key->dirs.insert(d);
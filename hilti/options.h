@@ -40,6 +40,20 @@ public:
     /// included. Enabling profiling has a significant performance impact.
     unsigned int profile = 0;
 
+    /// If true, include instrumentation for profile-guided optimization into
+    /// generated code. It counts how often each function runs and how often
+    /// each branch goes which way. When the runtime terminates, it appends
+    /// the counts to a profile file (\c hlt.pgo.dat by default, see \c
+    /// hlt_config). Compiling again with \a pgo_use pointing to the file
+    /// then optimizes the code for what the training runs saw.
+    bool pgo_generate = false;
+
+    /// If set, the path to a profile recorded by code compiled with \a
+    /// pgo_generate. Code generation uses it to set LLVM branch weights and
+    /// function entry counts, and to mark functions as hot or cold. The
+    /// profile must come from the same code compiled with the same options.
+    string pgo_use;
+
     /// If true, all generated code is verified for correctness. Disabling
     /// this is primarily for debugging purposes.
     bool verify = true;
@@ -49,6 +63,29 @@ public:
     /// aborts if it's not set.
     bool jit = false;
 
+    /// If true, the JIT compiles each function only when it's called for
+    /// the first time, rather than the whole module up front. This speeds
+    /// up startup when much of the code will never run.
+    bool jit_lazy = false;
+
+    /// If true, the JIT first compiles all code quickly without
+    /// optimization, and then recompiles functions that turn out to be hot
+    /// in a background thread, using the optimizer at \a opt_level. The
+    /// optimized code replaces the original version while running.
+    bool jit_tiered = false;
+
+    /// With \a jit_tiered, the number of calls after which a function
+    /// counts as hot and gets recompiled.
+    unsigned int jit_tiered_threshold = 1000;
+
+    /// If true, JITed code links against a natively compiled, optimized
+    /// version of the runtime library rather than having the library's
+    /// bitcode linked in and optimized along with it. Only a few small,
+    /// frequently used runtime functions are still pulled in as bitcode so
+    /// that they can be inlined. This speeds up linking and optimization,
+    /// which then depend only on the size of the generated code.
+    bool jit_native_runtime = false;
+
     /// List of directories to search for imports and other \c *.hlt library
     /// files. The current directory will always be tried first. By default,
     /// this set is set to the current directory plus the installation-wide
@@ -57,7 +94,8 @@ public:
 
     /// A set of labels specifying HILTI optimization passes to run when \a
     /// optimize is true. optimizationLabels() returns a list of valid
-    /// labels. By default, this set contains all of them.
+    /// labels. By default, this set contains all of them except those
+    /// returned by optionalOptimizationLabels().
     string_set optimizations;
 
     /// A set of labels specifying parts of the code generator that will
@@ -69,6 +107,10 @@ public:
     /// is disabled.
     string module_cache;
 
+    /// The number of worker processes to use when compiling a set of
+    /// independent modules into LLVM. 1 compiles them sequentially.
+    unsigned int jobs = 1;
+
     /// Returns true if the given label is enabled in \a optimization. This
     /// is just a convinience method.
     bool optimizing(const string& label) const;
@@ -76,6 +118,19 @@ public:
     /// Returns all available HILTI optimization passes.
     virtual string_set optimizationLabels() const;
 
+    /// Returns the optimization passes that need to be enabled explicitly
+    /// because they change behavior that host applications may rely on.
+    string_set optionalOptimizationLabels() const;
+
+    /// Adds one of the optional optimization passes to \a optimizations.
+    ///
+    /// label: The pass to enable; must be one returned by
+    /// optionalOptimizationLabels().
+    ///
+    /// Returns: False if the label isn't a known optional pass, in which
+    /// case nothing changes.
+    bool enableOptimization(const string& label);
+
     /// Returns true if the given label is enabled in cg_debug. This is just
     /// a convinience method.
     bool cgDebugging(const string& label) const;
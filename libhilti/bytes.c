@@ -25,6 +25,26 @@ static const int _BYTES_FLAG_FROZEN = 1;
 // object aren't valid in this case, and set to null.
 static const int _BYTES_FLAG_OBJECT = 2;
 
+// Data of this node lives in externally managed memory. The to_free field
+// then points to the hlt_bytes_backing that keeps that memory alive, and we
+// release a reference to it rather than freeing it.
+static const int _BYTES_FLAG_BACKING = 4;
+
+// Node has been hoisted to the stack. Its memory can't be shared.
+static const int _BYTES_FLAG_HOISTED = 16;
+
+// Minimum size of a range for hlt_bytes_sub() to share the source's memory
+// rather than copying it. For smaller ranges, a copy is just as cheap and
+// doesn't keep the source's memory alive.
+static const size_t __HLT_BYTES_MIN_VIEW = 64;
+
+// Backing taking over a chunk's heap memory once a view starts sharing it,
+// so that it remains alive as long as either references it.
+typedef struct {
+    hlt_bytes_backing backing;
+    int8_t* data;
+} __hlt_bytes_heap_backing;
+
 // Layout here must match libhilti.ll!
 struct __hlt_bytes {
     __hlt_gchdr __gchdr;                  // Header for memory management.
@@ -115,6 +135,20 @@ static inline int8_t __is_end(const hlt_iterator_bytes p)
            __at_object(p);
 }
 
+static inline void __release_data(hlt_bytes* b, hlt_execution_context* ctx)
+{
+    if ( ! b->to_free )
+        return;
+
+    if ( b->flags & _BYTES_FLAG_BACKING )
+        hlt_bytes_backing_unref((hlt_bytes_backing*)b->to_free);
+
+    else
+        hlt_free(b->to_free);
+
+    b->to_free = 0;
+}
+
 static inline int8_t __is_frozen(const hlt_bytes* b)
 {
     return b ? (b->flags & _BYTES_FLAG_FROZEN) : false;
@@ -439,7 +473,7 @@ static inline void _hlt_bytes_init_hoisted(__hlt_bytes_hoisted* dst, const int8_
         b->to_free = b->start;
     }
 
-    b->flags = 0;
+    b->flags = _BYTES_FLAG_HOISTED;
     b->offset = 0;
     b->next = 0;
     b->end = b->start + len;
@@ -520,8 +554,7 @@ void hlt_bytes_dtor(hlt_type_info* ti, hlt_bytes* b, hlt_execution_context* ctx)
     }
 
     else {
-        if ( b->to_free )
-            hlt_free(b->to_free);
+        __release_data(b, ctx);
 
         if ( b->marks )
             hlt_free(b->marks);
@@ -555,6 +588,28 @@ hlt_bytes* hlt_bytes_new_from_data(int8_t* data, hlt_bytes_size len, hlt_excepti
     return _hlt_bytes_new_reuse(data, len, ctx);
 }
 
+hlt_bytes* hlt_bytes_new_from_backing(const int8_t* data, hlt_bytes_size len,
+                                      hlt_bytes_backing* backing, hlt_exception** excpt,
+                                      hlt_execution_context* ctx)
+{
+    hlt_bytes* b = _hlt_bytes_new_reuse((int8_t*)data, len, ctx);
+    b->flags = _BYTES_FLAG_BACKING;
+    b->to_free = (int8_t*)backing;
+    hlt_bytes_backing_ref(backing);
+    return b;
+}
+
+void hlt_bytes_backing_ref(hlt_bytes_backing* backing)
+{
+    __atomic_add_fetch(&backing->ref_cnt, 1, __ATOMIC_RELAXED);
+}
+
+void hlt_bytes_backing_unref(hlt_bytes_backing* backing)
+{
+    if ( __atomic_sub_fetch(&backing->ref_cnt, 1, __ATOMIC_ACQ_REL) == 0 )
+        backing->release(backing);
+}
+
 void hlt_bytes_new_from_data_copy_hoisted(__hlt_bytes_hoisted* dst, const int8_t* data,
                                           hlt_bytes_size len, hlt_exception** excpt,
                                           hlt_execution_context* ctx)
@@ -590,7 +645,7 @@ void hlt_bytes_clone_init(void* dstp, const hlt_type_info* ti, void* srcp,
 
     assert(src && dst);
 
-    dst->flags = src->flags;
+    dst->flags = (src->flags & ~(_BYTES_FLAG_BACKING | _BYTES_FLAG_HOISTED));
     dst->offset = src->offset;
     dst->marks = 0;
 
@@ -1334,6 +1389,48 @@ void hlt_bytes_sub_hoisted(__hlt_bytes_hoisted* dst, hlt_iterator_bytes p1, hlt_
     __hlt_bytes_sub_raw_internal(dst->b.start, &dst->b.marks, len, len, p1, p2, excpt, ctx);
 }
 
+static void __heap_backing_release(hlt_bytes_backing* backing)
+{
+    __hlt_bytes_heap_backing* hb = (__hlt_bytes_heap_backing*)backing;
+    hlt_free(hb->data);
+    hlt_free(hb);
+}
+
+// Returns a new node referencing the range [first, last) of src's data
+// without copying it. Returns null if src's memory can't be shared. That's
+// the case for data stored inline with the node: keeping the node alive
+// would, through its next pointer, keep alive all subsequent chunks as well,
+// even once trimmed.
+static hlt_bytes* __hlt_bytes_view(hlt_bytes* src, int8_t* first, int8_t* last,
+                                   hlt_execution_context* ctx)
+{
+    if ( src->flags & (_BYTES_FLAG_OBJECT | _BYTES_FLAG_HOISTED) )
+        return 0;
+
+    if ( ! src->to_free )
+        return 0;
+
+    if ( ! (src->flags & _BYTES_FLAG_BACKING) ) {
+        // Turn the heap memory the node owns into a backing that both share.
+        __hlt_bytes_heap_backing* hb = hlt_malloc(sizeof(__hlt_bytes_heap_backing));
+        hb->backing.ref_cnt = 1;
+        hb->backing.release = __heap_backing_release;
+        hb->data = src->to_free;
+
+        src->flags |= _BYTES_FLAG_BACKING;
+        src->to_free = (int8_t*)hb;
+    }
+
+    hlt_bytes* b = _hlt_bytes_new_reuse(first, last - first, ctx);
+    b->flags = _BYTES_FLAG_BACKING;
+    b->to_free = src->to_free;
+    hlt_bytes_backing_ref((hlt_bytes_backing*)b->to_free);
+
+    __hlt_bytes_copy_marks(&b->marks, src, first, last, (src->start - first));
+
+    return b;
+}
+
 hlt_bytes* hlt_bytes_sub(hlt_iterator_bytes p1, hlt_iterator_bytes p2, hlt_exception** excpt,
                          hlt_execution_context* ctx)
 {
@@ -1341,6 +1438,14 @@ hlt_bytes* hlt_bytes_sub(hlt_iterator_bytes p1, hlt_iterator_bytes p2, hlt_excep
     __normalize_iter(&p2);
 
     hlt_bytes_size len = __hlt_iterator_bytes_diff(p1, p2, excpt, ctx);
+
+    if ( len >= __HLT_BYTES_MIN_VIEW && p1.bytes && p1.bytes == p2.bytes ) {
+        // Range is inside a single chunk, share its memory.
+        hlt_bytes* view = __hlt_bytes_view(p1.bytes, p1.cur, p2.cur, ctx);
+
+        if ( view )
+            return view;
+    }
     hlt_bytes* dst = _hlt_bytes_new(0, len, 0, ctx);
 
     if ( ! len )
@@ -1560,8 +1665,7 @@ void hlt_bytes_trim(hlt_bytes* b, hlt_iterator_bytes p, hlt_exception** excpt,
     }
 
     else if ( b->to_free ) {
-        hlt_free(b->to_free);
-        b->to_free = 0;
+        __release_data(b, ctx);
 
         if ( b->marks )
             hlt_free(b->marks);
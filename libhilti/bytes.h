@@ -100,6 +100,40 @@ extern hlt_bytes* hlt_bytes_new_from_data(int8_t* data, hlt_bytes_size len, hlt_
 extern hlt_bytes* hlt_bytes_new_from_data_copy(const int8_t* data, hlt_bytes_size len,
                                                hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Memory managed outside of a bytes object that bytes instances can
+/// reference without copying, such as a memory-mapped file. Embed this as
+/// the first field of a custom structure, initialize *ref_cnt* to 1 for the
+/// creator's reference, and set *release* to a function that frees the
+/// structure once the last reference goes away. The counter is updated
+/// atomically, so bytes referencing the memory may be passed across threads.
+typedef struct __hlt_bytes_backing {
+    int64_t ref_cnt;                                   ///< Number of references.
+    void (*release)(struct __hlt_bytes_backing* self); ///< Called when reaching zero.
+} hlt_bytes_backing;
+
+/// Instantiates a new bytes object pointing to raw data inside a
+/// ~~hlt_bytes_backing. The data is not copied; instead, the bytes object
+/// keeps a reference to the backing until it is destroyed. The data must
+/// not be modified as long as the backing is alive.
+///
+/// data: Pointer to the raw bytes inside *backing*'s memory.
+///
+/// len: Number of raw byes starting at *data*.
+///
+/// backing: The backing keeping *data* alive.
+///
+/// Returns: The new bytes object.
+extern hlt_bytes* hlt_bytes_new_from_backing(const int8_t* data, hlt_bytes_size len,
+                                             hlt_bytes_backing* backing, hlt_exception** excpt,
+                                             hlt_execution_context* ctx);
+
+/// Adds a reference to a ~~hlt_bytes_backing.
+extern void hlt_bytes_backing_ref(hlt_bytes_backing* backing);
+
+/// Removes a reference from a ~~hlt_bytes_backing, releasing it if it was
+/// the last one.
+extern void hlt_bytes_backing_unref(hlt_bytes_backing* backing);
+
 /// Returns the number of individual bytes stored in a bytes object.
 ///
 /// b: The bytes object.
@@ -237,7 +271,11 @@ extern hlt_bytes_find_at_iter_result hlt_bytes_find_bytes_at_iter(hlt_iterator_b
 extern int8_t hlt_bytes_match_at(hlt_iterator_bytes pos, hlt_bytes* b, hlt_exception** excpt,
                                  hlt_execution_context* ctx);
 
-/// Returns a subsequence of a bytes object.
+/// Returns a subsequence of a bytes object. If the subsequence is larger
+/// than a few bytes, doesn't span multiple chunks, and the chunk's data
+/// lives in separately allocated or externally backed memory, the new
+/// object shares that memory with the source rather than copying it,
+/// keeping just the memory alive as long as needed.
 ///
 /// start: The start of the subsequence.
 /// end: The end of the subsequence; *end* itself is not included anymore.
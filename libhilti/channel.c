@@ -14,15 +14,19 @@
  */
 
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "channel.h"
 #include "clone.h"
 #include "string_.h"
+#include "vector.h"
 
 #define INITIAL_CHUNK_SIZE (1 << 8)
 #define MAX_CHUNK_SIZE (1 << 14)
+#define DEFAULT_SPSC_CAPACITY (1 << 10)
+#define CACHE_LINE_SIZE 64
 
 // A gc'ed chunk of memory used by the channel.
 typedef struct __hlt_channel_chunk {
@@ -51,6 +55,26 @@ typedef struct {
     pthread_mutex_t mutex;   /* Synchronizes access to the channel. */
     pthread_cond_t empty_cv; /* Condition variable for an empty channel. */
     pthread_cond_t full_cv;  /* Condition variable for a full channel. */
+
+    int8_t spsc; /* True if in single-producer/single-consumer mode. */
+
+    // The remaining fields are used only in single-producer/single-consumer
+    // mode, where none of the chunk fields above are. Producer and consumer
+    // each get their own cache line, holding their index along with the
+    // last value they have seen of the other side's index.
+    char* ring;       /* Ring buffer, with space for ring_mask + 1 items. */
+    size_t ring_mask; /* Ring size minus one; the size is a power of two. */
+    char* read_slot;  /* Consumer-owned copy of the item read last. */
+
+    char pad1[CACHE_LINE_SIZE];
+    size_t ring_tail;   /* Index of next slot to write, written only by the producer. */
+    size_t cached_head; /* The producer's last view of ring_head. */
+
+    char pad2[CACHE_LINE_SIZE];
+    size_t ring_head;   /* Index of next slot to read, written only by the consumer. */
+    size_t cached_tail; /* The consumer's last view of ring_tail. */
+
+    char pad3[CACHE_LINE_SIZE];
 } __hlt_channel_shared;
 
 struct __hlt_channel {
@@ -59,6 +83,8 @@ struct __hlt_channel {
 };
 
 static void* _hlt_channel_read_item(hlt_channel* ch, hlt_execution_context* ctx);
+static size_t _spsc_available(__hlt_channel_shared* shared);
+static void* _spsc_read_item(__hlt_channel_shared* shared, hlt_execution_context* ctx);
 
 void hlt_channel_dtor(hlt_type_info* ti, hlt_channel* ch, hlt_execution_context* ctx)
 {
@@ -75,6 +101,15 @@ void hlt_channel_dtor(hlt_type_info* ti, hlt_channel* ch, hlt_execution_context*
 
     pthread_mutex_unlock(&shared->mutex);
 
+    if ( shared->spsc ) {
+        while ( _spsc_available(shared) )
+            _spsc_read_item(shared, ctx);
+
+        hlt_free(shared->ring);
+        hlt_free(shared->read_slot);
+        goto destroy;
+    }
+
     while ( shared->size )
         _hlt_channel_read_item(ch, ctx);
 
@@ -87,6 +122,7 @@ void hlt_channel_dtor(hlt_type_info* ti, hlt_channel* ch, hlt_execution_context*
         rc = next;
     }
 
+destroy:
     pthread_mutex_destroy(&shared->mutex);
     pthread_cond_destroy(&shared->empty_cv);
     pthread_cond_destroy(&shared->full_cv);
@@ -117,8 +153,21 @@ static hlt_channel_chunk* _hlt_chunk_create(size_t capacity, int16_t item_size,
     return chunk;
 }
 
-// Internal helper function performing a read operation.
-static inline void* _hlt_channel_read_item(hlt_channel* ch, hlt_execution_context* ctx)
+// Internal helper function copying an item into a channel slot.
+static inline void _hlt_channel_copy_in(__hlt_channel_shared* shared, char* slot, void* data,
+                                        hlt_exception** excpt, hlt_execution_context* ctx)
+{
+#ifndef HLT_NO_DEEP_COPY_VALUES_ACROSS_THREADS
+    hlt_clone_deep(slot, shared->type, data, excpt, ctx);
+#else
+    memcpy(slot, data, shared->type->size);
+    GC_CCTOR_GENERIC(slot, shared->type, ctx);
+#endif
+}
+
+// Internal helper function advancing the reader to the next item, and
+// returning it. The caller takes over the channel's reference to the item.
+static inline void* _hlt_channel_next_item(hlt_channel* ch)
 {
     __hlt_channel_shared* shared = ch->shared;
 
@@ -135,8 +184,14 @@ static inline void* _hlt_channel_read_item(hlt_channel* ch, hlt_execution_contex
     shared->head += shared->type->size;
     --shared->size;
 
-    GC_DTOR_GENERIC(item, shared->type, ctx);
+    return item;
+}
 
+// Internal helper function performing a read operation.
+static inline void* _hlt_channel_read_item(hlt_channel* ch, hlt_execution_context* ctx)
+{
+    void* item = _hlt_channel_next_item(ch);
+    GC_DTOR_GENERIC(item, ch->shared->type, ctx);
     return item;
 }
 
@@ -163,12 +218,7 @@ static inline int _hlt_channel_write_item(hlt_channel* ch, void* data, hlt_excep
         shared->tail = shared->wc->data;
     }
 
-#ifndef HLT_NO_DEEP_COPY_VALUES_ACROSS_THREADS
-    hlt_clone_deep(shared->tail, shared->type, data, excpt, ctx);
-#else
-    memcpy(shared->tail, data, shared->type->size);
-    GC_CCTOR_GENERIC(shared->tail, shared->type, ctx);
-#endif
+    _hlt_channel_copy_in(shared, shared->tail, data, excpt, ctx);
 
     ++shared->wc->wcnt;
 
@@ -178,6 +228,55 @@ static inline int _hlt_channel_write_item(hlt_channel* ch, void* data, hlt_excep
     return 0;
 }
 
+// Returns true if the producer can write another n items into the ring
+// buffer. Must only be called by the producer.
+static inline int _spsc_has_space(__hlt_channel_shared* shared, size_t n)
+{
+    if ( shared->ring_tail + n - shared->cached_head <= (size_t)shared->capacity )
+        return 1;
+
+    shared->cached_head = __atomic_load_n(&shared->ring_head, __ATOMIC_ACQUIRE);
+    return shared->ring_tail + n - shared->cached_head <= (size_t)shared->capacity;
+}
+
+static inline char* _spsc_slot(__hlt_channel_shared* shared, size_t idx)
+{
+    return shared->ring + (idx & shared->ring_mask) * shared->type->size;
+}
+
+// Returns the number of items the consumer can read from the ring buffer.
+// Must only be called by the consumer.
+static inline size_t _spsc_available(__hlt_channel_shared* shared)
+{
+    if ( shared->cached_tail == shared->ring_head )
+        shared->cached_tail = __atomic_load_n(&shared->ring_tail, __ATOMIC_ACQUIRE);
+
+    return shared->cached_tail - shared->ring_head;
+}
+
+// Reads the next item from the ring buffer, which must not be empty. The
+// item gets copied into the consumer's slot first as the producer may
+// reuse its ring position right away.
+static inline void* _spsc_read_item(__hlt_channel_shared* shared, hlt_execution_context* ctx)
+{
+    size_t head = shared->ring_head;
+    memcpy(shared->read_slot, _spsc_slot(shared, head), shared->type->size);
+    __atomic_store_n(&shared->ring_head, head + 1, __ATOMIC_RELEASE);
+
+    GC_DTOR_GENERIC(shared->read_slot, shared->type, ctx);
+
+    return shared->read_slot;
+}
+
+// Writes an item into the ring buffer, which must have space for it.
+static inline void _spsc_write_item(__hlt_channel_shared* shared, void* data,
+                                    hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    size_t tail = shared->ring_tail;
+    _hlt_channel_copy_in(shared, _spsc_slot(shared, tail), data, excpt, ctx);
+    __atomic_store_n(&shared->ring_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
 void* hlt_channel_clone_alloc(const hlt_type_info* ti, void* srcp, __hlt_clone_state* cstate,
                               hlt_exception** excpt, hlt_execution_context* ctx)
 {
@@ -212,6 +311,9 @@ static inline void _hlt_channel_init(hlt_channel* ch, const hlt_type_info* item_
     shared->type = item_type;
     shared->capacity = capacity;
     shared->size = 0;
+    shared->spsc = 0;
+    shared->ring = 0;
+    shared->read_slot = 0;
 
     shared->chunk_cap = INITIAL_CHUNK_SIZE;
     shared->rc = shared->wc = _hlt_chunk_create(shared->chunk_cap, shared->type->size, excpt, ctx);
@@ -235,11 +337,56 @@ hlt_channel* hlt_channel_new(const hlt_type_info* item_type, hlt_channel_capacit
     return ch;
 }
 
+hlt_channel* hlt_channel_new_spsc(const hlt_type_info* item_type, hlt_channel_capacity capacity,
+                                  hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    hlt_channel* ch = GC_NEW(hlt_channel, ctx);
+
+    __hlt_channel_shared* shared = hlt_malloc(sizeof(__hlt_channel_shared));
+    ch->shared = shared;
+
+    if ( capacity <= 0 )
+        capacity = DEFAULT_SPSC_CAPACITY;
+
+    size_t ring_size = 1;
+
+    while ( ring_size < (size_t)capacity )
+        ring_size <<= 1;
+
+    shared->ref_cnt = 1;
+    shared->type = item_type;
+    shared->capacity = capacity;
+    shared->size = 0;
+    shared->spsc = 1;
+    shared->rc = shared->wc = 0;
+    shared->head = shared->tail = 0;
+
+    shared->ring = hlt_malloc(ring_size * item_type->size);
+    shared->ring_mask = ring_size - 1;
+    shared->read_slot = hlt_malloc(item_type->size);
+    shared->ring_tail = shared->cached_head = 0;
+    shared->ring_head = shared->cached_tail = 0;
+
+    pthread_mutex_init(&shared->mutex, NULL);
+    pthread_cond_init(&shared->empty_cv, NULL);
+    pthread_cond_init(&shared->full_cv, NULL);
+
+    return ch;
+}
+
 void hlt_channel_write(hlt_channel* ch, const hlt_type_info* type, void* data,
                        hlt_exception** excpt, hlt_execution_context* ctx)
 {
     __hlt_channel_shared* shared = ch->shared;
 
+    if ( shared->spsc ) {
+        while ( ! _spsc_has_space(shared, 1) )
+            sched_yield();
+
+        _spsc_write_item(shared, data, excpt, ctx);
+        return;
+    }
+
     pthread_mutex_lock(&shared->mutex);
 
     if ( _hlt_channel_write_item(ch, data, excpt, ctx) )
@@ -257,6 +404,16 @@ void hlt_channel_write_try(hlt_channel* ch, const hlt_type_info* type, void* dat
 {
     __hlt_channel_shared* shared = ch->shared;
 
+    if ( shared->spsc ) {
+        if ( ! _spsc_has_space(shared, 1) ) {
+            hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+            return;
+        }
+
+        _spsc_write_item(shared, data, excpt, ctx);
+        return;
+    }
+
     pthread_mutex_lock(&shared->mutex);
 
     if ( shared->capacity && shared->size == shared->capacity ) {
@@ -274,10 +431,68 @@ unlock_exit:
     return;
 }
 
+void hlt_channel_write_batch_try(hlt_channel* ch, hlt_vector* items, hlt_exception** excpt,
+                                 hlt_execution_context* ctx)
+{
+    __hlt_channel_shared* shared = ch->shared;
+
+    hlt_vector_idx n = hlt_vector_size(items, excpt, ctx);
+
+    if ( shared->capacity && n > shared->capacity ) {
+        hlt_set_exception(excpt, &hlt_exception_value_error, 0, ctx);
+        return;
+    }
+
+    if ( shared->spsc ) {
+        if ( ! _spsc_has_space(shared, n) ) {
+            hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+            return;
+        }
+
+        // Fill all slots first, then publish them with a single store.
+        size_t tail = shared->ring_tail;
+
+        for ( hlt_vector_idx i = 0; i < n; i++ ) {
+            void* item = hlt_vector_get(items, i, excpt, ctx);
+            _hlt_channel_copy_in(shared, _spsc_slot(shared, tail + i), item, excpt, ctx);
+        }
+
+        __atomic_store_n(&shared->ring_tail, tail + n, __ATOMIC_RELEASE);
+        return;
+    }
+
+    pthread_mutex_lock(&shared->mutex);
+
+    if ( shared->capacity && shared->capacity - shared->size < n ) {
+        hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+        goto unlock_exit;
+    }
+
+    for ( hlt_vector_idx i = 0; i < n; i++ ) {
+        void* item = hlt_vector_get(items, i, excpt, ctx);
+
+        if ( _hlt_channel_write_item(ch, item, excpt, ctx) )
+            goto unlock_exit;
+    }
+
+    pthread_cond_broadcast(&shared->empty_cv);
+
+unlock_exit:
+    pthread_mutex_unlock(&shared->mutex);
+    return;
+}
+
 void* hlt_channel_read(hlt_channel* ch, hlt_exception** excpt, hlt_execution_context* ctx)
 {
     __hlt_channel_shared* shared = ch->shared;
 
+    if ( shared->spsc ) {
+        while ( ! _spsc_available(shared) )
+            sched_yield();
+
+        return _spsc_read_item(shared, ctx);
+    }
+
     pthread_mutex_lock(&shared->mutex);
 
     while ( shared->size == 0 )
@@ -295,6 +510,15 @@ void* hlt_channel_read_try(hlt_channel* ch, hlt_exception** excpt, hlt_execution
 {
     __hlt_channel_shared* shared = ch->shared;
 
+    if ( shared->spsc ) {
+        if ( ! _spsc_available(shared) ) {
+            hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+            return 0;
+        }
+
+        return _spsc_read_item(shared, ctx);
+    }
+
     pthread_mutex_lock(&shared->mutex);
 
     void* item = 0;
@@ -313,11 +537,79 @@ unlock_exit:
     return item;
 }
 
+hlt_vector* hlt_channel_read_batch_try(hlt_channel* ch, int64_t max, const hlt_type_info* type,
+                                       void* def, hlt_exception** excpt,
+                                       hlt_execution_context* ctx)
+{
+    __hlt_channel_shared* shared = ch->shared;
+
+    hlt_vector* v = 0;
+
+    if ( shared->spsc ) {
+        size_t n = _spsc_available(shared);
+
+        if ( ! n ) {
+            hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+            return 0;
+        }
+
+        if ( max > 0 && n > (size_t)max )
+            n = max;
+
+        v = hlt_vector_new(shared->type, def, 0, excpt, ctx);
+        hlt_vector_reserve(v, n, excpt, ctx);
+
+        // Take all items first, then release their slots with a single
+        // store.
+        size_t head = shared->ring_head;
+
+        for ( size_t i = 0; i < n; i++ ) {
+            char* slot = _spsc_slot(shared, head + i);
+            hlt_vector_push_back(v, shared->type, slot, excpt, ctx);
+            GC_DTOR_GENERIC(slot, shared->type, ctx);
+        }
+
+        __atomic_store_n(&shared->ring_head, head + n, __ATOMIC_RELEASE);
+        return v;
+    }
+
+    pthread_mutex_lock(&shared->mutex);
+
+    if ( shared->size == 0 ) {
+        hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+        goto unlock_exit;
+    }
+
+    hlt_channel_capacity n = shared->size;
+
+    if ( max > 0 && n > max )
+        n = max;
+
+    v = hlt_vector_new(shared->type, def, 0, excpt, ctx);
+    hlt_vector_reserve(v, n, excpt, ctx);
+
+    for ( hlt_channel_capacity i = 0; i < n; i++ ) {
+        void* item = _hlt_channel_next_item(ch);
+        hlt_vector_push_back(v, shared->type, item, excpt, ctx);
+        GC_DTOR_GENERIC(item, shared->type, ctx);
+    }
+
+    pthread_cond_broadcast(&shared->full_cv);
+
+unlock_exit:
+    pthread_mutex_unlock(&shared->mutex);
+    return v;
+}
+
 hlt_channel_capacity hlt_channel_size(hlt_channel* ch, hlt_exception** excpt,
                                       hlt_execution_context* ctx)
 {
     __hlt_channel_shared* shared = ch->shared;
 
+    if ( shared->spsc )
+        return __atomic_load_n(&shared->ring_tail, __ATOMIC_ACQUIRE) -
+               __atomic_load_n(&shared->ring_head, __ATOMIC_ACQUIRE);
+
     return shared->size;
 }
 
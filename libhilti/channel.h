@@ -9,6 +9,7 @@
 
 #include "exceptions.h"
 #include "types.h"
+#include "vector.h"
 
 /// Type for current size and capacity of a channel.
 typedef int64_t hlt_channel_capacity;
@@ -27,6 +28,23 @@ typedef struct __hlt_channel hlt_channel;
 extern hlt_channel* hlt_channel_new(const hlt_type_info* item_type, hlt_channel_capacity capacity,
                                     hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Creates a new channel in single-producer/single-consumer mode. The
+/// channel is backed by a lock-free ring buffer and must be written only by
+/// a single thread, and read only by a single (other) thread. Such a channel
+/// is always bounded.
+///
+/// item_type: The type of the items written into the channel.
+///
+/// capacity: The maximum capacity of the channel. If zero, a default of
+/// 1024 items is used.
+///
+/// excpt: &
+///
+/// Returns: The new channel.
+extern hlt_channel* hlt_channel_new_spsc(const hlt_type_info* item_type,
+                                         hlt_channel_capacity capacity, hlt_exception** excpt,
+                                         hlt_execution_context* ctx);
+
 /// Write an item into a channel. If the channel has already reached its
 /// capacity, the function blocks until an item is read from the channel.
 ///
@@ -52,6 +70,20 @@ extern void hlt_channel_write(hlt_channel* ch, const hlt_type_info* type, void*
 extern void hlt_channel_write_try(hlt_channel* ch, const hlt_type_info* type, void* data,
                                   hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Attempts to write all items of a vector into a channel at once. If the
+/// channel doesn't have space for all of them, a WouldBlock exception is
+/// thrown and nothing is written.
+///
+/// ch: The channel to write into.
+///
+/// items: The items to write. Their type must match the channel's.
+///
+/// excpt: &
+///
+/// Raises: ValueError if there are more items than the channel's capacity.
+extern void hlt_channel_write_batch_try(hlt_channel* ch, hlt_vector* items, hlt_exception** excpt,
+                                        hlt_execution_context* ctx);
+
 /// Reads an item from a channel. If the channel is empty, the function
 /// blocks until an item is written to the channel.
 ///
@@ -76,6 +108,24 @@ extern void* hlt_channel_read(hlt_channel* ch, hlt_exception** excpt, hlt_execut
 extern void* hlt_channel_read_try(hlt_channel* ch, hlt_exception** excpt,
                                   hlt_execution_context* ctx);
 
+/// Attempts to read a batch of items from a channel at once. If the channel
+/// is empty, a WouldBlock exception is thrown.
+///
+/// ch: The channel to read from.
+///
+/// max: The maximum number of items to read, or zero for all available.
+///
+/// type: The type of *def*.
+///
+/// def: The default element for the returned vector.
+///
+/// excpt: &
+///
+/// Returns: A new vector with the items read, in channel order.
+extern hlt_vector* hlt_channel_read_batch_try(hlt_channel* ch, int64_t max,
+                                              const hlt_type_info* type, void* def,
+                                              hlt_exception** excpt, hlt_execution_context* ctx);
+
 /// Returns the current channel size, i.e., the number of items in the
 /// channel.
 ///
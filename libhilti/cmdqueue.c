@@ -54,11 +54,20 @@ static void* _manager(void* arg)
 
     // We terminate iff all writer threads have terminated already with all
     // remaining elements processed.
+    // When idle, we wake up regularly to pass on any buffered file output.
+    // Without a flush interval, we just block.
+    int timeout = hlt_config_get()->file_flush_interval * 1e6;
+
+    if ( timeout < 0 )
+        timeout = 0;
+
     while ( ! hlt_thread_queue_terminated(__hlt_globals()->cmd_queue) ) {
-        __hlt_cmd* cmd = hlt_thread_queue_read(__hlt_globals()->cmd_queue, 0);
+        __hlt_cmd* cmd = hlt_thread_queue_read(__hlt_globals()->cmd_queue, timeout);
 
-        if ( ! cmd )
+        if ( ! cmd ) {
+            __hlt_files_flush(0);
             continue;
+        }
 
         execute_cmd(cmd, ctx);
         hlt_memory_safepoint(ctx);
@@ -108,8 +117,12 @@ void __hlt_cmd_worker_terminating(int worker)
 
 void __hlt_cmd_queue_done()
 {
-    if ( ! hlt_is_multi_threaded() )
+    if ( ! hlt_is_multi_threaded() ) {
+        // Commands have been executed synchronously, but output may still
+        // be buffered.
+        __hlt_files_flush(1);
         return;
+    }
 
     DBG_LOG(DBG_STREAM_QUEUE, "waiting for command queue manager to terminate");
 
@@ -23,6 +23,10 @@ hlt_config* __hlt_default_config()
 
     const char* profile = getenv("HILTI_PROFILE");
 
+    const char* pgo_file = getenv("HILTI_PGO_FILE");
+    if ( ! (pgo_file && *pgo_file) )
+        pgo_file = "hlt.pgo.dat";
+
     // Set defaults.
     cfg->num_workers = 2;
     cfg->time_idle = 0.1;
@@ -30,9 +34,13 @@ hlt_config* __hlt_default_config()
     cfg->thread_stack_size = 2684354560;       // This is generous.
     cfg->fiber_stack_size = 100 * 1024 * 1024; // This is generous.
     cfg->fiber_max_pool_size = 1000;
+    cfg->fiber_magazine_size = 64;
+    cfg->file_flush_size = 64 * 1024;
+    cfg->file_flush_interval = 0.1;
     cfg->debug_out = "hlt-debug.log";
     cfg->debug_streams = dbg;
     cfg->profiling = (profile && *profile);
+    cfg->pgo_file = pgo_file;
     cfg->vid_schedule_min = 1;
     cfg->vid_schedule_max = 101;
     cfg->core_affinity = "DEFAULT";
@@ -75,9 +83,13 @@ void hlt_config_dump(FILE* f)
     fprintf(f, "thread_stack_size:   %zu\n", cfg->thread_stack_size);
     fprintf(f, "fiber_stack_size:    %zu\n", cfg->fiber_stack_size);
     fprintf(f, "fiber_max_pool_size: %zu\n", cfg->fiber_max_pool_size);
+    fprintf(f, "fiber_magazine_size: %zu\n", cfg->fiber_magazine_size);
+    fprintf(f, "file_flush_size:     %" PRIu64 "\n", cfg->file_flush_size);
+    fprintf(f, "file_flush_interval: %.2f\n", cfg->file_flush_interval);
     fprintf(f, "debug_out:           %s\n", cfg->debug_out);
     fprintf(f, "debug_streams:       %s\n", cfg->debug_streams);
     fprintf(f, "profiling:           %s\n", (cfg->profiling ? "yes" : "no"));
+    fprintf(f, "pgo_file:            %s\n", cfg->pgo_file);
     fprintf(f, "vid_schedule_min:    %" PRId64 "\n", cfg->vid_schedule_min);
     fprintf(f, "vid_schedule_max:    %" PRId64 " \n", cfg->vid_schedule_max);
     fprintf(f, "core_affinity:       %s\n", cfg->core_affinity);
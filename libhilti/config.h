@@ -26,9 +26,23 @@ struct __hlt_config {
     /// Stack size for fibers.
     size_t fiber_stack_size;
 
-    /// Maximum size of pool of recycalable fibers.
+    /// Maximum size of pool of recycalable fibers. The global depot keeps
+    /// up to ten times this number of fibers.
     size_t fiber_max_pool_size;
 
+    /// Number of fibers per magazine. Each thread keeps up to two
+    /// magazines locally, and exchanges full/empty ones with the global
+    /// depot.
+    size_t fiber_magazine_size;
+
+    /// Number of bytes to accumulate per file before passing writes on to
+    /// the OS. Zero disables buffering. Default is 64KB.
+    uint64_t file_flush_size;
+
+    /// Maximum number of seconds that written data may remain buffered
+    /// before being passed on to the OS. Default is 0.1.
+    double file_flush_interval;
+
     /// File where debug output is to be sent. Default is stderr.
     const char* debug_out;
 
@@ -38,6 +52,11 @@ struct __hlt_config {
     /// 1 if profiling is enabled, 0 otherwise. Default is off.
     int8_t profiling;
 
+    /// File where code compiled for profile-guided optimization appends its
+    /// counts on termination. Default is hlt.pgo.dat, or the value of the
+    /// environment variable HILTI_PGO_FILE if set.
+    const char* pgo_file;
+
     /// The smallest virtual thread number to use when hashing a thread
     /// context into the set of virtual threads. Default is 1.
     hlt_vthread_id vid_schedule_min;
@@ -4,6 +4,7 @@
 //
 
 #include <setjmp.h>
+#include <stdatomic.h>
 #include <stdio.h>
 
 #include "config.h"
@@ -28,12 +29,44 @@ struct __hlt_fiber {
     void* result;
     hlt_execution_context* context;
     hlt_fiber_func run;
-    struct __hlt_fiber* next; // If a member of fiber tool, subsequent fiber or null.
 };
 
+// A magazine is a fixed-size stack of idle fibers. Each pool holds two of
+// them, and swaps complete magazines with the global depot when both run
+// full or empty. This follows Bonwick & Adams' "Magazines and Vmem".
+typedef struct __hlt_fiber_magazine {
+    size_t size;         // Number of fibers currently stored.
+    hlt_fiber* fibers[]; // Capacity is fiber_magazine_size.
+} __hlt_fiber_magazine;
+
 struct __hlt_fiber_pool {
-    hlt_fiber* head;
-    size_t size;
+    __hlt_fiber_magazine* loaded;   // Magazine we take fibers from and return them to.
+    __hlt_fiber_magazine* previous; // Second magazine, always either completely full or empty.
+    uint64_t hits;                  // Fibers recycled since last folded into globals.
+    uint64_t misses;                // Fibers created since last folded into globals.
+};
+
+// A bounded multi-producer/multi-consumer queue of magazines. This is
+// Dmitry Vyukov's array-based queue: it needs only single-word CAS and the
+// per-cell sequence numbers rule out ABA problems.
+typedef struct {
+    atomic_size_t seq;
+    __hlt_fiber_magazine* magazine;
+} __hlt_magazine_cell;
+
+typedef struct {
+    __hlt_magazine_cell* cells;
+    size_t mask;
+    char pad1[64];
+    atomic_size_t enqueue_pos;
+    char pad2[64];
+    atomic_size_t dequeue_pos;
+    char pad3[64];
+} __hlt_magazine_queue;
+
+struct __hlt_fiber_depot {
+    __hlt_magazine_queue full;  // Magazines filled up completely.
+    __hlt_magazine_queue empty; // Magazines without any fibers.
 };
 
 static void _fiber_trampoline(unsigned int y, unsigned int x)
@@ -82,22 +115,6 @@ static void fatal_error(const char* msg)
 }
 
 
-static inline void acqire_lock(int* i)
-{
-    hlt_pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, i);
-
-    if ( pthread_mutex_lock(&__hlt_globals()->synced_fiber_pool_lock) != 0 )
-        fatal_error("cannot lock mutex");
-}
-
-static inline void release_lock(int i)
-{
-    if ( pthread_mutex_unlock(&__hlt_globals()->synced_fiber_pool_lock) != 0 )
-        fatal_error("cannot unlock mutex");
-
-    hlt_pthread_setcancelstate(i, NULL);
-}
-
 // Internal version that really creates a fiber (vs. the external version
 // that might recycle a previously created on from a fiber pool). Note that
 // this function does not intialize the "run" and "cookie" fields.
@@ -118,7 +135,6 @@ static hlt_fiber* __hlt_fiber_create(hlt_execution_context* ctx)
     fiber->uctx.uc_stack.ss_size = hlt_config_get()->fiber_stack_size;
     fiber->uctx.uc_stack.ss_sp = hlt_stack_alloc(fiber->uctx.uc_stack.ss_size);
     fiber->uctx.uc_stack.ss_flags = 0;
-    fiber->next = 0;
 
     // Magic from from libtask/task.c to turn the pointer into two words.
     unsigned long z = (unsigned long)fiber;
@@ -141,22 +157,133 @@ static void __hlt_fiber_delete(hlt_fiber* fiber)
     hlt_free(fiber);
 }
 
+static __hlt_fiber_magazine* _magazine_new()
+{
+    size_t n = hlt_config_get()->fiber_magazine_size;
+    __hlt_fiber_magazine* m = hlt_malloc(sizeof(__hlt_fiber_magazine) + n * sizeof(hlt_fiber*));
+    m->size = 0;
+    return m;
+}
+
+static void _magazine_delete(__hlt_fiber_magazine* m)
+{
+    while ( m->size )
+        __hlt_fiber_delete(m->fibers[--m->size]);
+
+    hlt_free(m);
+}
+
+static void _queue_init(__hlt_magazine_queue* q, size_t capacity)
+{
+    q->cells = hlt_malloc(capacity * sizeof(__hlt_magazine_cell));
+    q->mask = capacity - 1;
+
+    for ( size_t i = 0; i < capacity; i++ ) {
+        atomic_init(&q->cells[i].seq, i);
+        q->cells[i].magazine = 0;
+    }
+
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+}
+
+// Returns false if the queue is full.
+static int _queue_push(__hlt_magazine_queue* q, __hlt_fiber_magazine* m)
+{
+    __hlt_magazine_cell* cell;
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+
+    for ( ;; ) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if ( diff == 0 ) {
+            if ( atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                       memory_order_relaxed,
+                                                       memory_order_relaxed) )
+                break;
+        }
+
+        else if ( diff < 0 )
+            return 0;
+
+        else
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    }
+
+    cell->magazine = m;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+// Returns null if the queue is empty.
+static __hlt_fiber_magazine* _queue_pop(__hlt_magazine_queue* q)
+{
+    __hlt_magazine_cell* cell;
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+
+    for ( ;; ) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if ( diff == 0 ) {
+            if ( atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                       memory_order_relaxed,
+                                                       memory_order_relaxed) )
+                break;
+        }
+
+        else if ( diff < 0 )
+            return 0;
+
+        else
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    }
+
+    __hlt_fiber_magazine* m = cell->magazine;
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return m;
+}
+
+static void _queue_done(__hlt_magazine_queue* q)
+{
+    __hlt_fiber_magazine* m;
+
+    while ( (m = _queue_pop(q)) )
+        _magazine_delete(m);
+
+    hlt_free(q->cells);
+}
+
+// Folds a pool's counters into the global statistics. We do this only when
+// we touch the depot anyway, so that the fast path stays free of shared
+// writes.
+static void _pool_flush_stats(__hlt_fiber_pool* pool)
+{
+    __hlt_global_state* globals = __hlt_globals();
+    atomic_fetch_add_explicit(&globals->fiber_pool_hits, pool->hits, memory_order_relaxed);
+    atomic_fetch_add_explicit(&globals->fiber_pool_misses, pool->misses, memory_order_relaxed);
+    pool->hits = 0;
+    pool->misses = 0;
+}
+
 __hlt_fiber_pool* __hlt_fiber_pool_new()
 {
     __hlt_fiber_pool* pool = hlt_malloc(sizeof(__hlt_fiber_pool));
-    pool->head = 0;
-    pool->size = 0;
+    pool->loaded = _magazine_new();
+    pool->previous = _magazine_new();
+    pool->hits = 0;
+    pool->misses = 0;
     return pool;
 }
 
 void __hlt_fiber_pool_delete(__hlt_fiber_pool* pool)
 {
-    while ( pool->head ) {
-        hlt_fiber* fiber = pool->head;
-        pool->head = pool->head->next;
-        __hlt_fiber_delete(fiber);
-    }
-
+    _pool_flush_stats(pool);
+    _magazine_delete(pool->loaded);
+    _magazine_delete(pool->previous);
     hlt_free(pool);
 }
 
@@ -165,54 +292,48 @@ hlt_fiber* hlt_fiber_create(hlt_fiber_func func, hlt_execution_context* fctx, vo
 {
     assert(ctx);
 
-    // If there's a fiber available in the local pool, use that. Otherwise
-    // check the global. Otherwise, create one.
+    // If there's a fiber available in one of the local magazines, use that.
+    // Otherwise trade our empty magazine for a full one from the depot.
+    // Otherwise, create one.
 
-    __hlt_fiber_pool* fiber_pool = ctx->worker ? ctx->worker->fiber_pool : ctx->fiber_pool;
+    __hlt_fiber_pool* pool = ctx->worker ? ctx->worker->fiber_pool : ctx->fiber_pool;
 
-    assert(fiber_pool);
+    assert(pool);
 
     hlt_fiber* fiber = 0;
 
-    if ( ! fiber_pool->head && hlt_is_multi_threaded() ) {
-        __hlt_fiber_pool* global_pool = __hlt_globals()->synced_fiber_pool;
-
-        // We do this without locking first, should be fine to encounter a
-        // race.
-        if ( global_pool->size ) {
-            int s = 0;
-            acqire_lock(&s);
-
-            int n = hlt_config_get()->fiber_max_pool_size / 5; // 20%
+    if ( ! pool->loaded->size ) {
+        if ( pool->previous->size ) {
+            __hlt_fiber_magazine* tmp = pool->loaded;
+            pool->loaded = pool->previous;
+            pool->previous = tmp;
+        }
 
-            while ( global_pool->head && n-- ) {
-                fiber = global_pool->head;
+        else if ( hlt_is_multi_threaded() ) {
+            __hlt_fiber_depot* depot = __hlt_globals()->fiber_depot;
+            __hlt_fiber_magazine* full = _queue_pop(&depot->full);
 
-                global_pool->head = fiber->next;
-                --global_pool->size;
+            if ( full ) {
+                if ( ! _queue_push(&depot->empty, pool->loaded) )
+                    _magazine_delete(pool->loaded);
 
-                fiber->next = fiber_pool->head;
-                fiber_pool->head = fiber;
-                ++fiber_pool->size;
+                pool->loaded = full;
             }
 
-            // fprintf(stderr, "vid %lu took %lu from global, that now at %lu\n", ctx->vid,
-            // hlt_config_get()->fiber_max_pool_size / 10, global_pool->size);
-
-            release_lock(s);
+            _pool_flush_stats(pool);
         }
     }
 
-    if ( fiber_pool->head ) {
-        fiber = fiber_pool->head;
-        fiber_pool->head = fiber_pool->head->next;
-        --fiber_pool->size;
-        fiber->next = 0;
+    if ( pool->loaded->size ) {
+        fiber = pool->loaded->fibers[--pool->loaded->size];
         assert(fiber->state == IDLE);
+        ++pool->hits;
     }
 
-    else
+    else {
         fiber = __hlt_fiber_create(fctx);
+        ++pool->misses;
+    }
 
     fiber->run = func;
     fiber->context = fctx;
@@ -223,69 +344,53 @@ hlt_fiber* hlt_fiber_create(hlt_fiber_func func, hlt_execution_context* fctx, vo
 
 void hlt_fiber_delete(hlt_fiber* fiber, hlt_execution_context* ctx)
 {
-    assert(! fiber->next);
-
     if ( ! ctx ) {
         __hlt_fiber_delete(fiber);
         return;
     }
 
-    __hlt_fiber_pool* fiber_pool = ctx->worker ? ctx->worker->fiber_pool : ctx->fiber_pool;
-
-    // Return the fiber to the local pool as long as we haven't reached us
-    // maximum pool size yet. If we have, return the pool to the global pool first.
-
-    if ( fiber_pool->size >= hlt_config_get()->fiber_max_pool_size ) {
-        if ( hlt_is_multi_threaded() ) {
-            __hlt_fiber_pool* global_pool = __hlt_globals()->synced_fiber_pool;
-
-            // We do this without locking, should be fine to encounter a
-            // race.
-            if ( global_pool->size <= 10 * hlt_config_get()->fiber_max_pool_size ) {
-                int s = 0;
-                acqire_lock(&s);
-
-                // Check again.
-                if ( global_pool->size <= 10 * hlt_config_get()->fiber_max_pool_size ) {
-                    // fprintf(stderr, "vid %lu gives %lu to global, that then at %lu\n", ctx->vid,
-                    // fiber_pool->size, global_pool->size + fiber_pool->size);
+    __hlt_fiber_pool* pool = ctx->worker ? ctx->worker->fiber_pool : ctx->fiber_pool;
+    size_t capacity = hlt_config_get()->fiber_magazine_size;
 
-                    hlt_fiber* tail;
+    // Return the fiber to the loaded magazine if there's space. If not,
+    // continue with the previous one if that's empty. If both are full,
+    // hand the previous one over to the depot in exchange for an empty one.
 
-                    for ( tail = global_pool->head; tail && tail->next; tail = tail->next )
-                        ;
+    if ( pool->loaded->size >= capacity ) {
+        if ( pool->previous->size == 0 ) {
+            __hlt_fiber_magazine* tmp = pool->loaded;
+            pool->loaded = pool->previous;
+            pool->previous = tmp;
+        }
 
-                    if ( tail )
-                        tail->next = fiber_pool->head;
-                    else
-                        global_pool->head = fiber_pool->head;
+        else {
+            if ( ! hlt_is_multi_threaded() ) {
+                // Local magazines are full, and there's no depot.
+                __hlt_fiber_delete(fiber);
+                return;
+            }
 
-                    global_pool->size += fiber_pool->size;
+            __hlt_fiber_depot* depot = __hlt_globals()->fiber_depot;
 
-                    fiber_pool->head = 0;
-                    fiber_pool->size = 0;
+            _pool_flush_stats(pool);
 
-                    release_lock(s);
+            if ( ! _queue_push(&depot->full, pool->previous) ) {
+                // Local magazines and depot have all reached their size,
+                // just delete.
+                __hlt_fiber_delete(fiber);
+                return;
+            }
 
-                    goto return_to_local;
-                }
+            __hlt_fiber_magazine* empty = _queue_pop(&depot->empty);
 
-                release_lock(s);
-            }
+            pool->previous = pool->loaded;
+            pool->loaded = (empty ? empty : _magazine_new());
         }
-
-        // Local and global have reached their size, just return.
-        __hlt_fiber_delete(fiber);
-        return;
     }
 
-return_to_local:
-
     hlt_stack_invalidate(fiber->uctx.uc_stack.ss_sp, fiber->uctx.uc_stack.ss_size);
 
-    fiber->next = fiber_pool->head;
-    fiber_pool->head = fiber;
-    ++fiber_pool->size;
+    pool->loaded->fibers[pool->loaded->size++] = fiber;
 }
 
 int8_t hlt_fiber_start(hlt_fiber* fiber, hlt_execution_context* ctx)
@@ -356,17 +461,52 @@ extern hlt_execution_context* hlt_fiber_context(hlt_fiber* fiber)
     return fiber->context;
 }
 
+hlt_fiber_stats hlt_fiber_statistics(hlt_execution_context* ctx)
+{
+    __hlt_global_state* globals = __hlt_globals();
+
+    hlt_fiber_stats stats;
+    stats.hits = atomic_load(&globals->fiber_pool_hits);
+    stats.misses = atomic_load(&globals->fiber_pool_misses);
+
+    if ( ctx ) {
+        __hlt_fiber_pool* pool = ctx->worker ? ctx->worker->fiber_pool : ctx->fiber_pool;
+        stats.hits += pool->hits;
+        stats.misses += pool->misses;
+    }
+
+    return stats;
+}
+
 void __hlt_fiber_init()
 {
+    __hlt_global_state* globals = __hlt_globals();
+
+    atomic_init(&globals->fiber_pool_hits, 0);
+    atomic_init(&globals->fiber_pool_misses, 0);
+
     if ( ! hlt_is_multi_threaded() ) {
-        __hlt_globals()->synced_fiber_pool = 0;
+        globals->fiber_depot = 0;
         return;
     }
 
-    if ( pthread_mutex_init(&__hlt_globals()->synced_fiber_pool_lock, 0) != 0 )
-        fatal_error("cannot init mutex");
+    const hlt_config* cfg = hlt_config_get();
+
+    if ( ! cfg->fiber_magazine_size )
+        fatal_error("fiber_magazine_size must not be zero");
+
+    // The depot holds up to 10 times the maximum pool size; round the
+    // number of magazines up to a power of two as the queue requires.
+    size_t n = (10 * cfg->fiber_max_pool_size) / cfg->fiber_magazine_size;
+    size_t capacity = 2;
 
-    __hlt_globals()->synced_fiber_pool = __hlt_fiber_pool_new();
+    while ( capacity < n )
+        capacity <<= 1;
+
+    __hlt_fiber_depot* depot = hlt_malloc(sizeof(__hlt_fiber_depot));
+    _queue_init(&depot->full, capacity);
+    _queue_init(&depot->empty, capacity);
+    globals->fiber_depot = depot;
 }
 
 void __hlt_fiber_done()
@@ -374,9 +514,9 @@ void __hlt_fiber_done()
     if ( ! hlt_is_multi_threaded() )
         return;
 
-    __hlt_fiber_pool_delete(__hlt_globals()->synced_fiber_pool);
-
-    if ( hlt_is_multi_threaded() &&
-         pthread_mutex_destroy(&__hlt_globals()->synced_fiber_pool_lock) != 0 )
-        fatal_error("cannot destroy mutex");
+    __hlt_fiber_depot* depot = __hlt_globals()->fiber_depot;
+    _queue_done(&depot->full);
+    _queue_done(&depot->empty);
+    hlt_free(depot);
+    __hlt_globals()->fiber_depot = 0;
 }
@@ -13,6 +13,12 @@ typedef struct __hlt_fiber hlt_fiber;
 
 typedef void (*hlt_fiber_func)(hlt_fiber* fiber, void* p);
 
+/// Statistics about the recycling of fibers through the fiber pools.
+typedef struct {
+    uint64_t hits;   /// Number of fibers taken from a pool instead of being created.
+    uint64_t misses; /// Number of fibers that had to be created because no pool had one.
+} hlt_fiber_stats;
+
 /// Creates a new fiber instance.
 ///
 /// func: The function to run inside the fiber. It receives two arguments:
@@ -82,6 +88,15 @@ extern void* hlt_fiber_get_cookie(hlt_fiber* fiber);
 /// Returns: The context.
 extern struct __hlt_execution_context* hlt_fiber_context(hlt_fiber* fiber);
 
+/// Returns statistics about fiber pool usage. Counters of other threads'
+/// pools are folded in only when those exchange magazines with the global
+/// depot, so they may lag behind slightly.
+///
+/// ctx: If given, the counters of this context's own pool are included.
+///
+/// Returns: The statistics.
+extern hlt_fiber_stats hlt_fiber_statistics(struct __hlt_execution_context* ctx);
+
 /// Internal functin to create a new, initially empty pool of available
 /// fibers.
 extern __hlt_fiber_pool* __hlt_fiber_pool_new();
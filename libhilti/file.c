@@ -2,15 +2,30 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <string.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "autogen/hilti-hlt.h"
+#include "config.h"
+#include "debug.h"
 #include "file.h"
 #include "globals.h"
 #include "memory_.h"
 
+#define DBG_STREAM_FILE "hilti-queue"
+
+#ifdef IOV_MAX
+#define MAX_PENDING_WRITES IOV_MAX
+#else
+#define MAX_PENDING_WRITES 1024
+#endif
+
 // This struct describes one currently open file. We memory-manage this ourselves.
 struct __hlt_file_info {
     hlt_string path; // The path of the file.
@@ -18,6 +33,21 @@ struct __hlt_file_info {
     int writers;     // The number of file objects having the file open from the OS perspective.
     bool error;      // True if we run into an error.
 
+    // Writes not yet passed on to the OS. These are accessed only from the
+    // command queue thread. We take over the data buffers of the write
+    // commands and eventually hand them all to a single writev().
+    struct iovec* pending;  // Pending buffers, MAX_PENDING_WRITES entries allocated.
+    char** pending_data;    // The buffers' original start addresses, for freeing.
+    int num_pending;        // Number of entries in pending.
+    uint64_t pending_bytes; // Total number of bytes pending.
+    double pending_since;   // Time when the oldest pending write arrived.
+
+    // Throughput counters. Written only from the command queue thread, but
+    // may be read from anywhere.
+    atomic_uint_fast64_t records;  // Number of write operations.
+    atomic_uint_fast64_t bytes;    // Number of bytes handed to the OS.
+    atomic_uint_fast64_t syscalls; // Number of write system calls.
+
     struct __hlt_file_info* next; // We keep them in a list.
     struct __hlt_file_info* prev;
 };
@@ -77,6 +107,109 @@ static inline void release_lock(int i)
     hlt_pthread_setcancelstate(i, NULL);
 }
 
+static double _now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Like __hlt_safe_write(), but for a vector of buffers. The iovec array is
+// modified to account for partial writes.
+static int8_t _safe_writev(__hlt_file_info* info, struct iovec* iov, int cnt)
+{
+    while ( cnt > 0 ) {
+        ssize_t n = writev(info->fd, iov, cnt);
+        atomic_fetch_add_explicit(&info->syscalls, 1, memory_order_relaxed);
+
+        if ( n < 0 ) {
+            if ( errno == EINTR )
+                continue;
+
+            return 0;
+        }
+
+        atomic_fetch_add_explicit(&info->bytes, n, memory_order_relaxed);
+
+        while ( cnt > 0 && (size_t)n >= iov->iov_len ) {
+            n -= iov->iov_len;
+            ++iov;
+            --cnt;
+        }
+
+        if ( cnt > 0 ) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return 1;
+}
+
+// Passes all pending writes on to the OS. Must be called from the command
+// queue thread only.
+static void _flush(__hlt_file_info* info)
+{
+    if ( ! info->num_pending )
+        return;
+
+    if ( info->fd >= 0 && ! info->error ) {
+        if ( ! _safe_writev(info, info->pending, info->num_pending) )
+            info->error = 1;
+    }
+
+    for ( int i = 0; i < info->num_pending; i++ )
+        hlt_free(info->pending_data[i]);
+
+    info->num_pending = 0;
+    info->pending_bytes = 0;
+}
+
+// Queues a write's data buffer for output, taking ownership of it. Must be
+// called from the command queue thread only.
+static void _buffer_write(__hlt_file_info* info, char* data, int len)
+{
+    const hlt_config* cfg = hlt_config_get();
+
+    atomic_fetch_add_explicit(&info->records, 1, memory_order_relaxed);
+
+    if ( ! info->pending ) {
+        info->pending = hlt_malloc(MAX_PENDING_WRITES * sizeof(struct iovec));
+        info->pending_data = hlt_malloc(MAX_PENDING_WRITES * sizeof(char*));
+    }
+
+    double now = _now();
+
+    if ( ! info->num_pending )
+        info->pending_since = now;
+
+    info->pending[info->num_pending].iov_base = data;
+    info->pending[info->num_pending].iov_len = len;
+    info->pending_data[info->num_pending] = data;
+    info->num_pending++;
+    info->pending_bytes += len;
+
+    if ( info->pending_bytes >= cfg->file_flush_size || info->num_pending == MAX_PENDING_WRITES ||
+         now - info->pending_since >= cfg->file_flush_interval )
+        _flush(info);
+}
+
+void __hlt_files_flush(int8_t all)
+{
+    double cutoff = _now() - hlt_config_get()->file_flush_interval;
+
+    // Other threads may be opening or closing files concurrently.
+    int s = 0;
+    acqire_lock(&s);
+
+    for ( __hlt_file_info* info = __hlt_globals()->files; info; info = info->next ) {
+        if ( info->num_pending && (all || info->pending_since <= cutoff) )
+            _flush(info);
+    }
+
+    release_lock(s);
+}
+
 void __hlt_files_init()
 {
     if ( hlt_is_multi_threaded() && pthread_mutex_init(&__hlt_globals()->files_lock, 0) != 0 )
@@ -88,11 +221,14 @@ void __hlt_files_done()
     __hlt_file_info* info = __hlt_globals()->files;
 
     while ( info ) {
+        _flush(info);
         close(info->fd);
 
         GC_DTOR(info->path, hlt_string, hlt_global_execution_context());
 
         __hlt_file_info* next = info->next;
+        hlt_free(info->pending);
+        hlt_free(info->pending_data);
         hlt_free(info);
         info = next;
     }
@@ -178,6 +314,14 @@ void hlt_file_open(hlt_file* file, hlt_string path, hlt_enum type, hlt_enum mode
     info->path = hlt_string_copy(path, excpt, ctx);
     info->writers = 1;
     info->error = 0;
+    info->pending = 0;
+    info->pending_data = 0;
+    info->num_pending = 0;
+    info->pending_bytes = 0;
+    info->pending_since = 0;
+    atomic_init(&info->records, 0);
+    atomic_init(&info->bytes, 0);
+    atomic_init(&info->syscalls, 0);
     info->prev = 0;
     info->next = __hlt_globals()->files;
 
@@ -366,21 +510,16 @@ void __hlt_file_cmd_internal(__hlt_cmd* c, hlt_execution_context* ctx)
         break;
 
     case 2: {
-        // Write comment.
-
-        if ( cmd->info->fd < 0 )
-            return;
-
-        if ( cmd->info->error )
-            return;
-
-        if ( cmd->len ) {
-            if ( ! __hlt_safe_write(cmd->info->fd, cmd->data, cmd->len) )
-                cmd->info->error = 1;
+        // Write command.
 
+        if ( cmd->info->fd < 0 || cmd->info->error ) {
             hlt_free(cmd->data);
+            return;
         }
 
+        if ( cmd->len )
+            _buffer_write(cmd->info, cmd->data, cmd->len);
+
         break;
     }
 
@@ -396,8 +535,14 @@ void __hlt_file_cmd_internal(__hlt_cmd* c, hlt_execution_context* ctx)
         assert(cmd->info->writers);
 
         if ( --cmd->info->writers == 0 ) {
+            _flush(cmd->info);
             close(cmd->info->fd);
 
+            DBG_LOG(DBG_STREAM_FILE,
+                    "closed file %p: %" PRIu64 " records, %" PRIu64 " bytes, %" PRIu64 " writes",
+                    cmd->info, (uint64_t)cmd->info->records, (uint64_t)cmd->info->bytes,
+                    (uint64_t)cmd->info->syscalls);
+
             // Delete from list.
             __hlt_file_info* cur;
             for ( cur = __hlt_globals()->files; cur; cur = cur->next ) {
@@ -419,6 +564,8 @@ void __hlt_file_cmd_internal(__hlt_cmd* c, hlt_execution_context* ctx)
                 fatal_error("file to close not found");
 
             GC_DTOR(cmd->info->path, hlt_string, hlt_global_execution_context());
+            hlt_free(cmd->info->pending);
+            hlt_free(cmd->info->pending_data);
             hlt_free(cmd->info);
 
             cmd->info = 0;
@@ -434,6 +581,23 @@ void __hlt_file_cmd_internal(__hlt_cmd* c, hlt_execution_context* ctx)
     }
 }
 
+hlt_file_stats hlt_file_statistics(hlt_file* file, hlt_exception** excpt,
+                                   hlt_execution_context* ctx)
+{
+    hlt_file_stats stats = {0, 0, 0};
+
+    if ( ! file->open ) {
+        hlt_string err = hlt_string_from_asciiz("file not open", excpt, ctx);
+        hlt_set_exception(excpt, &hlt_exception_io_error, err, ctx);
+        return stats;
+    }
+
+    stats.records = atomic_load_explicit(&file->info->records, memory_order_relaxed);
+    stats.bytes = atomic_load_explicit(&file->info->bytes, memory_order_relaxed);
+    stats.syscalls = atomic_load_explicit(&file->info->syscalls, memory_order_relaxed);
+    return stats;
+}
+
 hlt_string hlt_file_to_string(const hlt_type_info* type, const void* obj, int32_t options,
                               __hlt_pointer_stack* seen, hlt_exception** excpt,
                               hlt_execution_context* ctx)
@@ -6,7 +6,10 @@
 /// Writing to the same file from multiple threads is well-defined.
 ///
 /// Internally, we push all writes into the internal command queue, and the
-/// queue manager performs the actual output.
+/// queue manager performs the actual output. The manager buffers writes per
+/// file and passes them on to the OS in batches, either once
+/// ``hlt_config::file_flush_size`` bytes have accumulated or after
+/// ``hlt_config::file_flush_interval`` seconds, whatever comes first.
 ///
 /// Note: For now, we only do output. Long-term, we could look into input via
 /// a specialized IOSource.
@@ -22,6 +25,14 @@
 
 typedef struct __hlt_file hlt_file;
 
+/// Throughput statistics for a file. These are aggregated across all file
+/// objects referring to the same physical file.
+typedef struct {
+    uint64_t records;  /// Number of write operations performed.
+    uint64_t bytes;    /// Number of bytes passed on to the OS so far.
+    uint64_t syscalls; /// Number of system calls used for writing so far.
+} hlt_file_stats;
+
 // The file mode must match the Hilti::FileMode* constants in hilti.hlt.
 
 /// When opening a file with this mode, an already existing file with the
@@ -128,6 +139,16 @@ void hlt_file_write_bytes(hlt_file* file, struct __hlt_bytes* bytes, hlt_excepti
 /// excpt: &
 hlt_string hlt_file_name(hlt_file* file, hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Returns throughput statistics for an open file.
+///
+/// file: The file.
+///
+/// excpt: &
+///
+/// Raises: IOError if the file is not open.
+hlt_file_stats hlt_file_statistics(hlt_file* file, hlt_exception** excpt,
+                                   hlt_execution_context* ctx);
+
 // Internal function called once at startup from the command queue threadto
 // initialize the file management.
 void __hlt_files_init();
@@ -136,6 +157,13 @@ void __hlt_files_init();
 // clean up.
 void __hlt_files_done();
 
+// Internal function passing buffered writes on to the OS. Must be called from
+// the command queue thread only (or, in non-threaded mode, the main thread).
+//
+// all: If true, flushes all files; otherwise only those with data pending
+// for longer than the configured flush interval.
+void __hlt_files_flush(int8_t all);
+
 typedef struct __hlt_cmd_write __hlt_cmd_write;
 
 // Internal function to perform the actual write from the queue manager. This
@@ -74,13 +74,16 @@ struct __hlt_global_state {
     int8_t profiling_enabled;
     int8_t papi_available;
     int papi_set;
+    __hlt_pgo_counters* pgo_counters; // Counters registered for profile-guided optimization.
+    pthread_mutex_t pgo_lock;         // Lock to protect access to pgo_counters.
 
     // timer.c
     atomic_uint_fast64_t global_time;
 
     // fiber.c
-    __hlt_fiber_pool* synced_fiber_pool;    // Global fiber pool.
-    pthread_mutex_t synced_fiber_pool_lock; // Lock to protect access to pool.
+    __hlt_fiber_depot* fiber_depot;       // Global depot of fiber magazines.
+    atomic_uint_fast64_t fiber_pool_hits;   // Fibers recycled, folded in from the local pools.
+    atomic_uint_fast64_t fiber_pool_misses; // Fibers created, folded in from the local pools.
 
     // The following are for debugging only. However, we can't compile them
     // out in the non-debugging version because a host application might link
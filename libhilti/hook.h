@@ -13,6 +13,12 @@ typedef struct __hlt_hook_state hlt_hook_state;
 
 /// Enables or disables a hook group.
 ///
+/// Note that if the optional \c hookgroups optimization has been enabled
+/// explicitly, the HILTI linker removes the checks for whether a group is
+/// enabled from all hook implementations in groups that no HILTI code ever
+/// disables. Disabling such a group through this function then has no
+/// effect on them. That optimization is off by default.
+///
 /// group: The group which's state to set.
 ///
 /// enabled: 0 to disable that group, 1 to enable.
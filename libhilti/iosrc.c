@@ -1,8 +1,20 @@
 
+#include <fcntl.h>
 #include <pcap.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "autogen/hilti-hlt.h"
+#include "config.h"
+#include "hutil.h"
 #include "iosrc.h"
+#include "type-info.h"
+#include "vector.h"
+
+// Number of packets to read per batch if the caller doesn't specify.
+#define DEFAULT_BATCH_SIZE 64
 
 typedef struct {
     hlt_iosrc* src;
@@ -39,10 +51,10 @@ static void _raise_error(hlt_iosrc* src, const char* errbuf, hlt_exception** exc
     hlt_set_exception(excpt, &hlt_exception_io_error, msg, ctx);
 }
 
-static void _strip_link_layer(hlt_iosrc* src, const char** pkt, int* caplen, int datalink,
+static void _strip_link_layer(hlt_iosrc* src, const char** pkt, size_t* caplen, int datalink,
                               hlt_exception** excpt, hlt_execution_context* ctx)
 {
-    int hdr_size = 0;
+    size_t hdr_size = 0;
 
     switch ( datalink ) {
     case DLT_NULL:
@@ -79,11 +91,398 @@ static void _strip_link_layer(hlt_iosrc* src, const char** pkt, int* caplen, int
     *caplen -= hdr_size;
 }
 
+// Memory-mapped reading of offline traces. We support the classic pcap
+// format as well as pcapng, in either byte order.
+
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAPNG_SHB 0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_IDB 1
+#define PCAPNG_SPB 3
+#define PCAPNG_EPB 6
+#define PCAPNG_OPT_TSRESOL 9
+#define LINKTYPE_RAW 101
+
+// How far ahead of the current position we ask the kernel to read the
+// trace in.
+#define MMAP_READAHEAD (16 * 1024 * 1024)
+
+// A pcapng interface.
+typedef struct {
+    int linktype;
+    int8_t tsresol_binary; // True if the resolution is 2^-tsresol, else 10^-tsresol.
+    int8_t tsresol;
+} __hlt_iosrc_iface;
+
+typedef struct {
+    hlt_bytes_backing backing; // Must come first.
+    const uint8_t* data;       // Start of the mapping.
+    size_t size;               // Size of the mapping.
+    size_t pos;                // Offset of the next record.
+    size_t advised;            // Offset up to which we have requested read-ahead.
+    size_t pagesize;           // System page size.
+    int8_t pcapng;             // True for pcapng, false for classic pcap.
+    int8_t swap;               // True if the file's byte order differs from ours.
+    int8_t nsecs;              // Classic pcap only: true for nanosecond timestamps.
+    int linktype;              // Classic pcap only: the link type.
+    __hlt_iosrc_iface* ifaces; // pcapng only: interfaces of current section.
+    int num_ifaces;            // pcapng only: number of entries in ifaces.
+} __hlt_iosrc_mmap;
+
+static inline uint16_t _u16(const __hlt_iosrc_mmap* m, const uint8_t* p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return m->swap ? __builtin_bswap16(v) : v;
+}
+
+static inline uint32_t _u32(const __hlt_iosrc_mmap* m, const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return m->swap ? __builtin_bswap32(v) : v;
+}
+
+static void _mmap_release(hlt_bytes_backing* backing)
+{
+    __hlt_iosrc_mmap* m = (__hlt_iosrc_mmap*)backing;
+    munmap((void*)m->data, m->size);
+
+    if ( m->ifaces )
+        hlt_free(m->ifaces);
+
+    hlt_free(m);
+}
+
+static inline void _mmap_advise(__hlt_iosrc_mmap* m)
+{
+    if ( m->pos + MMAP_READAHEAD / 2 < m->advised || m->advised >= m->size )
+        return;
+
+    size_t start = m->advised & ~(m->pagesize - 1);
+    size_t end = m->pos + MMAP_READAHEAD;
+
+    if ( end > m->size )
+        end = m->size;
+
+    madvise((void*)(m->data + start), end - start, MADV_WILLNEED);
+    m->advised = end;
+}
+
+// Returns null if the file can't be mapped or isn't in a format we
+// understand, in which case the caller should fall back to libpcap.
+static __hlt_iosrc_mmap* _mmap_open(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+
+    if ( fd < 0 )
+        return 0;
+
+    struct stat st;
+
+    if ( fstat(fd, &st) < 0 || ! S_ISREG(st.st_mode) || st.st_size < 24 ) {
+        close(fd);
+        return 0;
+    }
+
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if ( data == MAP_FAILED )
+        return 0;
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    __hlt_iosrc_mmap* m = hlt_malloc(sizeof(__hlt_iosrc_mmap));
+    m->backing.ref_cnt = 1;
+    m->backing.release = _mmap_release;
+    m->data = (const uint8_t*)data;
+    m->size = st.st_size;
+    m->pos = 0;
+    m->advised = 0;
+    m->pagesize = sysconf(_SC_PAGESIZE);
+    m->pcapng = 0;
+    m->swap = 0;
+    m->nsecs = 0;
+    m->linktype = 0;
+    m->ifaces = 0;
+    m->num_ifaces = 0;
+
+    uint32_t magic;
+    memcpy(&magic, m->data, sizeof(magic));
+
+    switch ( magic ) {
+    case PCAP_MAGIC:
+    case PCAP_MAGIC_NSEC:
+        m->nsecs = (magic == PCAP_MAGIC_NSEC);
+        break;
+
+    case __builtin_bswap32(PCAP_MAGIC):
+    case __builtin_bswap32(PCAP_MAGIC_NSEC):
+        m->swap = 1;
+        m->nsecs = (magic == __builtin_bswap32(PCAP_MAGIC_NSEC));
+        break;
+
+    case PCAPNG_SHB:
+        // The section header sets the byte order when we get to it.
+        m->pcapng = 1;
+        break;
+
+    default:
+        _mmap_release(&m->backing);
+        return 0;
+    }
+
+    if ( ! m->pcapng ) {
+        m->linktype = _u32(m, m->data + 20);
+        m->pos = 24;
+    }
+
+    _mmap_advise(m);
+    return m;
+}
+
+static inline hlt_time _pcapng_time(const __hlt_iosrc_iface* iface, uint64_t ts)
+{
+    uint64_t units = 1;
+
+    if ( iface->tsresol_binary ) {
+        units <<= iface->tsresol;
+        uint64_t frac = ts % units;
+        return hlt_time_value(ts / units, (uint64_t)((double)frac * 1e9 / units));
+    }
+
+    for ( int i = 0; i < iface->tsresol; i++ )
+        units *= 10;
+
+    uint64_t frac = ts % units;
+    uint64_t nsecs = (units <= 1000000000 ? frac * (1000000000 / units) :
+                                            frac / (units / 1000000000));
+    return hlt_time_value(ts / units, nsecs);
+}
+
+// Parses a pcapng interface description block.
+static int _pcapng_iface(__hlt_iosrc_mmap* m, const uint8_t* p, uint32_t len, const char** err)
+{
+    if ( len < 20 ) {
+        *err = "truncated pcapng interface block";
+        return -1;
+    }
+
+    __hlt_iosrc_iface iface;
+    iface.linktype = _u16(m, p + 8);
+    iface.tsresol_binary = 0;
+    iface.tsresol = 6;
+
+    // Options.
+    const uint8_t* o = p + 16;
+    const uint8_t* end = p + len - 4;
+
+    while ( o + 4 <= end ) {
+        uint16_t code = _u16(m, o);
+        uint16_t olen = _u16(m, o + 2);
+
+        if ( code == 0 || o + 4 + olen > end )
+            break;
+
+        if ( code == PCAPNG_OPT_TSRESOL && olen >= 1 ) {
+            iface.tsresol_binary = (o[4] & 0x80) != 0;
+            iface.tsresol = (o[4] & 0x7f);
+        }
+
+        o += 4 + ((olen + 3) & ~3);
+    }
+
+    if ( (iface.tsresol_binary && iface.tsresol > 63) ||
+         (! iface.tsresol_binary && iface.tsresol > 19) ) {
+        *err = "unsupported pcapng timestamp resolution";
+        return -1;
+    }
+
+    m->ifaces = hlt_realloc(m->ifaces, (m->num_ifaces + 1) * sizeof(__hlt_iosrc_iface),
+                            m->num_ifaces * sizeof(__hlt_iosrc_iface));
+    m->ifaces[m->num_ifaces++] = iface;
+    return 0;
+}
+
+// Returns 1 if we got a packet, 0 at the end of the trace, and -1 on error
+// with *err set.
+static int _mmap_next(__hlt_iosrc_mmap* m, hlt_time* t, const uint8_t** data, size_t* caplen,
+                      int* linktype, const char** err)
+{
+    _mmap_advise(m);
+
+    if ( ! m->pcapng ) {
+        if ( m->pos == m->size )
+            return 0;
+
+        const uint8_t* p = m->data + m->pos;
+
+        if ( m->pos + 16 > m->size ) {
+            *err = "truncated packet header";
+            return -1;
+        }
+
+        uint32_t len = _u32(m, p + 8);
+
+        if ( m->pos + 16 + len > m->size ) {
+            *err = "truncated packet";
+            return -1;
+        }
+
+        uint32_t frac = _u32(m, p + 4);
+        *t = hlt_time_value(_u32(m, p), m->nsecs ? frac : frac * 1000);
+        *data = p + 16;
+        *caplen = len;
+        *linktype = m->linktype;
+
+        m->pos += 16 + len;
+        __builtin_prefetch(m->data + m->pos);
+        return 1;
+    }
+
+    while ( m->pos < m->size ) {
+        const uint8_t* p = m->data + m->pos;
+
+        if ( m->pos + 12 > m->size ) {
+            *err = "truncated pcapng block";
+            return -1;
+        }
+
+        uint32_t type;
+        memcpy(&type, p, sizeof(type));
+
+        if ( type == PCAPNG_SHB ) {
+            // New section, which may switch byte order and starts over
+            // with the interfaces.
+            uint32_t bom;
+            memcpy(&bom, p + 8, sizeof(bom));
+
+            if ( bom == PCAPNG_BYTE_ORDER_MAGIC )
+                m->swap = 0;
+
+            else if ( bom == __builtin_bswap32(PCAPNG_BYTE_ORDER_MAGIC) )
+                m->swap = 1;
+
+            else {
+                *err = "bad pcapng byte-order magic";
+                return -1;
+            }
+
+            m->num_ifaces = 0;
+        }
+
+        else
+            type = _u32(m, p);
+
+        uint32_t len = _u32(m, p + 4);
+
+        // Blocks are padded to 32 bits and need room for the header and
+        // the trailing copy of the length.
+        if ( len < 12 || (len & 3) ) {
+            *err = "bad pcapng block length";
+            return -1;
+        }
+
+        if ( m->pos + len > m->size ) {
+            *err = "truncated pcapng block";
+            return -1;
+        }
+
+        m->pos += len;
+
+        switch ( type ) {
+        case PCAPNG_IDB:
+            if ( _pcapng_iface(m, p, len, err) < 0 )
+                return -1;
+
+            break;
+
+        case PCAPNG_EPB: {
+            uint32_t id = (len >= 32 ? _u32(m, p + 8) : 0);
+            uint32_t clen = (len >= 32 ? _u32(m, p + 20) : 0);
+
+            // Careful not to overflow with the untrusted clen.
+            if ( len < 32 || clen > len - 32 ) {
+                *err = "truncated pcapng packet block";
+                return -1;
+            }
+
+            if ( id >= m->num_ifaces ) {
+                *err = "pcapng packet block for unknown interface";
+                return -1;
+            }
+
+            uint64_t ts = ((uint64_t)_u32(m, p + 12) << 32) | _u32(m, p + 16);
+            *t = _pcapng_time(&m->ifaces[id], ts);
+            *data = p + 28;
+            *caplen = clen;
+            *linktype = m->ifaces[id].linktype;
+
+            __builtin_prefetch(m->data + m->pos);
+            return 1;
+        }
+
+        case PCAPNG_SPB: {
+            if ( len < 16 || ! m->num_ifaces ) {
+                *err = "bad pcapng simple packet block";
+                return -1;
+            }
+
+            uint32_t olen = _u32(m, p + 8);
+
+            // No timestamp with these.
+            *t = 0;
+            *data = p + 12;
+            *caplen = (olen < len - 16 ? olen : len - 16);
+            *linktype = m->ifaces[0].linktype;
+
+            __builtin_prefetch(m->data + m->pos);
+            return 1;
+        }
+
+        default:
+            // Skip anything else.
+            break;
+        }
+    }
+
+    return 0;
+}
+
+// Turns a packet inside the mapping into a bytes object referencing it.
+static hlt_bytes* _mmap_packet(hlt_iosrc* src, const uint8_t* data, size_t caplen, int linktype,
+                               int8_t keep_link_layer, hlt_exception** excpt,
+                               hlt_execution_context* ctx)
+{
+    __hlt_iosrc_mmap* m = (__hlt_iosrc_mmap*)src->mapping;
+
+    if ( ! keep_link_layer ) {
+        int datalink = (linktype == LINKTYPE_RAW ? DLT_RAW : linktype);
+        _strip_link_layer(src, (const char**)&data, &caplen, datalink, excpt, ctx);
+
+        if ( hlt_check_exception(excpt) )
+            return 0;
+    }
+
+    return hlt_bytes_new_from_backing((const int8_t*)data, caplen, &m->backing, excpt, ctx);
+}
+
+static void _mmap_close(hlt_iosrc* src)
+{
+    hlt_bytes_backing_unref(&((__hlt_iosrc_mmap*)src->mapping)->backing);
+    src->mapping = 0;
+}
+
 void hlt_iosrc_dtor(hlt_type_info* ti, hlt_iosrc* c, hlt_execution_context* ctx)
 {
     if ( c->handle )
         pcap_close(c->handle);
 
+    if ( c->mapping )
+        _mmap_close(c);
+
     GC_CLEAR(c->iface, hlt_string, ctx);
 }
 
@@ -163,6 +562,13 @@ hlt_iosrc* hlt_iosrc_new_offline(hlt_string interface, hlt_exception** excpt,
     if ( hlt_check_exception(excpt) )
         return 0;
 
+    src->mapping = _mmap_open(iface);
+
+    if ( src->mapping ) {
+        hlt_free(iface);
+        return src;
+    }
+
     char errbuf[PCAP_ERRBUF_SIZE];
     pcap_t* p = pcap_open_offline(iface, errbuf);
 
@@ -182,6 +588,29 @@ hlt_packet hlt_iosrc_read_try(hlt_iosrc* src, int8_t keep_link_layer, hlt_except
 {
     hlt_packet result = {0.0, NULL};
 
+    if ( src->mapping ) {
+        hlt_time t;
+        const uint8_t* data;
+        size_t caplen;
+        int linktype;
+        const char* err;
+
+        int rc = _mmap_next(src->mapping, &t, &data, &caplen, &linktype, &err);
+
+        if ( rc < 0 ) {
+            _raise_error(src, err, excpt, ctx);
+            return result;
+        }
+
+        if ( rc == 0 )
+            // No more packets.
+            return result;
+
+        result.t = t;
+        result.data = _mmap_packet(src, data, caplen, linktype, keep_link_layer, excpt, ctx);
+        return result;
+    }
+
     if ( ! src->handle ) {
         _raise_error(src, "already closed", excpt, ctx);
         return result;
@@ -191,10 +620,11 @@ hlt_packet hlt_iosrc_read_try(hlt_iosrc* src, int8_t keep_link_layer, hlt_except
     const u_char* data;
 
     int rc = pcap_next_ex(src->handle, &hdr, &data);
-    int caplen = hdr->caplen;
 
     if ( rc > 0 ) {
         // Got a packet.
+        size_t caplen = hdr->caplen;
+
         if ( ! keep_link_layer ) {
             _strip_link_layer(src, (const char**)&data, &caplen, pcap_datalink(src->handle), excpt,
                               ctx);
@@ -237,6 +667,235 @@ hlt_packet hlt_iosrc_read_try(hlt_iosrc* src, int8_t keep_link_layer, hlt_except
 
 void hlt_iosrc_close(hlt_iosrc* src, hlt_exception** excpt, hlt_execution_context* ctx)
 {
+    if ( src->mapping ) {
+        _mmap_close(src);
+        return;
+    }
+
     pcap_close(src->handle);
     src->handle = 0;
 }
+
+// State passed to the pcap_dispatch() callback when reading a batch.
+typedef struct {
+    hlt_iosrc* src;
+    hlt_vector* packets;
+    int8_t keep_link_layer;
+    int datalink;
+    hlt_exception** excpt;
+    hlt_execution_context* ctx;
+} __hlt_iosrc_batch;
+
+static void _batch_callback(u_char* user, const struct pcap_pkthdr* hdr, const u_char* data)
+{
+    __hlt_iosrc_batch* batch = (__hlt_iosrc_batch*)user;
+    hlt_exception** excpt = batch->excpt;
+    hlt_execution_context* ctx = batch->ctx;
+
+    if ( hlt_check_exception(excpt) )
+        return;
+
+    size_t caplen = hdr->caplen;
+
+    if ( ! batch->keep_link_layer ) {
+        _strip_link_layer(batch->src, (const char**)&data, &caplen, batch->datalink, excpt, ctx);
+        if ( hlt_check_exception(excpt) )
+            return;
+    }
+
+    // We need to copy it as pcap will reuse its buffer.
+    hlt_packet pkt;
+    pkt.t = hlt_time_value(hdr->ts.tv_sec, hdr->ts.tv_usec * 1000);
+    pkt.data = hlt_bytes_new_from_data_copy((const int8_t*)data, caplen, excpt, ctx);
+
+    if ( hlt_check_exception(excpt) )
+        return;
+
+    hlt_vector_push_back(batch->packets, &hlt_type_info_hlt_tuple_time_bytes, &pkt, excpt, ctx);
+}
+
+hlt_vector* hlt_iosrc_read_batch_try(hlt_iosrc* src, int64_t max, int8_t keep_link_layer,
+                                     hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( ! (src->handle || src->mapping) ) {
+        _raise_error(src, "already closed", excpt, ctx);
+        return 0;
+    }
+
+    if ( max <= 0 )
+        max = DEFAULT_BATCH_SIZE;
+
+    hlt_packet def = {0.0, NULL};
+
+    if ( src->mapping ) {
+        hlt_vector* packets =
+            hlt_vector_new(&hlt_type_info_hlt_tuple_time_bytes, &def, 0, excpt, ctx);
+        hlt_vector_reserve(packets, max, excpt, ctx);
+
+        for ( int64_t n = 0; n < max; n++ ) {
+            hlt_packet pkt;
+            const uint8_t* data;
+            size_t caplen;
+            int linktype;
+            const char* err;
+
+            int rc = _mmap_next(src->mapping, &pkt.t, &data, &caplen, &linktype, &err);
+
+            if ( rc < 0 ) {
+                _raise_error(src, err, excpt, ctx);
+                return 0;
+            }
+
+            if ( rc == 0 )
+                break;
+
+            pkt.data = _mmap_packet(src, data, caplen, linktype, keep_link_layer, excpt, ctx);
+
+            if ( hlt_check_exception(excpt) )
+                return 0;
+
+            hlt_vector_push_back(packets, &hlt_type_info_hlt_tuple_time_bytes, &pkt, excpt, ctx);
+        }
+
+        // Null if no more packets.
+        return hlt_vector_size(packets, excpt, ctx) ? packets : 0;
+    }
+
+    __hlt_iosrc_batch batch;
+    batch.src = src;
+    batch.packets = hlt_vector_new(&hlt_type_info_hlt_tuple_time_bytes, &def, 0, excpt, ctx);
+    batch.keep_link_layer = keep_link_layer;
+    batch.datalink = pcap_datalink(src->handle);
+    batch.excpt = excpt;
+    batch.ctx = ctx;
+
+    hlt_vector_reserve(batch.packets, max, excpt, ctx);
+
+    // pcap_dispatch() hands us everything that's available from its
+    // buffer (for live sources on Linux, that's the TPACKET_V3 ring) without
+    // further system calls, up to max.
+    int rc = pcap_dispatch(src->handle, max, _batch_callback, (u_char*)&batch);
+
+    if ( hlt_check_exception(excpt) )
+        return 0;
+
+    if ( rc > 0 )
+        return batch.packets;
+
+    if ( rc < 0 ) {
+        // Error.
+        _raise_error(src, 0, excpt, ctx);
+        pcap_close(src->handle);
+        src->handle = 0;
+        return 0;
+    }
+
+    if ( hlt_enum_equal(src->type, Hilti_IOSrc_PcapOffline, excpt, ctx) )
+        // No more packets.
+        return 0;
+
+    // No packet this time.
+    hlt_set_exception(excpt, &hlt_exception_would_block, 0, ctx);
+    return 0;
+}
+
+// Offsets into a packet's IP header, for hashing.
+static inline int _flow_fields(const uint8_t* p, uint64_t len, const uint8_t** a, const uint8_t** b,
+                               int* alen, uint8_t* proto, const uint8_t** ports)
+{
+    if ( len < 1 )
+        return 0;
+
+    int ports_offset = 0;
+
+    switch ( p[0] >> 4 ) {
+    case 4: {
+        int hlen = (p[0] & 0x0f) * 4;
+
+        if ( len < 20 || hlen < 20 )
+            return 0;
+
+        *proto = p[9];
+        *a = p + 12;
+        *b = p + 16;
+        *alen = 4;
+
+        // Only the first fragment carries the ports.
+        if ( ((p[6] & 0x1f) | p[7]) == 0 )
+            ports_offset = hlen;
+
+        break;
+    }
+
+    case 6:
+        if ( len < 40 )
+            return 0;
+
+        *proto = p[6];
+        *a = p + 8;
+        *b = p + 24;
+        *alen = 16;
+        ports_offset = 40;
+        break;
+
+    default:
+        return 0;
+    }
+
+    *ports = 0;
+
+    if ( ports_offset && (*proto == 6 || *proto == 17 || *proto == 132) &&
+         len >= ports_offset + 4 )
+        *ports = p + ports_offset;
+
+    return 1;
+}
+
+hlt_vthread_id hlt_iosrc_flow_vid(hlt_bytes* pkt, hlt_exception** excpt,
+                                  hlt_execution_context* ctx)
+{
+    const hlt_config* cfg = hlt_config_get();
+    hlt_vthread_id n = (cfg->vid_schedule_max - cfg->vid_schedule_min + 1);
+
+    // Packets coming out of an iosrc are stored in a single block, so we
+    // only need to look at the first one.
+    hlt_bytes_block block;
+    hlt_iterator_bytes start = hlt_bytes_begin(pkt, excpt, ctx);
+    hlt_iterator_bytes end = hlt_bytes_end(pkt, excpt, ctx);
+    hlt_bytes_iterate_raw(&block, 0, start, end, excpt, ctx);
+
+    const uint8_t* a;
+    const uint8_t* b;
+    const uint8_t* ports;
+    uint8_t proto;
+    int alen;
+
+    if ( ! _flow_fields((const uint8_t*)block.start, block.end - block.start, &a, &b, &alen,
+                        &proto, &ports) )
+        return cfg->vid_schedule_min;
+
+    // Order the endpoints so that both directions of a flow hash the same.
+    const uint8_t* pa = ports;
+    const uint8_t* pb = ports ? ports + 2 : 0;
+    int c = memcmp(a, b, alen);
+
+    if ( c > 0 || (c == 0 && ports && memcmp(pa, pb, 2) > 0) ) {
+        const uint8_t* tmp = a;
+        a = b;
+        b = tmp;
+        tmp = pa;
+        pa = pb;
+        pb = tmp;
+    }
+
+    hlt_hash h = hlt_hash_bytes((const int8_t*)a, alen, 0);
+    h = hlt_hash_bytes((const int8_t*)b, alen, h);
+    h = hlt_hash_bytes((const int8_t*)&proto, 1, h);
+
+    if ( ports ) {
+        h = hlt_hash_bytes((const int8_t*)pa, 2, h);
+        h = hlt_hash_bytes((const int8_t*)pb, 2, h);
+    }
+
+    return (h % n) + cfg->vid_schedule_min;
+}
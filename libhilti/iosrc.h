@@ -23,6 +23,7 @@
 #include "enum.h"
 #include "time_.h"
 #include "types.h"
+#include "vector.h"
 
 /// The type of an IOSource as one of the Hilti::IOSrc constants.
 typedef hlt_enum hlt_iosrc_type;
@@ -32,6 +33,7 @@ struct __hlt_iosrc {
     hlt_iosrc_type type; // Hilti_PktSrc_PcapLive or Hilti_PktSrc_PcapOffline.
     hlt_string iface;    // The name of the interface.
     void* handle;        // A kind-specific handle.
+    void* mapping;       // For offline sources, the memory-mapped trace if used instead of handle.
 };
 
 /// tuple<time, ref<bytes>>
@@ -54,7 +56,11 @@ typedef struct __hlt_iosrc hlt_iosrc;
 extern hlt_iosrc* hlt_iosrc_new_live(hlt_string interface, hlt_exception** excpt,
                                      hlt_execution_context* ctx);
 
-/// Creates a new PCAP packet source for offline input.
+/// Creates a new PCAP packet source for offline input. If the trace is a
+/// regular pcap or pcapng file, it is memory-mapped and packets returned by
+/// the read functions point directly into the mapping rather than being
+/// copied; the mapping remains alive as long as any of them does. Other
+/// inputs (e.g., stdin) are read through libpcap.
 ///
 /// interface: The name of the trace file.
 ///
@@ -81,6 +87,39 @@ extern hlt_iosrc* hlt_iosrc_new_offline(hlt_string interface, hlt_exception** ex
 extern hlt_packet hlt_iosrc_read_try(hlt_iosrc* src, int8_t keep_link_layer, hlt_exception** excpt,
                                      hlt_execution_context* ctx);
 
+/// Attempts to read a batch of packets from a PCAP source at once. This
+/// returns whatever libpcap has buffered, up to a limit, without going
+/// through the OS for each packet. If no packet is currently available,
+/// raises a WouldBlock exception if there might be one at a later time. If
+/// the source is permanently exhausted, returns null.
+///
+/// src: The packet source.
+///
+/// max: The maximum number of packets to return, or zero for a default.
+///
+/// keep_link_layer: If not true, any link layer headers are stripped.
+///
+/// Returns: A vector of tuples <hlt_time, hlt_bytes*> as returned by
+/// hlt_iosrc_read_try(), or null if the source is exhausted.
+///
+/// Raises: IOError if there are any errors other than those described
+/// above.
+extern hlt_vector* hlt_iosrc_read_batch_try(hlt_iosrc* src, int64_t max, int8_t keep_link_layer,
+                                            hlt_exception** excpt, hlt_execution_context* ctx);
+
+/// Computes a virtual thread ID for a packet from its flow, i.e., from its
+/// IP addresses, transport protocol, and (for TCP, UDP, and SCTP) ports.
+/// Both directions of a flow map to the same ID, which lies inside the
+/// range configured by ``vid_schedule_min`` and ``vid_schedule_max``.
+/// Non-IP packets all map to ``vid_schedule_min``.
+///
+/// pkt: The packet, starting with its IP header (i.e., with the link layer
+/// already stripped).
+///
+/// Returns: The virtual thread ID.
+extern hlt_vthread_id hlt_iosrc_flow_vid(hlt_bytes* pkt, hlt_exception** excpt,
+                                         hlt_execution_context* ctx);
+
 /// Closes a live PCAP packet source. Any attempt to read further packets
 /// will result in an IOSrcError exception.
 ///
@@ -206,6 +206,8 @@ declare %hlt.timer*     @__hlt_timer_new_function(%hlt.callable*, %hlt.exception
 
 declare %hlt.type_info* @__hlt_union_type(%hlt.type_info*, i8*)
 
+declare void @__hlt_profiler_pgo_register(i8**, i64**, i64)
+
 declare i8* @__hlt_malloc(i64, i8*, i8*)
 declare void @__hlt_free(i8*, i8*, i8*)
 
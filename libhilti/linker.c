@@ -1,26 +1,53 @@
 
 // Weak versions of functions that are generated by the HILTI linker. These
 // exist so that one can link JITing host applications against the library.
-// However, these versions should never actually execute.
+// However, these versions should never actually execute unless a JIT
+// registers the generated versions through __hlt_linker_register().
 
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "linker.h"
 
+#ifdef __OPTIMIZE__
+// Marks an optimized build of the runtime. The build and the JIT check for
+// this before using the native runtime library in release mode.
+const int8_t __hlt_runtime_optimized = 1;
+#endif
+
+static void (*_modules_init)(void* ctx) = 0;
+static void (*_globals_init)(void* ctx) = 0;
+static void (*_globals_dtor)(void* ctx) = 0;
+static uint64_t (*_globals_size)() = 0;
+
+void __hlt_linker_register(void (*modules_init)(void*), void (*globals_init)(void*),
+                           void (*globals_dtor)(void*), uint64_t (*globals_size)())
+{
+    _modules_init = modules_init;
+    _globals_init = globals_init;
+    _globals_dtor = globals_dtor;
+    _globals_size = globals_size;
+}
+
 __attribute__((weak)) void __hlt_modules_init(void* ctx)
 {
+    if ( _modules_init )
+        (*_modules_init)(ctx);
 }
 
 __attribute__((weak)) void __hlt_globals_init(void* ctx)
 {
+    if ( _globals_init )
+        (*_globals_init)(ctx);
 }
 
 __attribute__((weak)) void __hlt_globals_dtor(void* ctx)
 {
+    if ( _globals_dtor )
+        (*_globals_dtor)(ctx);
 }
 
 __attribute__((weak)) uint64_t __hlt_globals_size()
 {
-    return 0;
+    return _globals_size ? (*_globals_size)() : 0;
 }
@@ -12,4 +12,11 @@ extern void __hlt_globals_init(void* ctx);
 extern void __hlt_globals_dtor(void* ctx);
 extern uint64_t __hlt_globals_size() __attribute__((weak));
 
+/// Registers the linker-generated functions of JITed code with a natively
+/// compiled runtime library. The library's weak versions of the functions
+/// above then forward to these. Null pointers leave the corresponding
+/// default in place.
+extern void __hlt_linker_register(void (*modules_init)(void*), void (*globals_init)(void*),
+                                  void (*globals_dtor)(void*), uint64_t (*globals_size)());
+
 #endif
@@ -129,18 +129,20 @@ static void _unlink(hlt_list* l, __hlt_list_node* n, hlt_exception** excpt,
     GC_DTOR(n, __hlt_list_node, ctx);
 }
 
-// Returns a ref'ed node. Val not yet ref'ed.
-static __hlt_list_node* _make_node(hlt_list* l, void* val, hlt_exception** excpt,
-                                   hlt_execution_context* ctx)
+// Returns a ref'ed node. Val not yet ref'ed. The type must be equal to the
+// list's element type; we use the caller's as that's a compile-time
+// constant the optimizer can specialize for.
+static __hlt_list_node* _make_node(hlt_list* l, const hlt_type_info* type, void* val,
+                                   hlt_exception** excpt, hlt_execution_context* ctx)
 {
     __hlt_list_node* n =
-        GC_NEW_CUSTOM_SIZE_REF(__hlt_list_node, sizeof(__hlt_list_node) + l->type->size, ctx);
+        GC_NEW_CUSTOM_SIZE_REF(__hlt_list_node, sizeof(__hlt_list_node) + type->size, ctx);
     n->type = l->type;
 
     // Other fields are null initialized.
 
-    memcpy(&n->data, val, l->type->size);
-    GC_CCTOR_GENERIC(&n->data, l->type, ctx);
+    memcpy(&n->data, val, type->size);
+    GC_CCTOR_GENERIC(&n->data, type, ctx);
 
     hlt_time t =
         (l->tmgr && l->timeout) ? hlt_timer_mgr_current(l->tmgr, excpt, ctx) + l->timeout : 0;
@@ -284,7 +286,7 @@ void hlt_list_push_front(hlt_list* l, const hlt_type_info* type, void* val, hlt_
 {
     assert(__hlt_type_equal(l->type, type));
 
-    __hlt_list_node* n = _make_node(l, val, excpt, ctx);
+    __hlt_list_node* n = _make_node(l, type, val, excpt, ctx);
     if ( ! n ) {
         hlt_set_exception(excpt, &hlt_exception_out_of_memory, 0, ctx);
         return;
@@ -300,7 +302,7 @@ void hlt_list_push_back(hlt_list* l, const hlt_type_info* type, void* val, hlt_e
 
     assert(__hlt_type_equal(l->type, type));
 
-    __hlt_list_node* n = _make_node(l, val, excpt, ctx);
+    __hlt_list_node* n = _make_node(l, type, val, excpt, ctx);
     if ( ! n ) {
         hlt_set_exception(excpt, &hlt_exception_out_of_memory, 0, ctx);
         return;
@@ -397,7 +399,7 @@ void hlt_list_insert(const hlt_type_info* type, void* val, hlt_iterator_list i,
 
     assert(__hlt_type_equal(i.list->type, type));
 
-    __hlt_list_node* n = _make_node(i.list, val, excpt, ctx);
+    __hlt_list_node* n = _make_node(i.list, type, val, excpt, ctx);
     if ( ! n ) {
         hlt_set_exception(excpt, &hlt_exception_out_of_memory, 0, ctx);
         return;
@@ -59,6 +59,12 @@ typedef struct __hlt_set {
     __khval_set_t* vals;
 } kh_set_t;
 
+// The type passed into these is always the one the caller of the public
+// functions provided, not the one stored with the container. For generated
+// code, that's a constant the optimizer can specialize the functions for,
+// turning the indirect calls into direct ones (see codegen::Optimizer). For
+// the same reason, the functions below generally prefer the caller's types
+// over the stored ones where both are available; they are always equal.
 static inline hlt_hash _kh_hash_func(const void* obj, const hlt_type_info* type)
 {
     return (*type->hash)(type, obj, 0, 0);
@@ -419,7 +425,7 @@ void hlt_map_insert(hlt_map* m, const hlt_type_info* tkey, void* key, const hlt_
 
         // Delete the old value.
         void* val = kh_value(m, i).val;
-        GC_DTOR_GENERIC(val, m->tvalue, ctx);
+        GC_DTOR_GENERIC(val, tval, ctx);
         hlt_free(val);
 
         // Update timer.
@@ -439,11 +445,11 @@ void hlt_map_insert(hlt_map* m, const hlt_type_info* tkey, void* key, const hlt_
         else
             kh_value(m, i).timer = 0;
 
-        GC_CCTOR_GENERIC(keytmp, m->tkey, ctx);
+        GC_CCTOR_GENERIC(keytmp, tkey, ctx);
     }
 
     kh_value(m, i).val = valtmp;
-    GC_CCTOR_GENERIC(valtmp, m->tvalue, ctx);
+    GC_CCTOR_GENERIC(valtmp, tval, ctx);
 }
 
 int8_t hlt_map_exists(hlt_map* m, const hlt_type_info* type, void* key, hlt_exception** excpt,
@@ -479,7 +485,7 @@ void hlt_map_remove(hlt_map* m, const hlt_type_info* type, void* key, hlt_except
         }
 
         void* key = kh_key(m, i);
-        GC_DTOR_GENERIC(key, m->tkey, ctx);
+        GC_DTOR_GENERIC(key, type, ctx);
         hlt_free(key);
 
         void* val = kh_value(m, i).val;
@@ -855,7 +861,7 @@ void hlt_set_insert(hlt_set* m, const hlt_type_info* tkey, void* key, hlt_except
         else
             kh_value(m, i) = 0;
 
-        GC_CCTOR_GENERIC(keytmp, m->tkey, ctx);
+        GC_CCTOR_GENERIC(keytmp, tkey, ctx);
     }
 }
 
@@ -892,7 +898,7 @@ void hlt_set_remove(hlt_set* m, const hlt_type_info* type, void* key, hlt_except
         }
 
         void* key = kh_key(m, i);
-        GC_DTOR_GENERIC(key, m->tkey, ctx);
+        GC_DTOR_GENERIC(key, type, ctx);
         hlt_free(key);
 
         kh_del_set(m, i);
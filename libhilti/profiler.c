@@ -15,6 +15,10 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "autogen/hilti-hlt.h"
@@ -23,6 +27,7 @@
 #include "hutil.h"
 #include "profiler.h"
 #include "string_.h"
+#include "threading.h"
 #include "timer.h"
 #include "utf8proc.h"
 
@@ -53,6 +58,14 @@ typedef struct {
     uint64_t user;    // Value of user counter currently.
 } __hlt_profiler;
 
+// A module's counters for profile-guided optimization.
+struct __hlt_pgo_counters {
+    const char** keys;               // The counters' keys.
+    uint64_t** counters;             // Pointers to the counters.
+    uint64_t size;                   // Number of counters.
+    struct __hlt_pgo_counters* next; // Next module.
+};
+
 typedef struct __kh_table_t {
     // These are used by khash and copied from there (see README.HILTI).
     khint_t n_buckets, size, n_occupied, upper_bound;
@@ -434,10 +447,63 @@ void hlt_profiler_timer_expire(hlt_string tag, hlt_exception** excpt, hlt_execut
     install_timer(p, excpt, ctx);
 }
 
+static void _fatal_error(const char* msg)
+{
+    fprintf(stderr, "libhilti profiler: %s\n", msg);
+    exit(1);
+}
+
+static void pgo_write()
+{
+    // We append so that the file accumulates multiple runs. Readers add up
+    // all counts with the same key.
+    const char* fname = hlt_config_get()->pgo_file;
+    FILE* out = fopen(fname, "a");
+
+    if ( ! out ) {
+        fprintf(stderr, "libhilti: cannot write profile to %s: %s\n", fname, strerror(errno));
+        return;
+    }
+
+    for ( __hlt_pgo_counters* c = __hlt_globals()->pgo_counters; c; c = c->next ) {
+        for ( uint64_t i = 0; i < c->size; i++ )
+            fprintf(out, "%s %" PRIu64 "\n", c->keys[i], *c->counters[i]);
+    }
+
+    fclose(out);
+}
+
+void __hlt_profiler_pgo_register(const char** keys, uint64_t** counters, uint64_t n)
+{
+    // The module init functions run for every new execution context.
+    if ( hlt_is_multi_threaded() && pthread_mutex_lock(&__hlt_globals()->pgo_lock) != 0 )
+        _fatal_error("cannot lock mutex");
+
+    __hlt_pgo_counters* c = __hlt_globals()->pgo_counters;
+
+    while ( c && c->counters != counters )
+        c = c->next;
+
+    if ( ! c ) {
+        c = hlt_malloc(sizeof(__hlt_pgo_counters));
+        c->keys = keys;
+        c->counters = counters;
+        c->size = n;
+        c->next = __hlt_globals()->pgo_counters;
+        __hlt_globals()->pgo_counters = c;
+    }
+
+    if ( hlt_is_multi_threaded() && pthread_mutex_unlock(&__hlt_globals()->pgo_lock) != 0 )
+        _fatal_error("cannot unlock mutex");
+}
+
 void __hlt_profiler_init()
 {
     __hlt_globals()->profiling_enabled = hlt_config_get()->profiling;
 
+    if ( hlt_is_multi_threaded() && pthread_mutex_init(&__hlt_globals()->pgo_lock, 0) != 0 )
+        _fatal_error("cannot init mutex");
+
 #ifdef HAVE_PAPI
     if ( __hlt_globals()->profiling_enabled )
         init_papi();
@@ -447,6 +513,22 @@ void __hlt_profiler_init()
 void __hlt_profiler_done()
 {
     __hlt_globals()->profiling_enabled = 0;
+
+    if ( __hlt_globals()->pgo_counters )
+        pgo_write();
+
+    __hlt_pgo_counters* c = __hlt_globals()->pgo_counters;
+
+    while ( c ) {
+        __hlt_pgo_counters* next = c->next;
+        hlt_free(c);
+        c = next;
+    }
+
+    __hlt_globals()->pgo_counters = 0;
+
+    if ( hlt_is_multi_threaded() && pthread_mutex_destroy(&__hlt_globals()->pgo_lock) != 0 )
+        _fatal_error("cannot destroy mutex");
 }
 
 void hlt_profiler_start(hlt_string tag, hlt_enum style, uint64_t param, hlt_timer_mgr* tmgr,
@@ -21,6 +21,16 @@ extern void __hlt_profiler_state_delete(__hlt_profiler_state* state);
 extern void __hlt_profiler_init();
 extern void __hlt_profiler_done();
 
+// Registers a module's counters for profile-guided optimization, so that
+// they are written out when the runtime terminates. Generated code calls
+// this from each module's init function; repeated registration of the same
+// counters is ignored.
+//
+// keys: The counters' keys.
+// counters: Pointers to the counters, in the same order as keys.
+// n: The number of counters.
+extern void __hlt_profiler_pgo_register(const char** keys, uint64_t** counters, uint64_t n);
+
 // Cookie for timer-based snapshots.
 typedef hlt_string __hlt_profiler_timer_cookie;
 
@@ -820,6 +820,15 @@ void __hlt_thread_mgr_schedule(hlt_thread_mgr* mgr, hlt_vthread_id vid, hlt_call
     _worker_schedule(ctx->worker, thread, vid, func, 0, 0, ctx);
 }
 
+void hlt_thread_mgr_flush(hlt_thread_mgr* mgr, hlt_vthread_id vid, hlt_execution_context* ctx)
+{
+    if ( ! hlt_is_multi_threaded() )
+        return;
+
+    hlt_worker_thread* thread = _vthread_to_worker(mgr, vid);
+    hlt_thread_queue_flush(thread->jobs, ctx->worker ? ctx->worker->id : 0);
+}
+
 void __hlt_thread_mgr_schedule_tcontext(hlt_thread_mgr* mgr, hlt_type_info* type, void* tcontext,
                                         hlt_callable* func, hlt_exception** excpt,
                                         hlt_execution_context* ctx)
@@ -236,6 +236,20 @@ extern void __hlt_thread_mgr_schedule_tcontext(hlt_thread_mgr* mgr, hlt_type_inf
                                                void* tcontext, hlt_callable* func,
                                                hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Makes all jobs that the current native thread has scheduled to a
+/// virtual thread available to its worker right away. Normally, scheduled
+/// jobs are passed on in batches.
+///
+/// This function is safe to call from all threads.
+///
+/// mgr: The thread manager to use.
+///
+/// vid: The ID of the virtual target thread.
+///
+/// ctx: The caller's execution context.
+extern void hlt_thread_mgr_flush(hlt_thread_mgr* mgr, hlt_vthread_id vid,
+                                 hlt_execution_context* ctx);
+
 /// Checks whether any worker thread has raised an uncaught exception. In
 /// that case, all worker threads will have been terminated, and this
 /// function willl raise an hlt_exception_uncaught_thread_exception.
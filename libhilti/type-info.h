@@ -29,6 +29,7 @@ extern const hlt_type_info hlt_type_info_hlt_iterator_map;
 extern const hlt_type_info hlt_type_info_hlt_file;
 extern const hlt_type_info hlt_type_info_hlt_tuple_iterator_bytes_iterator_bytes;
 extern const hlt_type_info hlt_type_info_hlt_tuple_bytes_bytes;
+extern const hlt_type_info hlt_type_info_hlt_tuple_time_bytes;
 extern const hlt_type_info hlt_type_info_hlt_match_token_state;
 extern const hlt_type_info hlt_type_info_hlt_classifier;
 extern const hlt_type_info hlt_type_info_hlt_port;
@@ -19,11 +19,13 @@ typedef struct __hlt_list hlt_list;
 
 typedef struct __hlt_thread_mgr_blockable __hlt_thread_mgr_blockable;
 typedef struct __hlt_profiler_state __hlt_profiler_state;
+typedef struct __hlt_pgo_counters __hlt_pgo_counters;
 typedef struct __hlt_file_info __hlt_file_info;
 typedef struct __hlt_pointer_stack __hlt_pointer_stack;
 typedef struct __hlt_pointer_map __hlt_pointer_map;
 typedef struct __hlt_clone_state __hlt_clone_state;
 typedef struct __hlt_fiber_pool __hlt_fiber_pool;
+typedef struct __hlt_fiber_depot __hlt_fiber_depot;
 typedef struct __hlt_memory_nullbuffer __hlt_memory_nullbuffer;
 
 /// Type for hash values.
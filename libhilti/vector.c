@@ -3,9 +3,11 @@
 //
 //
 
+#include <stdint.h>
 #include <stdio.h>
 
 #include "autogen/hilti-hlt.h"
+#include "bytes.h"
 #include "enum.h"
 #include "int.h"
 #include "interval.h"
@@ -78,9 +80,23 @@ static inline void _access_entry(hlt_vector* v, hlt_vector_idx i, hlt_exception*
     hlt_timer_update(v->timers[i], t, excpt, ctx);
 }
 
-// Val is not yet ref'ed.
-static inline void _set_entry(hlt_vector* v, hlt_vector_idx i, void* val, int dtor,
-                              hlt_exception** excpt, hlt_execution_context* ctx)
+static inline void _start_timer(hlt_vector* v, hlt_vector_idx i, hlt_exception** excpt,
+                                hlt_execution_context* ctx)
+{
+    GC_CCTOR(v, hlt_vector, ctx);
+    __hlt_vector_timer_cookie cookie = {v, i};
+    v->timers[i] = __hlt_timer_new_vector(cookie, excpt, ctx); // Not memory-managed on our end.
+    hlt_time t = hlt_timer_mgr_current(v->tmgr, excpt, ctx) + v->timeout;
+    hlt_timer_mgr_schedule(v->tmgr, t, v->timers[i], excpt, ctx);
+    GC_DTOR(v->timers[i], hlt_timer, ctx); // Not memory-managed on our end.
+}
+
+// The type must be equal to the vector's element type; we use the caller's
+// as that's a compile-time constant the optimizer can specialize for. Val
+// is not yet ref'ed.
+static inline void _set_entry(hlt_vector* v, hlt_vector_idx i, const hlt_type_info* type,
+                              void* val, int dtor, hlt_exception** excpt,
+                              hlt_execution_context* ctx)
 {
     // Cancel old timer if active.
     if ( v->tmgr && v->timers && v->timers[i] ) {
@@ -88,25 +104,19 @@ static inline void _set_entry(hlt_vector* v, hlt_vector_idx i, void* val, int dt
         v->timers[i] = 0;
     }
 
-    char* dst = (char*)v->elems + i * v->type->size;
+    char* dst = (char*)v->elems + i * type->size;
 
     if ( dtor )
-        GC_DTOR_GENERIC(dst, v->type, ctx);
+        GC_DTOR_GENERIC(dst, type, ctx);
 
-    memcpy(dst, val, v->type->size);
-    GC_CCTOR_GENERIC(dst, v->type, ctx);
+    memcpy(dst, val, type->size);
+    GC_CCTOR_GENERIC(dst, type, ctx);
 
     v->occupied[i] = 1;
 
     // Start timer if needed.
-    if ( v->tmgr && v->timeout ) {
-        GC_CCTOR(v, hlt_vector, ctx);
-        __hlt_vector_timer_cookie cookie = {v, i};
-        v->timers[i] = __hlt_timer_new_vector(cookie, excpt, ctx); // Not memory-managed on our end.
-        hlt_time t = hlt_timer_mgr_current(v->tmgr, excpt, ctx) + v->timeout;
-        hlt_timer_mgr_schedule(v->tmgr, t, v->timers[i], excpt, ctx);
-        GC_DTOR(v->timers[i], hlt_timer, ctx); // Not memory-managed on our end.
-    }
+    if ( v->tmgr && v->timeout )
+        _start_timer(v, i, excpt, ctx);
 }
 
 static inline void _hlt_vector_init(hlt_vector* v, const hlt_type_info* elemtype, const void* def,
@@ -281,7 +291,7 @@ void hlt_vector_set(hlt_vector* v, hlt_vector_idx i, const hlt_type_info* elemty
     if ( i > v->last )
         v->last = i;
 
-    _set_entry(v, i, val, 1, excpt, ctx);
+    _set_entry(v, i, elemtype, val, 1, excpt, ctx);
 }
 
 int8_t hlt_vector_exists(hlt_vector* v, hlt_vector_idx i, hlt_exception** excpt,
@@ -314,7 +324,129 @@ void hlt_vector_push_back(hlt_vector* v, const hlt_type_info* elemtype, void* va
         v->timers[v->last] = 0;
     }
 
-    _set_entry(v, v->last, val, 0, excpt, ctx);
+    _set_entry(v, v->last, elemtype, val, 0, excpt, ctx);
+}
+
+// Maps an integer format to its width in bytes and whether its byte order
+// differs from the host's. Returns false for other formats.
+static int8_t _int_format(hlt_enum fmt, int* width, int8_t* swap, hlt_exception** excpt,
+                          hlt_execution_context* ctx)
+{
+    const struct {
+        hlt_enum fmt;
+        int width;
+        int order; // 0: host; 1: big; 2: little
+    } formats[] = {
+        {Hilti_Packed_Int8, 1, 0},         {Hilti_Packed_Int16, 2, 0},
+        {Hilti_Packed_Int32, 4, 0},        {Hilti_Packed_Int64, 8, 0},
+        {Hilti_Packed_Int8Big, 1, 1},      {Hilti_Packed_Int16Big, 2, 1},
+        {Hilti_Packed_Int32Big, 4, 1},     {Hilti_Packed_Int64Big, 8, 1},
+        {Hilti_Packed_Int8Little, 1, 2},   {Hilti_Packed_Int16Little, 2, 2},
+        {Hilti_Packed_Int32Little, 4, 2},  {Hilti_Packed_Int64Little, 8, 2},
+        {Hilti_Packed_UInt8, 1, 0},        {Hilti_Packed_UInt16, 2, 0},
+        {Hilti_Packed_UInt32, 4, 0},       {Hilti_Packed_UInt64, 8, 0},
+        {Hilti_Packed_UInt8Big, 1, 1},     {Hilti_Packed_UInt16Big, 2, 1},
+        {Hilti_Packed_UInt32Big, 4, 1},    {Hilti_Packed_UInt64Big, 8, 1},
+        {Hilti_Packed_UInt8Little, 1, 2},  {Hilti_Packed_UInt16Little, 2, 2},
+        {Hilti_Packed_UInt32Little, 4, 2}, {Hilti_Packed_UInt64Little, 8, 2},
+    };
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    static const int host = 2;
+#else
+    static const int host = 1;
+#endif
+
+    for ( int i = 0; i < sizeof(formats) / sizeof(formats[0]); i++ ) {
+        if ( ! hlt_enum_equal(fmt, formats[i].fmt, excpt, ctx) )
+            continue;
+
+        *width = formats[i].width;
+        *swap = (formats[i].order != 0 && formats[i].order != host);
+        return 1;
+    }
+
+    return 0;
+}
+
+void hlt_vector_append_unpacked(hlt_vector* v, hlt_iterator_bytes begin, hlt_vector_idx n,
+                                hlt_enum fmt, hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( n <= 0 )
+        return;
+
+    int width;
+    int8_t swap;
+
+    if ( ! _int_format(fmt, &width, &swap, excpt, ctx) || v->type->size != width ) {
+        hlt_set_exception(excpt, &hlt_exception_value_error, 0, ctx);
+        return;
+    }
+
+    hlt_vector_idx first = v->last + 1;
+
+    // The count may come from untrusted input; don't let any of the size
+    // computations below wrap.
+    if ( (uint64_t)n > SIZE_MAX / width || n > INT64_MAX - first ) {
+        hlt_set_exception(excpt, &hlt_exception_value_error, 0, ctx);
+        return;
+    }
+
+    if ( first + n > v->capacity ) {
+        hlt_vector_reserve(v, first + n, excpt, ctx);
+
+        if ( *excpt || v->capacity < first + n )
+            return;
+    }
+
+    hlt_iterator_bytes end = hlt_iterator_bytes_incr_by(begin, n * width, excpt, ctx);
+
+    if ( *excpt )
+        return;
+
+    // Copy the raw data directly into the element array, then fix the byte
+    // order in place. Integers don't need any memory management.
+    char* dst = (char*)v->elems + first * width;
+
+    if ( ! hlt_bytes_sub_raw((int8_t*)dst, n * width, begin, end, excpt, ctx) )
+        return;
+
+    if ( swap ) {
+        switch ( width ) {
+        case 2: {
+            uint16_t* p = (uint16_t*)dst;
+            for ( hlt_vector_idx i = 0; i < n; i++ )
+                p[i] = __builtin_bswap16(p[i]);
+            break;
+        }
+
+        case 4: {
+            uint32_t* p = (uint32_t*)dst;
+            for ( hlt_vector_idx i = 0; i < n; i++ )
+                p[i] = __builtin_bswap32(p[i]);
+            break;
+        }
+
+        case 8: {
+            uint64_t* p = (uint64_t*)dst;
+            for ( hlt_vector_idx i = 0; i < n; i++ )
+                p[i] = __builtin_bswap64(p[i]);
+            break;
+        }
+        }
+    }
+
+    memset(v->occupied + first, 1, n);
+
+    if ( v->timers )
+        memset(v->timers + first, 0, sizeof(hlt_timer*) * n);
+
+    v->last = first + n - 1;
+
+    if ( v->tmgr && v->timeout ) {
+        for ( hlt_vector_idx i = first; i <= v->last; i++ )
+            _start_timer(v, i, excpt, ctx);
+    }
 }
 
 hlt_vector_idx hlt_vector_size(hlt_vector* v, hlt_exception** excpt, hlt_execution_context* ctx)
@@ -345,6 +477,11 @@ void hlt_vector_reserve(hlt_vector* v, hlt_vector_idx n, hlt_exception** excpt,
     if ( v->capacity >= n )
         return;
 
+    if ( (uint64_t)n > SIZE_MAX / v->type->size || (uint64_t)n > SIZE_MAX / sizeof(hlt_timer*) ) {
+        hlt_set_exception(excpt, &hlt_exception_out_of_memory, 0, ctx);
+        return;
+    }
+
     v->elems = hlt_realloc(v->elems, v->type->size * n, v->type->size * v->capacity);
     v->occupied = hlt_realloc(v->occupied, n, v->capacity);
 
@@ -16,6 +16,7 @@ struct __hlt_iterator_vector {
 };
 
 struct __hlt_timer_mgr;
+struct hlt_iterator_bytes;
 
 /// Cookie for entry expiration timers.
 typedef struct __hlt_iterator_vector __hlt_vector_timer_cookie;
@@ -46,6 +47,15 @@ extern int8_t hlt_vector_exists(hlt_vector* m, hlt_vector_idx i, hlt_exception**
 extern void hlt_vector_push_back(hlt_vector* v, const hlt_type_info* elemtype, void* val,
                                  hlt_exception** excpt, hlt_execution_context* ctx);
 
+// Appends n integers unpacked from binary data starting at begin. fmt must
+// be one of the integer formats of Hilti::Packed, with a width matching the
+// vector's element type. The data must be fully available already. This is
+// equivalent to unpacking and pushing back the elements one by one, but
+// copies the data directly into the vector's storage.
+extern void hlt_vector_append_unpacked(hlt_vector* v, struct hlt_iterator_bytes begin,
+                                       hlt_vector_idx n, hlt_enum fmt, hlt_exception** excpt,
+                                       hlt_execution_context* ctx);
+
 // Returns the size of the vector (i.e., the largest valid index + 1 )
 extern hlt_vector_idx hlt_vector_size(hlt_vector* v, hlt_exception** excpt,
                                       hlt_execution_context* ctx);
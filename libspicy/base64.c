@@ -1,9 +1,204 @@
 
 #include "base64.h"
 
-#include "3rdparty/libb64/include/b64/cdecode.h"
 #include "3rdparty/libb64/include/b64/cencode.h"
 
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+// Maps characters to their 6-bit values, or 0xff if not part of the base64
+// alphabet.
+static const uint8_t _values[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+#ifdef __SSSE3__
+
+// Decodes 16 characters into 12 bytes, using the approach described by
+// Wojciech Mula and Daniel Lemire in "Faster Base64 Encoding and Decoding
+// using AVX2 Instructions". Returns false if not all characters are part of
+// the alphabet. Writes 16 bytes into out in either case.
+static inline int _decode16(const uint8_t* in, uint8_t* out)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+    __m128i str = _mm_loadu_si128((const __m128i*)in);
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+
+    if ( _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) )
+        return 0;
+
+    __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+    str = _mm_add_epi8(str, roll);
+
+    // Pack the 6-bit values into 24-bit groups.
+    str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+    str = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storeu_si128((__m128i*)out, str);
+    return 1;
+}
+
+#endif
+
+#ifdef __AVX2__
+
+// Like _decode16(), but for 32 characters into 24 bytes. Writes 32 bytes
+// into out.
+static inline int _decode32(const uint8_t* in, uint8_t* out)
+{
+    const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a, 0x15, 0x11,
+                                            0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+                                            0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                            0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0,
+                                              0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+    __m256i str = _mm256_loadu_si256((const __m256i*)in);
+    __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+    __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+    __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+
+    if ( _mm256_movemask_epi8(
+             _mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())) )
+        return 0;
+
+    __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+    __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+    str = _mm256_add_epi8(str, roll);
+
+    str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+    str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+    str = _mm256_shuffle_epi8(str, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                                                    -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                                    -1, -1, -1, -1));
+    str = _mm256_permutevar8x32_epi32(str, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+    _mm256_storeu_si256((__m256i*)out, str);
+    return 1;
+}
+
+#endif
+
+void __spicy_base64_init(__spicy_base64_state* state)
+{
+    state->step = 0;
+    state->plain = 0;
+}
+
+size_t __spicy_base64_decode(__spicy_base64_state* state, const uint8_t* in, size_t len,
+                             uint8_t* out)
+{
+    const uint8_t* end = in + len;
+    uint8_t* o = out;
+
+    while ( in < end ) {
+        if ( state->step == 0 ) {
+            // At a group boundary, so we can take larger steps as long as
+            // all characters are valid.
+#ifdef __AVX2__
+            while ( end - in >= 32 && _decode32(in, o) ) {
+                in += 32;
+                o += 24;
+            }
+#endif
+
+#ifdef __SSSE3__
+            while ( end - in >= 16 && _decode16(in, o) ) {
+                in += 16;
+                o += 12;
+            }
+#endif
+
+            while ( end - in >= 4 ) {
+                uint8_t a = _values[in[0]];
+                uint8_t b = _values[in[1]];
+                uint8_t c = _values[in[2]];
+                uint8_t d = _values[in[3]];
+
+                if ( (a | b | c | d) & 0x80 )
+                    break;
+
+                uint32_t x = (a << 18) | (b << 12) | (c << 6) | d;
+                o[0] = (x >> 16);
+                o[1] = (x >> 8);
+                o[2] = x;
+                o += 3;
+                in += 4;
+            }
+
+            if ( in == end )
+                break;
+        }
+
+        // One character at a time, skipping anything not in the alphabet
+        // (including padding and line breaks).
+        uint8_t c = _values[*in++];
+
+        if ( c & 0x80 )
+            continue;
+
+        switch ( state->step ) {
+        case 0:
+            state->plain = (c << 2);
+            state->step = 1;
+            break;
+
+        case 1:
+            *o++ = state->plain | (c >> 4);
+            state->plain = (c << 4);
+            state->step = 2;
+            break;
+
+        case 2:
+            *o++ = state->plain | (c >> 2);
+            state->plain = (c << 6);
+            state->step = 3;
+            break;
+
+        case 3:
+            *o++ = state->plain | c;
+            state->step = 0;
+            break;
+        }
+    }
+
+    return o - out;
+}
+
 hlt_bytes* spicy_base64_encode(hlt_bytes* b, hlt_exception** excpt,
                                hlt_execution_context* ctx) // &noref
 {
@@ -49,17 +244,17 @@ hlt_bytes* spicy_base64_decode(hlt_bytes* b, hlt_exception** excpt,
 
     void* cookie = 0;
 
-    base64_decodestate state;
-    base64_init_decodestate(&state);
+    __spicy_base64_state state;
+    __spicy_base64_init(&state);
 
     while ( 1 ) {
         cookie = hlt_bytes_iterate_raw(&block, cookie, start, end, excpt, ctx);
 
-        int len_in = block.end - block.start;
-        int8_t out[len_in * 2];
+        size_t len_in = block.end - block.start;
+        uint8_t* out = hlt_malloc(__spicy_base64_decode_size(len_in));
 
-        int len_out = base64_decode_block((const char*)block.start, len_in, (char*)out, &state);
-        hlt_bytes_append_raw_copy(result, out, len_out, excpt, ctx);
+        size_t len_out = __spicy_base64_decode(&state, (const uint8_t*)block.start, len_in, out);
+        hlt_bytes_append_raw(result, (int8_t*)out, len_out, excpt, ctx);
 
         if ( ! cookie )
             break;
@@ -3,6 +3,36 @@
 
 #include "libspicy.h"
 
+/// State for incrementally decoding base64 with __spicy_base64_decode().
+typedef struct {
+    int step;      // Number of characters seen of the current 4-character group.
+    uint8_t plain; // Bits collected so far for the next output byte.
+} __spicy_base64_state;
+
+/// Initializes the state for a new base64 decoding process.
+extern void __spicy_base64_init(__spicy_base64_state* state);
+
+/// Decodes a block of base64 data, continuing where the previous call left
+/// off. Characters not part of the base64 alphabet are skipped. Output bytes
+/// are written as soon as they are complete.
+///
+/// in: The data to decode.
+/// len: The length of *in*.
+/// out: Buffer to write the decoded data into. Must have space for at least
+/// ``__spicy_base64_decode_size(len)`` bytes.
+///
+/// Returns: The number of bytes written to *out*.
+extern size_t __spicy_base64_decode(__spicy_base64_state* state, const uint8_t* in, size_t len,
+                                    uint8_t* out);
+
+/// Returns the size of the output buffer that __spicy_base64_decode()
+/// needs for input of a given length. This includes space that the vectorized
+/// implementation may temporarily write to beyond the decoded data.
+static inline size_t __spicy_base64_decode_size(size_t len)
+{
+    return (len / 4) * 3 + 3 + 32;
+}
+
 extern hlt_bytes* spicy_base64_encode(hlt_bytes* b, hlt_exception** excpt,
                                       hlt_execution_context* ctx);
 extern hlt_bytes* spicy_base64_decode(hlt_bytes* b, hlt_exception** excpt,
@@ -1,17 +1,67 @@
 
+#include <string.h>
+
 #include "filter.h"
 #include "exceptions.h"
+#include "globals.h"
 #include "sink.h"
 
 #include <autogen/spicyhilti-hlt.h>
 
 __HLT_RTTI_GC_TYPE(spicy_filter, HLT_TYPE_SPICY_FILTER);
 
+// Helpers shared by the filter implementations below.
+
+// Appends decoded data to a filter's output, creating the bytes object if it
+// doesn't exist yet. Takes ownership of data, which must have been allocated
+// with hlt_malloc().
+static void __spicy_filter_output(hlt_bytes** decoded, int8_t* data, size_t len,
+                                  hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( ! len ) {
+        hlt_free(data);
+        return;
+    }
+
+    if ( ! *decoded )
+        *decoded = hlt_bytes_new_from_data(data, len, excpt, ctx);
+    else
+        hlt_bytes_append_raw(*decoded, data, len, excpt, ctx);
+}
+
+// Returns the value of a hex digit, or -1 if it isn't one.
+static inline int __spicy_filter_hex_value(uint8_t c)
+{
+    if ( c >= '0' && c <= '9' )
+        return c - '0';
+
+    if ( c >= 'a' && c <= 'f' )
+        return c - 'a' + 10;
+
+    if ( c >= 'A' && c <= 'F' )
+        return c - 'A' + 10;
+
+    return -1;
+}
+
+static void __spicy_filter_error(const char* msg, hlt_exception** excpt,
+                                 hlt_execution_context* ctx)
+{
+    hlt_string s = hlt_string_from_asciiz(msg, excpt, ctx);
+    hlt_set_exception(excpt, &spicy_exception_filtererror, s, ctx);
+}
+
 #include "filter_base64.c"
+#include "filter_chunked.c"
+#include "filter_hex.c"
+#include "filter_quoted_printable.c"
 #include "filter_zlib.c"
 
+// The built-in filter types. These go through the same registry as filters
+// added by host applications; see __spicy_filter_register_builtins().
+//
 // FIXME: Can't use the enums here directly; better way?
-static struct __spicy_filter_definition filters[] = {
+static struct __spicy_filter_definition builtin_filters[] = {
     {{0, 1},
      "BASE64",
      __spicy_filter_base64_allocate,
@@ -30,6 +80,30 @@ static struct __spicy_filter_definition filters[] = {
      __spicy_filter_zlib_dtor,
      __spicy_filter_zlib_decode,
      __spicy_filter_zlib_close},
+    {{0, 4},
+     "DEFLATE",
+     __spicy_filter_deflate_allocate,
+     __spicy_filter_zlib_dtor,
+     __spicy_filter_zlib_decode,
+     __spicy_filter_zlib_close},
+    {{0, 5},
+     "CHUNKED",
+     __spicy_filter_chunked_allocate,
+     __spicy_filter_chunked_dtor,
+     __spicy_filter_chunked_decode,
+     __spicy_filter_chunked_close},
+    {{0, 6},
+     "QUOTED_PRINTABLE",
+     __spicy_filter_quoted_printable_allocate,
+     __spicy_filter_quoted_printable_dtor,
+     __spicy_filter_quoted_printable_decode,
+     __spicy_filter_quoted_printable_close},
+    {{0, 7},
+     "HEX",
+     __spicy_filter_hex_allocate,
+     __spicy_filter_hex_dtor,
+     __spicy_filter_hex_decode,
+     __spicy_filter_hex_close},
     {{0, 0}, 0, 0, 0, 0},
 };
 
@@ -40,28 +114,141 @@ void spicy_filter_dtor(hlt_type_info* ti, spicy_filter* filter, hlt_execution_co
     // it's not clear how .. For now, we can't rely on this running.
 }
 
-spicy_filter* spicyhilti_filter_add(spicy_filter* head, hlt_enum ftype, hlt_exception** excpt,
-                                    hlt_execution_context* ctx)
+void spicy_filter_register(__spicy_filter_definition* def)
+{
+    __spicy_global_state* globals = __spicy_globals();
+
+    int n = globals->num_filters;
+
+    if ( hlt_enum_undefined(def->type) ) {
+        // Pick a value that's not used by any other registration.
+        int64_t max = 0;
+
+        for ( int i = 0; i < n; i++ ) {
+            if ( globals->filters[i]->type.value > max )
+                max = globals->filters[i]->type.value;
+        }
+
+        def->type.flags = 0;
+        def->type.value = max + 1;
+    }
+
+    globals->filters = hlt_realloc(globals->filters, (n + 1) * sizeof(__spicy_filter_definition*),
+                                   n * sizeof(__spicy_filter_definition*));
+    globals->filters[n] = def;
+    globals->num_filters = n + 1;
+}
+
+void __spicy_filter_register_builtins()
+{
+    for ( __spicy_filter_definition* fd = builtin_filters; fd->name; fd++ )
+        spicy_filter_register(fd);
+}
+
+static __spicy_filter_definition* _lookup_filter(hlt_enum ftype, hlt_exception** excpt,
+                                                 hlt_execution_context* ctx)
 {
-    spicy_filter* filter = 0;
+    __spicy_global_state* globals = __spicy_globals();
 
-    for ( __spicy_filter_definition* fd = filters; fd->name; fd++ ) {
-        if ( hlt_enum_equal(ftype, fd->type, excpt, ctx) ) {
-            filter = (*fd->allocate)(excpt, ctx);
-            filter->def = fd;
-            filter->next = 0;
+    // Search backwards so that later registrations override earlier ones.
+    for ( int i = globals->num_filters - 1; i >= 0; i-- ) {
+        if ( hlt_enum_equal(ftype, globals->filters[i]->type, excpt, ctx) )
+            return globals->filters[i];
+    }
+
+    return 0;
+}
+
+static __spicy_filter_definition* _lookup_filter_by_name(hlt_string name, hlt_exception** excpt,
+                                                         hlt_execution_context* ctx)
+{
+    __spicy_global_state* globals = __spicy_globals();
+    __spicy_filter_definition* fd = 0;
+
+    char* n = hlt_string_to_native(name, excpt, ctx);
+
+    if ( *excpt )
+        return 0;
+
+    // Search backwards so that later registrations override earlier ones.
+    for ( int i = globals->num_filters - 1; i >= 0; i-- ) {
+        if ( strcmp(n, globals->filters[i]->name) == 0 ) {
+            fd = globals->filters[i];
             break;
         }
     }
 
-    if ( ! filter ) {
-        hlt_string fname = hlt_string_from_asciiz("unknown filter type", excpt, ctx);
-        hlt_set_exception(excpt, &spicy_exception_filterunsupported, fname, ctx);
+    hlt_free(n);
+    return fd;
+}
+
+static void _unsupported(hlt_string name, hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    hlt_string msg = hlt_string_from_asciiz("unknown filter type", excpt, ctx);
+
+    if ( name ) {
+        msg = hlt_string_concat(msg, hlt_string_from_asciiz(" ", excpt, ctx), excpt, ctx);
+        msg = hlt_string_concat(msg, name, excpt, ctx);
+    }
+
+    hlt_set_exception(excpt, &spicy_exception_filterunsupported, msg, ctx);
+}
+
+static spicy_filter* _filter_add(spicy_filter* head, __spicy_filter_definition* fd,
+                                 hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    spicy_filter* filter = (*fd->allocate)(excpt, ctx);
+
+    if ( ! filter )
         return 0;
+
+    filter->def = fd;
+    filter->next = 0;
+
+    return __spicyhilti_filter_add(head, filter, excpt, ctx);
+}
+
+hlt_enum spicyhilti_filter_lookup(hlt_string name, hlt_exception** excpt,
+                                  hlt_execution_context* ctx)
+{
+    __spicy_filter_definition* fd = _lookup_filter_by_name(name, excpt, ctx);
+
+    if ( ! fd ) {
+        if ( ! *excpt )
+            _unsupported(name, excpt, ctx);
+
+        return hlt_enum_unset(excpt, ctx);
     }
 
-    head = __spicyhilti_filter_add(head, filter, excpt, ctx);
-    return head;
+    return fd->type;
+}
+
+spicy_filter* spicyhilti_filter_add(spicy_filter* head, hlt_enum ftype, hlt_exception** excpt,
+                                    hlt_execution_context* ctx)
+{
+    __spicy_filter_definition* fd = _lookup_filter(ftype, excpt, ctx);
+
+    if ( ! fd ) {
+        _unsupported(0, excpt, ctx);
+        return 0;
+    }
+
+    return _filter_add(head, fd, excpt, ctx);
+}
+
+spicy_filter* spicyhilti_filter_add_by_name(spicy_filter* head, hlt_string name,
+                                            hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    __spicy_filter_definition* fd = _lookup_filter_by_name(name, excpt, ctx);
+
+    if ( ! fd ) {
+        if ( ! *excpt )
+            _unsupported(name, excpt, ctx);
+
+        return 0;
+    }
+
+    return _filter_add(head, fd, excpt, ctx);
 }
 
 spicy_filter* __spicyhilti_filter_add(spicy_filter* head, spicy_filter* filter,
@@ -2,8 +2,11 @@
 /// Filters are pipelines decoding input from one form to another. In
 /// Spicy, they can be attached to either sinks or parsing objects.
 ///
-/// Currently, there's predefined list of filters available. In the future, it may be
-/// possible to write them in Spicy directly as well.
+/// All filter types live in a registry that libspicy populates with its
+/// predefined filters at startup. Host applications can add further filter
+/// types at run-time with spicy_filter_register(); Spicy code selects them
+/// by name. In the future, it may be possible to write them in Spicy
+/// directly as well.
 
 #ifndef LIBSPICY_FILTER_H
 #define LIBSPICY_FILTER_H
@@ -48,6 +51,32 @@ typedef struct spicy_filter spicy_filter;
 
 __HLT_DECLARE_RTTI_GC_TYPE(spicy_filter);
 
+/// Registers a filter type implemented outside of libspicy. Once
+/// registered, the filter can be attached by its ``name`` just like the
+/// predefined ones, and also by the enum value in the definition's
+/// ``type``. If ``type`` is undefined, a fresh value is assigned to it. A
+/// registration for a name or type that's already known replaces the
+/// existing implementation. Must be called after spicy_init() and before
+/// any filters are used.
+///
+/// def: The definition of the filter type. The definition is not copied
+/// and must remain valid until spicy_done().
+extern void spicy_filter_register(__spicy_filter_definition* def);
+
+/// Registers libspicy's predefined filter types. For internal use, called
+/// during initialization.
+extern void __spicy_filter_register_builtins();
+
+/// Returns the type of a registered filter.
+///
+/// name: The name the filter was registered with.
+/// excpt: &
+/// ctx: &
+///
+/// Raises: FilterUnsupported - If no filter of that name is registered.
+extern hlt_enum spicyhilti_filter_lookup(hlt_string name, hlt_exception** excpt,
+                                         hlt_execution_context* ctx);
+
 /// Instantiates and initializes a new filter and adds it to a filter chain.
 ///
 /// head: The head of the chain to add a new filter to. This can be null to create new chain.
@@ -61,6 +90,21 @@ __HLT_DECLARE_RTTI_GC_TYPE(spicy_filter);
 extern spicy_filter* spicyhilti_filter_add(spicy_filter* head, hlt_enum ftype,
                                            hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Instantiates a new filter selected by name and adds it to a filter
+/// chain.
+///
+/// head: The head of the chain to add a new filter to. This can be null to create new chain.
+/// name: The name the filter type was registered with.
+/// excpt: &
+/// ctx: &
+///
+/// Returns: The new head of the filter chain at refcount +1.
+///
+/// Raised: FilterUnsupported - If no filter of that name is registered.
+extern spicy_filter* spicyhilti_filter_add_by_name(spicy_filter* head, hlt_string name,
+                                                   hlt_exception** excpt,
+                                                   hlt_execution_context* ctx);
+
 /// Adds an already instantiated filter to a filter chain. For internal use.
 ///
 /// head: The head of the chain to add a new filter to. This can be null to create new chain.
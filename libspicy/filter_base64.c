@@ -1,18 +1,18 @@
 
 #include "filter.h"
 
-#include "3rdparty/libb64/include/b64/cdecode.h"
+#include "base64.h"
 
 typedef struct {
     spicy_filter base;
-    base64_decodestate state;
+    __spicy_base64_state state;
 } __spicy_filter_base64;
 
 spicy_filter* __spicy_filter_base64_allocate(hlt_exception** excpt, hlt_execution_context* ctx)
 {
     __spicy_filter_base64* filter =
         GC_NEW_CUSTOM_SIZE(spicy_filter, sizeof(__spicy_filter_base64), ctx);
-    base64_init_decodestate(&filter->state);
+    __spicy_base64_init(&filter->state);
     return (spicy_filter*)filter;
 }
 
@@ -24,11 +24,8 @@ void __spicy_filter_base64_dtor(hlt_type_info* ti, spicy_filter* filter, hlt_exe
 void __spicy_filter_base64_close(spicy_filter* filter, hlt_exception** excpt,
                                  hlt_execution_context* ctx_)
 {
-    // Unclear in which state we should be here if all has been decoded. I'd
-    // think just "step_a", but I have also observed "step_d" even though all
-    // input was correctly decoded (perhaps this is padding related?). So for
-    // now, we just ignore erros at the very end, that's probably fine
-    // anyway.
+    // We skip padding and don't insist on complete groups at the end, just
+    // as libb64 that we used before. Any partial bits left over are ignored.
 }
 
 hlt_bytes* __spicy_filter_base64_decode(spicy_filter* filter_gen, hlt_bytes* data,
@@ -46,28 +43,14 @@ hlt_bytes* __spicy_filter_base64_decode(spicy_filter* filter_gen, hlt_bytes* dat
     do {
         cookie = hlt_bytes_iterate_raw(&block, cookie, begin, end, excpt, ctx);
 
-        int len = block.end - block.start;
+        size_t len = block.end - block.start;
 
         if ( ! len )
             continue;
 
-        // We will allocate a bit more than we'll need here.
-        int8_t* buffer = hlt_malloc(len);
-
-        int n = base64_decode_block((const char*)block.start, len, (char*)buffer, &filter->state);
-
-        if ( n > 0 ) {
-            if ( ! decoded ) {
-                decoded = hlt_bytes_new_from_data(buffer, n, excpt, ctx);
-                buffer = 0;
-            }
-            else
-                hlt_bytes_append_raw(decoded, buffer, n, excpt, ctx);
-            buffer = 0;
-        }
-
-        if ( buffer )
-            hlt_free(buffer);
+        uint8_t* buffer = hlt_malloc(__spicy_base64_decode_size(len));
+        size_t n = __spicy_base64_decode(&filter->state, (const uint8_t*)block.start, len, buffer);
+        __spicy_filter_output(&decoded, (int8_t*)buffer, n, excpt, ctx);
 
     } while ( cookie );
 
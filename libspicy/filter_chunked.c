@@ -0,0 +1,200 @@
+
+// Decoding of HTTP's chunked transfer coding (RFC 7230, Section 4.1).
+
+#include "filter.h"
+
+typedef enum {
+    CHUNKED_SIZE,     // Parsing the hex size of the next chunk.
+    CHUNKED_EXT,      // Skipping chunk extensions up to the end of the line.
+    CHUNKED_DATA,     // Passing through chunk data.
+    CHUNKED_DATA_END, // Expecting the line break after chunk data.
+    CHUNKED_TRAILER,  // Skipping trailer lines after the last chunk.
+    CHUNKED_DONE      // Seen the final empty line; ignoring further input.
+} __spicy_filter_chunked_state;
+
+typedef struct {
+    spicy_filter base;
+    __spicy_filter_chunked_state state;
+    uint64_t remaining; // Size of current chunk still to pass through.
+    int8_t have_digits; // True if we have seen at least one digit of the size.
+    int64_t line_len;   // Length of the current trailer line.
+} __spicy_filter_chunked;
+
+spicy_filter* __spicy_filter_chunked_allocate(hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    __spicy_filter_chunked* filter =
+        GC_NEW_CUSTOM_SIZE(spicy_filter, sizeof(__spicy_filter_chunked), ctx);
+    filter->state = CHUNKED_SIZE;
+    filter->remaining = 0;
+    filter->have_digits = 0;
+    filter->line_len = 0;
+    return (spicy_filter*)filter;
+}
+
+void __spicy_filter_chunked_dtor(hlt_type_info* ti, spicy_filter* filter,
+                                 hlt_execution_context* ctx)
+{
+    // Nothing to do.
+}
+
+void __spicy_filter_chunked_close(spicy_filter* filter_gen, hlt_exception** excpt,
+                                  hlt_execution_context* ctx)
+{
+    __spicy_filter_chunked* filter = (__spicy_filter_chunked*)filter_gen;
+
+    if ( filter->state == CHUNKED_DONE || filter->state == CHUNKED_TRAILER )
+        return;
+
+    if ( filter->state == CHUNKED_SIZE && ! filter->have_digits )
+        // Between chunks, that's fine.
+        return;
+
+    __spicy_filter_error("chunked data truncated", excpt, ctx);
+}
+
+// Called at the end of a chunk's size line.
+static int8_t _chunked_size_done(__spicy_filter_chunked* filter, hlt_exception** excpt,
+                                 hlt_execution_context* ctx)
+{
+    if ( ! filter->have_digits ) {
+        __spicy_filter_error("missing chunk size", excpt, ctx);
+        return 0;
+    }
+
+    filter->have_digits = 0;
+
+    if ( filter->remaining )
+        filter->state = CHUNKED_DATA;
+    else {
+        filter->state = CHUNKED_TRAILER;
+        filter->line_len = 0;
+    }
+
+    return 1;
+}
+
+hlt_bytes* __spicy_filter_chunked_decode(spicy_filter* filter_gen, hlt_bytes* data,
+                                         hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    __spicy_filter_chunked* filter = (__spicy_filter_chunked*)filter_gen;
+
+    void* cookie = 0;
+    hlt_bytes_block block;
+    hlt_iterator_bytes begin = hlt_bytes_begin(data, excpt, ctx);
+    hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
+
+    hlt_bytes* decoded = 0;
+
+    do {
+        cookie = hlt_bytes_iterate_raw(&block, cookie, begin, end, excpt, ctx);
+
+        const uint8_t* p = (const uint8_t*)block.start;
+        const uint8_t* e = (const uint8_t*)block.end;
+
+        if ( p == e )
+            continue;
+
+        int8_t* buffer = hlt_malloc(e - p);
+        size_t n = 0;
+
+        while ( p < e ) {
+            uint8_t c = *p;
+            int d;
+
+            switch ( filter->state ) {
+            case CHUNKED_SIZE:
+                d = __spicy_filter_hex_value(c);
+
+                if ( d >= 0 ) {
+                    if ( filter->remaining > (UINT64_MAX >> 4) ) {
+                        __spicy_filter_error("chunk size too large", excpt, ctx);
+                        goto error;
+                    }
+
+                    filter->remaining = (filter->remaining << 4) | d;
+                    filter->have_digits = 1;
+                }
+
+                else if ( c == '\n' ) {
+                    if ( ! _chunked_size_done(filter, excpt, ctx) )
+                        goto error;
+                }
+
+                else if ( c == ';' || c == ' ' || c == '\t' || c == '\r' )
+                    filter->state = CHUNKED_EXT;
+
+                else {
+                    __spicy_filter_error("invalid chunk size", excpt, ctx);
+                    goto error;
+                }
+
+                ++p;
+                break;
+
+            case CHUNKED_EXT:
+                if ( c == '\n' && ! _chunked_size_done(filter, excpt, ctx) )
+                    goto error;
+
+                ++p;
+                break;
+
+            case CHUNKED_DATA: {
+                size_t len = (e - p);
+
+                if ( len > filter->remaining )
+                    len = filter->remaining;
+
+                memcpy(buffer + n, p, len);
+                n += len;
+                p += len;
+                filter->remaining -= len;
+
+                if ( ! filter->remaining )
+                    filter->state = CHUNKED_DATA_END;
+
+                break;
+            }
+
+            case CHUNKED_DATA_END:
+                if ( c == '\n' )
+                    filter->state = CHUNKED_SIZE;
+
+                else if ( c != '\r' ) {
+                    __spicy_filter_error("missing line break after chunk", excpt, ctx);
+                    goto error;
+                }
+
+                ++p;
+                break;
+
+            case CHUNKED_TRAILER:
+                if ( c == '\n' ) {
+                    if ( filter->line_len == 0 )
+                        filter->state = CHUNKED_DONE;
+
+                    filter->line_len = 0;
+                }
+
+                else if ( c != '\r' )
+                    ++filter->line_len;
+
+                ++p;
+                break;
+
+            case CHUNKED_DONE:
+                p = e;
+                break;
+            }
+        }
+
+        __spicy_filter_output(&decoded, buffer, n, excpt, ctx);
+        continue;
+
+    error:
+        hlt_free(buffer);
+        return 0;
+
+    } while ( cookie );
+
+    return decoded ? decoded : hlt_bytes_new(excpt, ctx);
+}
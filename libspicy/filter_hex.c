@@ -0,0 +1,82 @@
+
+// Decoding of hex-encoded data. Whitespace between digits is ignored.
+
+#include "filter.h"
+
+typedef struct {
+    spicy_filter base;
+    int hi; // Value of a pending first digit of a pair, or -1 if none.
+} __spicy_filter_hex;
+
+spicy_filter* __spicy_filter_hex_allocate(hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    __spicy_filter_hex* filter = GC_NEW_CUSTOM_SIZE(spicy_filter, sizeof(__spicy_filter_hex), ctx);
+    filter->hi = -1;
+    return (spicy_filter*)filter;
+}
+
+void __spicy_filter_hex_dtor(hlt_type_info* ti, spicy_filter* filter, hlt_execution_context* ctx)
+{
+    // Nothing to do.
+}
+
+void __spicy_filter_hex_close(spicy_filter* filter_gen, hlt_exception** excpt,
+                              hlt_execution_context* ctx)
+{
+    __spicy_filter_hex* filter = (__spicy_filter_hex*)filter_gen;
+
+    if ( filter->hi >= 0 )
+        __spicy_filter_error("odd number of hex digits", excpt, ctx);
+}
+
+hlt_bytes* __spicy_filter_hex_decode(spicy_filter* filter_gen, hlt_bytes* data,
+                                     hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    __spicy_filter_hex* filter = (__spicy_filter_hex*)filter_gen;
+
+    void* cookie = 0;
+    hlt_bytes_block block;
+    hlt_iterator_bytes begin = hlt_bytes_begin(data, excpt, ctx);
+    hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
+
+    hlt_bytes* decoded = 0;
+
+    do {
+        cookie = hlt_bytes_iterate_raw(&block, cookie, begin, end, excpt, ctx);
+
+        const uint8_t* p = (const uint8_t*)block.start;
+        const uint8_t* e = (const uint8_t*)block.end;
+
+        if ( p == e )
+            continue;
+
+        int8_t* buffer = hlt_malloc((e - p) / 2 + 1);
+        size_t n = 0;
+
+        for ( ; p < e; p++ ) {
+            int d = __spicy_filter_hex_value(*p);
+
+            if ( d < 0 ) {
+                if ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' )
+                    continue;
+
+                hlt_free(buffer);
+                __spicy_filter_error("invalid hex digit", excpt, ctx);
+                return 0;
+            }
+
+            if ( filter->hi < 0 )
+                filter->hi = d;
+
+            else {
+                buffer[n++] = (filter->hi << 4) | d;
+                filter->hi = -1;
+            }
+        }
+
+        __spicy_filter_output(&decoded, buffer, n, excpt, ctx);
+
+    } while ( cookie );
+
+    return decoded ? decoded : hlt_bytes_new(excpt, ctx);
+}
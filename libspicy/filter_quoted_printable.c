@@ -0,0 +1,145 @@
+
+// Decoding of MIME quoted-printable data (RFC 2045, Section 6.7). We decode
+// leniently: malformed escapes are passed through literally. Trailing
+// whitespace at the end of lines is not removed.
+
+#include "filter.h"
+
+typedef enum {
+    QP_TEXT, // Passing through literal text.
+    QP_EQ,   // Seen '='.
+    QP_HEX,  // Seen '=' followed by one hex digit.
+    QP_CR    // Seen '=' followed by CR, i.e., likely a soft line break.
+} __spicy_filter_quoted_printable_state;
+
+typedef struct {
+    spicy_filter base;
+    __spicy_filter_quoted_printable_state state;
+    uint8_t first; // The first hex digit in state QP_HEX.
+} __spicy_filter_quoted_printable;
+
+spicy_filter* __spicy_filter_quoted_printable_allocate(hlt_exception** excpt,
+                                                       hlt_execution_context* ctx)
+{
+    __spicy_filter_quoted_printable* filter =
+        GC_NEW_CUSTOM_SIZE(spicy_filter, sizeof(__spicy_filter_quoted_printable), ctx);
+    filter->state = QP_TEXT;
+    filter->first = 0;
+    return (spicy_filter*)filter;
+}
+
+void __spicy_filter_quoted_printable_dtor(hlt_type_info* ti, spicy_filter* filter,
+                                          hlt_execution_context* ctx)
+{
+    // Nothing to do.
+}
+
+void __spicy_filter_quoted_printable_close(spicy_filter* filter, hlt_exception** excpt,
+                                           hlt_execution_context* ctx)
+{
+    // A dangling escape at the very end is dropped, consistent with our
+    // lenient decoding otherwise.
+}
+
+hlt_bytes* __spicy_filter_quoted_printable_decode(spicy_filter* filter_gen, hlt_bytes* data,
+                                                  hlt_exception** excpt,
+                                                  hlt_execution_context* ctx)
+{
+    __spicy_filter_quoted_printable* filter = (__spicy_filter_quoted_printable*)filter_gen;
+
+    void* cookie = 0;
+    hlt_bytes_block block;
+    hlt_iterator_bytes begin = hlt_bytes_begin(data, excpt, ctx);
+    hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
+
+    hlt_bytes* decoded = 0;
+
+    do {
+        cookie = hlt_bytes_iterate_raw(&block, cookie, begin, end, excpt, ctx);
+
+        const uint8_t* p = (const uint8_t*)block.start;
+        const uint8_t* e = (const uint8_t*)block.end;
+
+        if ( p == e )
+            continue;
+
+        // An escape pending from the previous block may add two more bytes.
+        int8_t* buffer = hlt_malloc((e - p) + 2);
+        size_t n = 0;
+
+        while ( p < e ) {
+            uint8_t c = *p;
+            int d;
+
+            switch ( filter->state ) {
+            case QP_TEXT: {
+                // Copy everything up to the next escape in one go.
+                const uint8_t* eq = memchr(p, '=', e - p);
+                const uint8_t* stop = (eq ? eq : e);
+                memcpy(buffer + n, p, stop - p);
+                n += (stop - p);
+                p = stop;
+
+                if ( eq ) {
+                    filter->state = QP_EQ;
+                    ++p;
+                }
+
+                break;
+            }
+
+            case QP_EQ:
+                if ( (d = __spicy_filter_hex_value(c)) >= 0 ) {
+                    filter->first = c;
+                    filter->state = QP_HEX;
+                    ++p;
+                }
+
+                else if ( c == '\r' ) {
+                    filter->state = QP_CR;
+                    ++p;
+                }
+
+                else if ( c == '\n' ) {
+                    // Soft line break without CR.
+                    filter->state = QP_TEXT;
+                    ++p;
+                }
+
+                else {
+                    // Not an escape, reprocess character as text.
+                    buffer[n++] = '=';
+                    filter->state = QP_TEXT;
+                }
+
+                break;
+
+            case QP_HEX:
+                if ( (d = __spicy_filter_hex_value(c)) >= 0 ) {
+                    buffer[n++] = (__spicy_filter_hex_value(filter->first) << 4) | d;
+                    ++p;
+                }
+
+                else {
+                    buffer[n++] = '=';
+                    buffer[n++] = filter->first;
+                }
+
+                filter->state = QP_TEXT;
+                break;
+
+            case QP_CR:
+                if ( c == '\n' )
+                    ++p;
+
+                filter->state = QP_TEXT;
+                break;
+            }
+        }
+
+        __spicy_filter_output(&decoded, buffer, n, excpt, ctx);
+
+    } while ( cookie );
+
+    return decoded ? decoded : hlt_bytes_new(excpt, ctx);
+}
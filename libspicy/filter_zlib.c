@@ -1,13 +1,24 @@
 
-// This handles both gzip and zlib/deflate decompresssion.
+// This handles gzip, zlib, and raw deflate decompresssion.
 
 #include <zlib.h>
 
 #include "filter.h"
+#include "globals.h"
+
+// Bounds for the size of the buffers we inflate into.
+#define MIN_CHUNK_SIZE 4096
+#define MAX_CHUNK_SIZE (1024 * 1024)
+
+// We check the decompression ratio only once we have produced at least
+// this much output, so that small but highly compressible input passes.
+#define MIN_OUTPUT_FOR_RATIO (1024 * 1024)
 
 typedef struct {
     spicy_filter base;
     z_stream* zip;
+    int8_t* buf;     // Buffer we inflate into; reused across calls if not handed out.
+    size_t buf_size; // Size of buf.
 } __spicy_filter_zlib;
 
 void __spicy_filter_zlib_close(spicy_filter* filter_gen, hlt_exception** excpt,
@@ -15,6 +26,11 @@ void __spicy_filter_zlib_close(spicy_filter* filter_gen, hlt_exception** excpt,
 {
     __spicy_filter_zlib* filter = (__spicy_filter_zlib*)filter_gen;
 
+    if ( filter->buf ) {
+        hlt_free(filter->buf);
+        filter->buf = 0;
+    }
+
     if ( ! filter->zip )
         return;
 
@@ -23,10 +39,13 @@ void __spicy_filter_zlib_close(spicy_filter* filter_gen, hlt_exception** excpt,
     filter->zip = 0;
 }
 
-spicy_filter* __spicy_filter_zlib_allocate(hlt_exception** excpt, hlt_execution_context* ctx)
+static spicy_filter* _zlib_allocate(int window_bits, hlt_exception** excpt,
+                                    hlt_execution_context* ctx)
 {
     __spicy_filter_zlib* filter =
         GC_NEW_CUSTOM_SIZE(spicy_filter, sizeof(__spicy_filter_zlib), ctx);
+    filter->buf = 0;
+    filter->buf_size = 0;
     filter->zip = hlt_malloc(sizeof(z_stream));
     filter->zip->zalloc = 0;
     filter->zip->zfree = 0;
@@ -36,9 +55,7 @@ spicy_filter* __spicy_filter_zlib_allocate(hlt_exception** excpt, hlt_execution_
     filter->zip->next_in = 0;
     filter->zip->avail_in = 0;
 
-    // "15" here means maximum compression.  "32" is a gross overload hack
-    // that means "check it for whether it's a gzip file". Sheesh.
-    int zip_status = inflateInit2(filter->zip, 15 + 32);
+    int zip_status = inflateInit2(filter->zip, window_bits);
 
     if ( zip_status != Z_OK ) {
         __spicy_filter_zlib_close((spicy_filter*)filter, excpt, ctx);
@@ -50,11 +67,109 @@ spicy_filter* __spicy_filter_zlib_allocate(hlt_exception** excpt, hlt_execution_
     return (spicy_filter*)filter;
 }
 
+spicy_filter* __spicy_filter_zlib_allocate(hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    // "15" here means maximum compression.  "32" is a gross overload hack
+    // that means "check it for whether it's a gzip file". Sheesh.
+    return _zlib_allocate(15 + 32, excpt, ctx);
+}
+
+spicy_filter* __spicy_filter_deflate_allocate(hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    // A negative window size means raw deflate data without any header.
+    return _zlib_allocate(-15, excpt, ctx);
+}
+
 void __spicy_filter_zlib_dtor(hlt_type_info* ti, spicy_filter* filter, hlt_execution_context* ctx)
 {
     __spicy_filter_zlib_close(filter, 0, 0);
 }
 
+// Picks the size of the next output buffer based on the compression ratio
+// seen so far.
+static size_t _chunk_size(__spicy_filter_zlib* filter)
+{
+    z_stream* zip = filter->zip;
+    uint64_t ratio = (zip->total_in ? (zip->total_out / zip->total_in) + 1 : 4);
+    uint64_t size = (uint64_t)zip->avail_in * ratio;
+
+    if ( size < MIN_CHUNK_SIZE )
+        return MIN_CHUNK_SIZE;
+
+    if ( size > MAX_CHUNK_SIZE )
+        return MAX_CHUNK_SIZE;
+
+    return size;
+}
+
+static void _append(hlt_bytes** decoded, int8_t* data, size_t len, int8_t reuse,
+                    hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( reuse ) {
+        if ( ! *decoded )
+            *decoded = hlt_bytes_new_from_data(data, len, excpt, ctx);
+        else
+            hlt_bytes_append_raw(*decoded, data, len, excpt, ctx);
+    }
+
+    else {
+        if ( ! *decoded )
+            *decoded = hlt_bytes_new_from_data_copy(data, len, excpt, ctx);
+        else
+            hlt_bytes_append_raw_copy(*decoded, data, len, excpt, ctx);
+    }
+}
+
+// Passes what's in the output buffer on to the result. If the buffer is
+// mostly used, we hand it over as is; otherwise we copy its content out and
+// keep the buffer for next time.
+static void _flush_output(__spicy_filter_zlib* filter, hlt_bytes** decoded,
+                          hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( ! filter->buf )
+        return;
+
+    size_t used = (filter->zip->next_out - (Bytef*)filter->buf);
+
+    if ( ! used )
+        return;
+
+    if ( used >= filter->buf_size / 2 ) {
+        _append(decoded, filter->buf, used, 1, excpt, ctx);
+        filter->buf = 0;
+        filter->buf_size = 0;
+    }
+
+    else {
+        _append(decoded, filter->buf, used, 0, excpt, ctx);
+        filter->zip->next_out = (Bytef*)filter->buf;
+        filter->zip->avail_out = filter->buf_size;
+    }
+}
+
+static int8_t _check_limits(__spicy_filter_zlib* filter, hlt_exception** excpt,
+                            hlt_execution_context* ctx)
+{
+    __spicy_global_state* globals = __spicy_globals();
+    uint64_t in = filter->zip->total_in;
+    uint64_t out = filter->zip->total_out;
+
+    if ( globals->filter_max_size && out > globals->filter_max_size )
+        goto exceeded;
+
+    if ( globals->filter_max_ratio && out > MIN_OUTPUT_FOR_RATIO &&
+         out > in * globals->filter_max_ratio )
+        goto exceeded;
+
+    return 1;
+
+exceeded:
+    __spicy_filter_zlib_close((spicy_filter*)filter, excpt, ctx);
+    hlt_string fname = hlt_string_from_asciiz("decompression limit exceeded", excpt, ctx);
+    hlt_set_exception(excpt, &spicy_exception_filtererror, fname, ctx);
+    return 0;
+}
+
 hlt_bytes* __spicy_filter_zlib_decode(spicy_filter* filter_gen, hlt_bytes* data,
                                       hlt_exception** excpt, hlt_execution_context* ctx)
 {
@@ -87,9 +202,12 @@ hlt_bytes* __spicy_filter_zlib_decode(spicy_filter* filter_gen, hlt_bytes* data,
         filter->zip->avail_in = len;
 
         do {
-            Bytef buf[4096];
-            filter->zip->next_out = buf;
-            filter->zip->avail_out = sizeof(buf);
+            if ( ! filter->buf ) {
+                filter->buf_size = _chunk_size(filter);
+                filter->buf = hlt_malloc(filter->buf_size);
+                filter->zip->next_out = (Bytef*)filter->buf;
+                filter->zip->avail_out = filter->buf_size;
+            }
 
             int zip_status = inflate(filter->zip, Z_SYNC_FLUSH);
 
@@ -100,23 +218,25 @@ hlt_bytes* __spicy_filter_zlib_decode(spicy_filter* filter_gen, hlt_bytes* data,
                 return 0;
             }
 
-            int have = sizeof(buf) - filter->zip->avail_out;
+            if ( ! _check_limits(filter, excpt, ctx) )
+                return 0;
 
-            if ( have ) {
-                if ( ! decoded )
-                    decoded = hlt_bytes_new_from_data_copy((int8_t*)buf, have, excpt, ctx);
-                else
-                    hlt_bytes_append_raw_copy(decoded, (int8_t*)buf, have, excpt, ctx);
-            }
+            if ( filter->zip->avail_out == 0 )
+                // Full, hand it over.
+                _flush_output(filter, &decoded, excpt, ctx);
 
             if ( zip_status == Z_STREAM_END ) {
+                _flush_output(filter, &decoded, excpt, ctx);
                 __spicy_filter_zlib_close((spicy_filter*)filter, excpt, ctx);
-                break;
+                goto done;
             }
 
-        } while ( filter->zip->avail_out == 0 );
+        } while ( ! filter->buf );
 
     } while ( cookie );
 
+    _flush_output(filter, &decoded, excpt, ctx);
+
+done:
     return decoded ? decoded : hlt_bytes_new(excpt, ctx);
 }
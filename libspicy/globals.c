@@ -1,5 +1,6 @@
 
 
+#include "filter.h"
 #include "globals.h"
 #include "libspicy.h"
 #include "mime.h"
@@ -37,6 +38,12 @@ int __spicy_global_state_init()
     GC_CCTOR(__globals->mime_types, hlt_map, ctx);
 
     __globals->debugging = 0;
+    __globals->filter_max_ratio = 100;
+    __globals->filter_max_size = 0;
+    __globals->filters = 0;
+    __globals->num_filters = 0;
+
+    __spicy_filter_register_builtins();
 
     return 1;
 }
@@ -52,6 +59,9 @@ int __spicy_global_state_done()
     GC_DTOR(__globals->parsers, hlt_list, hlt_global_execution_context());
     GC_DTOR(__globals->mime_types, hlt_map, hlt_global_execution_context());
 
+    if ( __globals->filters )
+        hlt_free(__globals->filters);
+
     __globals->finished = 1;
 
     return 1;
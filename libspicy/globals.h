@@ -4,6 +4,8 @@
 
 #include "libspicy.h"
 
+struct __spicy_filter_definition;
+
 typedef struct {
     // Flag indicating __hlt_global_state_init() has completed.
     int initialized;
@@ -14,6 +16,14 @@ typedef struct {
     hlt_list* parsers;
     hlt_map* mime_types;
     int8_t debugging;
+
+    // Limits for decompressing filters; zero means unlimited.
+    uint64_t filter_max_ratio; // Maximum ratio of output to input size.
+    uint64_t filter_max_size;  // Maximum total output size.
+
+    // All registered filter types, see spicy_filter_register().
+    struct __spicy_filter_definition** filters;
+    int num_filters;
 } __spicy_global_state;
 
 /// Initializes all global state. The function is called from spicy_init().
@@ -52,6 +52,12 @@ void spicy_enable_debugging(int8_t enabled)
     __spicy_globals()->debugging = enabled;
 }
 
+void spicy_set_decompression_limits(uint64_t max_ratio, uint64_t max_size)
+{
+    __spicy_globals()->filter_max_ratio = max_ratio;
+    __spicy_globals()->filter_max_size = max_size;
+}
+
 int8_t spicy_debugging_enabled(hlt_exception** excpt, hlt_execution_context* ctx)
 {
     return __spicy_globals()->debugging;
@@ -101,3 +107,10 @@ void spicy_debug_print_ptr(hlt_string tag, const hlt_type_info* type, void** ptr
 {
     assert(false);
 }
+
+void spicyhilti_vector_append_unpacked(const hlt_type_info* type, void** vec,
+                                       hlt_iterator_bytes begin, int64_t n, hlt_enum fmt,
+                                       hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    hlt_vector_append_unpacked((hlt_vector*)*vec, begin, n, fmt, excpt, ctx);
+}
@@ -102,9 +102,27 @@ extern void spicy_enable_debugging(int8_t enabled);
 /// Returns: 1 if enabled, 0 otherwise.
 extern int8_t spicy_debugging_enabled(hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Sets limits for filters that decompress their input, to protect against
+/// decompression bombs. If a filter exceeds either limit, it raises a
+/// FilterError.
+///
+/// max_ratio: The maximum ratio of decompressed to compressed size; zero
+/// for no limit. The ratio is enforced only once the output exceeds 1MB.
+/// The default is 100.
+///
+/// max_size: The maximum total size of a filter's decompressed output in
+/// bytes; zero for no limit. The default is no limit.
+extern void spicy_set_decompression_limits(uint64_t max_ratio, uint64_t max_size);
+
 // Internal wrapper around spicy_debugging_enabled() to make it accessible
 // from the SpicyHilti namespace.
 extern int8_t spicyhilti_debugging_enabled(hlt_exception** excpt, hlt_execution_context* ctx);
 
+// Internal function used by the generated parsers to fill a vector of
+// integers from input in one go. See hlt_vector_append_unpacked().
+extern void spicyhilti_vector_append_unpacked(const hlt_type_info* type, void** vec,
+                                              hlt_iterator_bytes begin, int64_t n, hlt_enum fmt,
+                                              hlt_exception** excpt, hlt_execution_context* ctx);
+
 
 #endif
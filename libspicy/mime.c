@@ -169,6 +169,9 @@ void spicyhilti_sink_connect_mimetype_bytes(spicy_sink* sink, hlt_bytes* mtype,
                                             void* cookie, hlt_exception** excpt,
                                             hlt_execution_context* ctx)
 {
+    if ( __spicyhilti_sink_async_connect_mimetype(sink, mtype, try_mode, excpt, ctx) )
+        return;
+
     __connect_one(sink, mtype, mtype, try_mode, cookie, excpt, ctx);
 
     // Do a second check just for the main type.
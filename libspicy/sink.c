@@ -1,10 +1,13 @@
 
 #include <ctype.h>
+#include <sched.h>
+#include <string.h>
 
 #include <autogen/spicy-hlt.h>
 
 #include "exceptions.h"
 #include "filter.h"
+#include "mime.h"
 #include "sink.h"
 
 // XXX Needed?
@@ -20,14 +23,34 @@ typedef struct __parser_state {
     struct __parser_state* next;
 } __parser_state;
 
+// Maximum height of the skip list indexing a sink's chunks by sequence
+// number.
+#define SKIP_MAX_LEVEL 16
+
 typedef struct __chunk {
-    struct __chunk* next; // Next block. Has ownership.
-    struct __chunk* prev; // Previous block.
-    uint64_t rseq;        // Sequence number of first byte.
-    uint64_t rupper;      // Sequence number of last byte + 1.
-    hlt_bytes* data;      // Data at +1.
+    struct __chunk* next;   // Next block. Has ownership.
+    struct __chunk* prev;   // Previous block.
+    uint64_t rseq;          // Sequence number of first byte.
+    uint64_t rupper;        // Sequence number of last byte + 1.
+    hlt_bytes* data;        // Data at +1.
+    int level;              // Number of skip list levels the chunk is linked into.
+    struct __chunk* skip[]; // Successor on each skip list level.
 } __chunk;
 
+// Default for the number of bytes an asynchronous sink may have queued
+// before writers have to wait.
+#define ASYNC_DEFAULT_MAX_PENDING (1024 * 1024)
+
+// State of a sink in asynchronous mode. The sink then forwards all
+// operations to a twin sink that lives on another virtual thread, and that
+// does the actual reassembly and parsing.
+typedef struct {
+    hlt_vthread_id vid;   // The virtual thread running the twin.
+    uint64_t max_pending; // Maximum number of bytes queued before writers wait.
+    uint64_t pending;     // Number of bytes queued but not yet processed. Accessed atomically.
+    spicy_sink* twin;     // The twin; must only be accessed from within the vid.
+} __sink_async;
+
 struct spicy_sink {
     __hlt_gchdr __gch;    // Header for garbage collection.
     __parser_state* head; // List of parsing states.
@@ -43,6 +66,14 @@ struct spicy_sink {
     uint64_t trim_rseq;         // Sequence of last byte trimmed so far + 1.
     __chunk* first_chunk;       // First not yet reassembled chunk. Has ownership.
     __chunk* last_chunk;        // Last not yet reassembled chunk.
+
+    // Skip list over the chunks, ordered by rseq, for locating the
+    // insertion point of out-of-order data.
+    __chunk* skip_head[SKIP_MAX_LEVEL]; // First chunk on each level.
+    int skip_level;                     // Number of levels currently in use.
+    uint64_t skip_rand;                 // State for picking random chunk levels.
+
+    __sink_async* async; // Set if the sink is in asynchronous mode.
 };
 
 __HLT_RTTI_GC_TYPE(spicy_sink, HLT_TYPE_SPICY_SINK);
@@ -192,12 +223,40 @@ static void __report_skip(spicy_sink* sink, uint64_t rseq, void* user, hlt_excep
     }
 }
 
-static void __report_overlap(spicy_sink* sink, hlt_bytes* old_data, hlt_bytes* new_data,
-                             uint64_t rseq, void* user, hlt_exception** excpt,
+// Reports an overlap of *len* bytes at *rseq* between chunk *b* and new
+// data starting at *rseq*. We only extract the overlapping data if a parser
+// actually wants to see it.
+static void __report_overlap(spicy_sink* sink, __chunk* b, hlt_bytes* data, uint64_t rseq,
+                             int64_t len, void* user, hlt_exception** excpt,
                              hlt_execution_context* ctx)
 {
     DBG_LOG("spicy-sinks", "reporting overlap in sink %p at rseq %" PRIu64, sink, rseq);
 
+    __parser_state* s = sink->head;
+
+    while ( s && ! s->parser->hook_overlap )
+        s = s->next;
+
+    if ( ! s )
+        // Nobody interested.
+        return;
+
+    hlt_bytes* old_data = 0;
+    hlt_bytes* new_data = 0;
+
+    if ( b->data ) {
+        hlt_iterator_bytes i = hlt_bytes_begin(b->data, excpt, ctx);
+        i = hlt_iterator_bytes_incr_by(i, (rseq - b->rseq), excpt, ctx);
+        hlt_iterator_bytes j = hlt_iterator_bytes_incr_by(i, len, excpt, ctx);
+        old_data = hlt_bytes_sub(i, j, excpt, ctx);
+    }
+
+    if ( data ) {
+        hlt_iterator_bytes i = hlt_bytes_begin(data, excpt, ctx);
+        hlt_iterator_bytes j = hlt_iterator_bytes_incr_by(i, len, excpt, ctx);
+        new_data = hlt_bytes_sub(i, j, excpt, ctx);
+    }
+
     if ( ! old_data )
         old_data =
             hlt_bytes_new_from_data((int8_t*)"<unavailable>", sizeof("<unavailable>"), excpt, ctx);
@@ -246,14 +305,108 @@ static void __report_undelivered_up_to(spicy_sink* sink, uint64_t rupper, void*
     }
 }
 
-static __chunk* __new_chunk(hlt_bytes* data, uint64_t rseq, uint64_t len, hlt_exception** excpt,
-                            hlt_execution_context* ctx)
+static int __skip_random_level(spicy_sink* sink)
+{
+    // Xorshift; we just need something cheap and reasonably uniform.
+    uint64_t x = sink->skip_rand;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sink->skip_rand = x;
+
+    int level = 1;
+
+    while ( level < SKIP_MAX_LEVEL && (x & 1) ) {
+        ++level;
+        x >>= 1;
+    }
+
+    return level;
+}
+
+// Fills *update* with the last chunk on each level that starts before
+// *rseq*, or null if there's none.
+static void __skip_predecessors(spicy_sink* sink, uint64_t rseq, __chunk** update)
+{
+    __chunk* x = 0;
+
+    for ( int i = sink->skip_level - 1; i >= 0; i-- ) {
+        __chunk* n = x ? x->skip[i] : sink->skip_head[i];
+
+        while ( n && n->rseq < rseq ) {
+            x = n;
+            n = n->skip[i];
+        }
+
+        update[i] = x;
+    }
+}
+
+static void __skip_insert(spicy_sink* sink, __chunk* c)
+{
+    __chunk* update[SKIP_MAX_LEVEL];
+
+    if ( c->level > sink->skip_level )
+        sink->skip_level = c->level;
+
+    __skip_predecessors(sink, c->rseq, update);
+
+    for ( int i = 0; i < c->level; i++ ) {
+        __chunk** p = update[i] ? &update[i]->skip[i] : &sink->skip_head[i];
+        c->skip[i] = *p;
+        *p = c;
+    }
+}
+
+static void __skip_remove(spicy_sink* sink, __chunk* c)
+{
+    __chunk* update[SKIP_MAX_LEVEL];
+
+    __skip_predecessors(sink, c->rseq, update);
+
+    for ( int i = 0; i < c->level; i++ ) {
+        __chunk** p = update[i] ? &update[i]->skip[i] : &sink->skip_head[i];
+        assert(*p == c);
+        *p = c->skip[i];
+    }
+
+    while ( sink->skip_level > 0 && ! sink->skip_head[sink->skip_level - 1] )
+        --sink->skip_level;
+}
+
+// Returns the first chunk that doesn't come completely before *rseq*, or
+// null if there's none.
+static __chunk* __skip_find(spicy_sink* sink, uint64_t rseq)
+{
+    __chunk* x = 0;
+
+    for ( int i = sink->skip_level - 1; i >= 0; i-- ) {
+        __chunk* n = x ? x->skip[i] : sink->skip_head[i];
+
+        while ( n && n->rseq <= rseq ) {
+            x = n;
+            n = n->skip[i];
+        }
+    }
+
+    // x is now the last chunk starting at or before rseq.
+    if ( ! x )
+        return sink->first_chunk;
+
+    return x->rupper > rseq ? x : x->next;
+}
+
+static __chunk* __new_chunk(spicy_sink* sink, hlt_bytes* data, uint64_t rseq, uint64_t len,
+                            hlt_exception** excpt, hlt_execution_context* ctx)
 {
-    __chunk* c = hlt_malloc(sizeof(__chunk));
+    int level = __skip_random_level(sink);
+
+    __chunk* c = hlt_malloc(sizeof(__chunk) + level * sizeof(__chunk*));
     c->next = 0;
     c->prev = 0;
     c->rseq = rseq;
     c->rupper = rseq + len;
+    c->level = level;
     GC_ASSIGN(c->data, data, hlt_bytes, ctx);
     return c;
 }
@@ -283,11 +436,15 @@ static void __link_chunk(spicy_sink* sink, __chunk* prev, __chunk* c, hlt_except
 
         sink->first_chunk = c;
     }
+
+    __skip_insert(sink, c);
 }
 
 static void __unlink_chunk(spicy_sink* sink, __chunk* c, hlt_exception** excpt,
                            hlt_execution_context* ctx)
 {
+    __skip_remove(sink, c);
+
     if ( c->next )
         c->next->prev = c->prev;
     else
@@ -574,101 +731,84 @@ static void __try_deliver(spicy_sink* sink, __chunk* c, void* user, hlt_exceptio
     }
 }
 
-static __chunk* __add_and_check(spicy_sink* sink, __chunk* b, uint64_t rseq, uint64_t rupper,
+static __chunk* __add_and_check(spicy_sink* sink, uint64_t rseq, uint64_t rupper,
                                 hlt_bytes* data, void* user, hlt_exception** excpt,
                                 hlt_execution_context* ctx)
 {
     assert(sink->first_chunk);
     assert(sink->last_chunk);
 
-    // Special check for the common case of appending to the end.
-    if ( rseq == sink->last_chunk->rupper ) {
-        __chunk* c = __new_chunk(data, rseq, rupper - rseq, excpt, ctx);
-        __link_chunk(sink, sink->last_chunk, c, excpt, ctx);
-        return c;
-    }
+    // The chunk we return: the first one we create, or if none, the last
+    // one the new data overlaps with.
+    __chunk* result = 0;
 
-    // Find the first block that doesn't come completely before the new data.
-    while ( b->next && b->rupper <= rseq )
-        b = b->next;
+    // Special check for the common case of appending to the end.
+    __chunk* b = 0;
+
+    if ( rseq < sink->last_chunk->rupper )
+        // Find the first block that doesn't come completely before the new data.
+        b = __skip_find(sink, rseq);
+
+    while ( 1 ) {
+        if ( ! b ) {
+            // All blocks come completely before the new data.
+            __chunk* c = __new_chunk(sink, data, rseq, rupper - rseq, excpt, ctx);
+            __link_chunk(sink, sink->last_chunk, c, excpt, ctx);
+            return result ? result : c;
+        }
 
-    if ( b->rupper <= rseq ) {
-        // b is the last block, and it comes completely before the new block.
-        __chunk* c = __new_chunk(data, rseq, rupper - rseq, excpt, ctx);
-        __link_chunk(sink, b, c, excpt, ctx);
-        return c;
-    }
+        if ( rupper <= b->rseq ) {
+            // The new block comes completely before b.
+            __chunk* c = __new_chunk(sink, data, rseq, rupper - rseq, excpt, ctx);
+            __link_chunk(sink, b->prev, c, excpt, ctx);
+            return result ? result : c;
+        }
 
-    if ( rupper <= b->rseq ) {
-        // The new block comes completely before b.
-        __chunk* c = __new_chunk(data, rseq, rupper - rseq, excpt, ctx);
-        __link_chunk(sink, b->prev, c, excpt, ctx);
-        return c;
-    }
+        // The blocks overlap, complain.
 
-    __chunk* new_b = 0;
+        if ( rseq < b->rseq ) {
+            // The new block has a prefix that comes before b.
+            int64_t prefix_len = b->rseq - rseq;
 
-    // The blocks overlap, complain.
+            if ( data ) {
+                hlt_iterator_bytes begin = hlt_bytes_begin(data, excpt, ctx);
+                hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
+                hlt_iterator_bytes i = hlt_iterator_bytes_incr_by(begin, prefix_len, excpt, ctx);
+                hlt_bytes* sub = hlt_bytes_sub(begin, i, excpt, ctx);
+                __chunk* c = __new_chunk(sink, sub, rseq, prefix_len, excpt, ctx);
+                __link_chunk(sink, b->prev, c, excpt, ctx);
 
-    if ( rseq < b->rseq ) {
-        // The new block has a prefix that comes before b.
-        int64_t prefix_len = b->rseq - rseq;
+                if ( ! result )
+                    result = c;
 
-        if ( data ) {
-            hlt_iterator_bytes begin = hlt_bytes_begin(data, excpt, ctx);
-            hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
-            hlt_iterator_bytes i = hlt_iterator_bytes_incr_by(begin, prefix_len, excpt, ctx);
-            hlt_bytes* sub = hlt_bytes_sub(begin, i, excpt, ctx);
-            new_b = __new_chunk(sub, rseq, prefix_len, excpt, ctx);
-            __link_chunk(sink, b->prev, new_b, excpt, ctx);
+                data = hlt_bytes_sub(i, end, excpt, ctx);
+            }
 
-            data = hlt_bytes_sub(i, end, excpt, ctx);
+            rseq += prefix_len;
         }
 
-        rseq += prefix_len;
-    }
-
-    else
-        new_b = b;
-
-    uint64_t overlap_start = rseq;
-    int64_t new_b_len = rupper - rseq;
-    int64_t b_len = (b->rupper - overlap_start);
-    int64_t overlap_len = (new_b_len < b_len ? new_b_len : b_len);
-
-    hlt_bytes* old_data = 0;
-    hlt_bytes* new_data = 0;
+        uint64_t overlap_start = rseq;
+        int64_t new_b_len = rupper - rseq;
+        int64_t b_len = (b->rupper - overlap_start);
+        int64_t overlap_len = (new_b_len < b_len ? new_b_len : b_len);
 
-    if ( b->data ) {
-        hlt_iterator_bytes i = hlt_bytes_begin(b->data, excpt, ctx);
-        i = hlt_iterator_bytes_incr_by(i, (overlap_start - b->rseq), excpt, ctx);
-        hlt_iterator_bytes j = hlt_iterator_bytes_incr_by(i, overlap_len, excpt, ctx);
-        old_data = hlt_bytes_sub(i, j, excpt, ctx);
-    }
+        __report_overlap(sink, b, data, overlap_start, overlap_len, user, excpt, ctx);
 
-    if ( data ) {
-        hlt_iterator_bytes i = hlt_bytes_begin(data, excpt, ctx);
-        hlt_iterator_bytes j = hlt_iterator_bytes_incr_by(i, overlap_len, excpt, ctx);
-        new_data = hlt_bytes_sub(i, j, excpt, ctx);
-    }
+        if ( overlap_len >= new_b_len )
+            return result ? result : b;
 
-    __report_overlap(sink, old_data, new_data, overlap_start, user, excpt, ctx);
+        // Continue with the remainder of the new data, which starts right
+        // where b ends.
+        if ( data ) {
+            hlt_iterator_bytes i = hlt_bytes_begin(data, excpt, ctx);
+            hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
+            i = hlt_iterator_bytes_incr_by(i, overlap_len, excpt, ctx);
+            data = hlt_bytes_sub(i, end, excpt, ctx);
+        }
 
-    if ( overlap_len < new_b_len ) {
-        // Recurse to resolve remainder of the new data.
-        hlt_iterator_bytes i = hlt_bytes_begin(data, excpt, ctx);
-        hlt_iterator_bytes end = hlt_bytes_end(data, excpt, ctx);
-        i = hlt_iterator_bytes_incr_by(i, overlap_len, excpt, ctx);
-        data = hlt_bytes_sub(i, end, excpt, ctx);
         rseq += overlap_len;
-
-        if ( new_b == b )
-            new_b = __add_and_check(sink, b, rseq, rupper, data, user, excpt, ctx);
-        else
-            (void)__add_and_check(sink, b, rseq, rupper, data, user, excpt, ctx);
+        b = b->next;
     }
-
-    return new_b;
 }
 
 // data==null signals a gap.
@@ -711,13 +851,12 @@ static void __new_block(spicy_sink* sink, hlt_bytes* data, uint64_t rseq, hlt_by
     __chunk* c = 0;
 
     if ( ! sink->first_chunk ) {
-        c = __new_chunk(data, rseq, len, excpt, ctx);
-        sink->first_chunk = c;
-        sink->last_chunk = c;
+        c = __new_chunk(sink, data, rseq, len, excpt, ctx);
+        __link_chunk(sink, 0, c, excpt, ctx);
     }
 
     else
-        c = __add_and_check(sink, sink->first_chunk, rseq, rupper_rseq, data, user, excpt, ctx);
+        c = __add_and_check(sink, rseq, rupper_rseq, data, user, excpt, ctx);
 
 // See if we have data in order now to deliver.
 
@@ -736,21 +875,281 @@ exit:
     spicy_dbg_reassembler_buffer(sink, "buffer", excpt, ctx);
 }
 
+// Operations that an asynchronous sink forwards to its twin.
+typedef enum {
+    ASYNC_APPEND,
+    ASYNC_WRITE,
+    ASYNC_GAP,
+    ASYNC_SKIP,
+    ASYNC_TRIM,
+    ASYNC_CLOSE,
+    ASYNC_ADD_FILTER,
+    ASYNC_SET_INITIAL_SEQ,
+    ASYNC_CONNECT_MIMETYPE,
+    ASYNC_RELEASE
+} __async_op;
+
+// A job scheduled to an asynchronous sink's virtual thread. We build the
+// callable manually so that the job can run our C function directly.
+typedef struct {
+    hlt_callable callable; // Header, must come first.
+    __sink_async* async;   // The sink's asynchronous state.
+    __async_op op;         // The operation to perform.
+    hlt_bytes* data;       // Data for the operation, cloned for the target thread; at +1.
+    uint64_t size;         // Number of bytes this job accounts for in async->pending.
+    uint64_t seq;          // Sequence number argument.
+    uint64_t len;          // Length argument.
+    int64_t arg;           // Further argument depending on operation.
+    hlt_enum ftype;        // Filter type for ASYNC_ADD_FILTER.
+} __async_job;
+
+static void __async_job_run(hlt_callable* callable, void* target, hlt_exception** excpt,
+                            hlt_execution_context* ctx)
+{
+    __async_job* job = (__async_job*)callable;
+    __sink_async* async = job->async;
+
+    if ( job->op == ASYNC_RELEASE ) {
+        // The sink is gone, and this is the last job for it.
+        GC_CLEAR(async->twin, spicy_sink, ctx);
+        hlt_free(async);
+        return;
+    }
+
+    // Exceptions aren't propagated back to the writer; a failing parser just
+    // gets removed from the twin, as it would be with a synchronous sink.
+    hlt_exception* sink_excpt = 0;
+
+    // The twin's parsers run concurrently with the writer, so we don't pass
+    // on the writer's cookie; see spicyhilti_sink_set_async().
+
+    if ( ! async->twin ) {
+        async->twin = spicyhilti_sink_new(&sink_excpt, ctx);
+        GC_CCTOR(async->twin, spicy_sink, ctx);
+    }
+
+    spicy_sink* twin = async->twin;
+
+    switch ( job->op ) {
+    case ASYNC_APPEND:
+        spicyhilti_sink_append(twin, job->data, 0, &sink_excpt, ctx);
+        break;
+
+    case ASYNC_WRITE:
+        spicyhilti_sink_write_custom_length(twin, job->data, job->seq, job->len, 0,
+                                            &sink_excpt, ctx);
+        break;
+
+    case ASYNC_GAP:
+        spicyhilti_sink_gap(twin, job->seq, job->len, 0, &sink_excpt, ctx);
+        break;
+
+    case ASYNC_SKIP:
+        spicyhilti_sink_skip(twin, job->seq, 0, &sink_excpt, ctx);
+        break;
+
+    case ASYNC_TRIM:
+        spicyhilti_sink_trim(twin, job->seq, 0, &sink_excpt, ctx);
+        break;
+
+    case ASYNC_CLOSE:
+        spicyhilti_sink_close(twin, 0, &sink_excpt, ctx);
+        // We'll start over with a fresh twin if the sink gets reused.
+        GC_CLEAR(async->twin, spicy_sink, ctx);
+        break;
+
+    case ASYNC_ADD_FILTER:
+        spicyhilti_sink_add_filter(twin, job->ftype, &sink_excpt, ctx);
+        break;
+
+    case ASYNC_SET_INITIAL_SEQ:
+        spicyhilti_sink_set_initial_sequence_number(twin, job->seq, 0, &sink_excpt, ctx);
+        break;
+
+    case ASYNC_CONNECT_MIMETYPE:
+        spicyhilti_sink_connect_mimetype_bytes(twin, job->data, job->arg, 0, &sink_excpt,
+                                               ctx);
+        break;
+
+    case ASYNC_RELEASE:
+        break;
+    }
+
+    if ( sink_excpt ) {
+        DBG_LOG("spicy-sinks", "ignoring exception in asynchronous sink %p", twin);
+        GC_DTOR(sink_excpt, hlt_exception, ctx);
+    }
+
+    if ( job->size )
+        __atomic_sub_fetch(&async->pending, job->size, __ATOMIC_RELEASE);
+}
+
+static void __async_job_dtor(hlt_callable* callable, hlt_execution_context* ctx)
+{
+    __async_job* job = (__async_job*)callable;
+    GC_CLEAR(job->data, hlt_bytes, ctx);
+}
+
+static __hlt_callable_func __async_job_func = {0, __async_job_run, __async_job_dtor, 0,
+                                               sizeof(__async_job)};
+
+// Blocks the writer while the sink's thread has too much data queued. If
+// the writer runs inside a job, we suspend it to let the worker proceed with
+// other jobs. If it runs on the main thread, we wait for the worker to catch
+// up. Otherwise we can't wait and let the queue grow beyond the limit.
+static void __async_wait(__sink_async* async, hlt_execution_context* ctx)
+{
+    hlt_thread_mgr* mgr = hlt_global_thread_mgr();
+
+    while ( __atomic_load_n(&async->pending, __ATOMIC_ACQUIRE) > async->max_pending ) {
+        if ( __hlt_thread_mgr_terminating() )
+            return;
+
+        if ( ctx->worker ) {
+            if ( ! ctx->fiber )
+                return;
+
+            hlt_thread_mgr_flush(mgr, async->vid, ctx);
+            hlt_fiber_yield(ctx->fiber);
+        }
+
+        else {
+            hlt_thread_mgr_flush(mgr, async->vid, ctx);
+            sched_yield();
+        }
+    }
+}
+
+// Schedules an operation to an asynchronous sink's thread.
+static void __async_post(spicy_sink* sink, __async_op op, hlt_bytes* data, uint64_t seq,
+                         uint64_t len, int64_t arg, const hlt_enum* ftype, hlt_exception** excpt,
+                         hlt_execution_context* ctx)
+{
+    __sink_async* async = sink->async;
+
+    __async_job* job =
+        (__async_job*)GC_NEW_CUSTOM_SIZE_REF(hlt_callable, sizeof(__async_job), ctx);
+    job->callable.__func = &__async_job_func;
+    job->async = async;
+    job->op = op;
+    job->data = 0;
+    job->size = 0;
+    job->seq = seq;
+    job->len = len;
+    job->arg = arg;
+
+    if ( ftype )
+        job->ftype = *ftype;
+
+    if ( data ) {
+        hlt_clone_deep(&job->data, &hlt_type_info_hlt_bytes, &data, excpt, ctx);
+
+        if ( op != ASYNC_CONNECT_MIMETYPE ) {
+            job->size = hlt_bytes_len(data, excpt, ctx);
+            __atomic_add_fetch(&async->pending, job->size, __ATOMIC_RELAXED);
+        }
+    }
+
+    __hlt_thread_mgr_schedule(hlt_global_thread_mgr(), async->vid, &job->callable, excpt, ctx);
+
+    if ( op == ASYNC_CLOSE )
+        hlt_thread_mgr_flush(hlt_global_thread_mgr(), async->vid, ctx);
+
+    else if ( job->size )
+        __async_wait(async, ctx);
+}
+
+// Records a write to an asynchronous sink locally, so that size() and
+// sequence() reflect what has been passed on.
+static void __async_account(spicy_sink* sink, uint64_t rseq, uint64_t len, hlt_bytes* data,
+                            hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( data )
+        sink->size += hlt_bytes_len(data, excpt, ctx);
+
+    if ( rseq + len > sink->cur_rseq )
+        sink->cur_rseq = rseq + len;
+}
+
+int8_t __spicyhilti_sink_async_connect_mimetype(spicy_sink* sink, hlt_bytes* mtype,
+                                                int8_t try_mode, hlt_exception** excpt,
+                                                hlt_execution_context* ctx)
+{
+    if ( ! sink->async )
+        return 0;
+
+    __async_post(sink, ASYNC_CONNECT_MIMETYPE, mtype, 0, 0, try_mode, 0, excpt, ctx);
+    return 1;
+}
+
+// Releases an asynchronous sink's state once the sink goes away. Jobs
+// still queued for the twin refer to the state, so we leave the release to
+// the twin's thread, where it runs after them. Once the threads are gone,
+// we can release it right away.
+static void __async_release(__sink_async* async, hlt_execution_context* ctx)
+{
+    hlt_thread_mgr* mgr = hlt_global_thread_mgr();
+    hlt_thread_mgr_state state = (mgr ? hlt_thread_mgr_get_state(mgr) : HLT_THREAD_MGR_DEAD);
+
+    if ( state == HLT_THREAD_MGR_DEAD ) {
+        GC_CLEAR(async->twin, spicy_sink, ctx);
+        hlt_free(async);
+        return;
+    }
+
+    if ( state != HLT_THREAD_MGR_RUN && state != HLT_THREAD_MGR_FINISH ) {
+        // Workers may still be inside a job, but won't run the release
+        // anymore. Leak the state rather than risk a crash on shutdown.
+        DBG_LOG("spicy-sinks", "cannot release asynchronous state %p while terminating", async);
+        return;
+    }
+
+    __async_job* job =
+        (__async_job*)GC_NEW_CUSTOM_SIZE_REF(hlt_callable, sizeof(__async_job), ctx);
+    job->callable.__func = &__async_job_func;
+    job->async = async;
+    job->op = ASYNC_RELEASE;
+    job->data = 0;
+    job->size = 0;
+
+    hlt_exception* excpt = 0;
+    __hlt_thread_mgr_schedule(mgr, async->vid, &job->callable, &excpt, ctx);
+    hlt_thread_mgr_flush(mgr, async->vid, ctx);
+
+    if ( excpt )
+        GC_DTOR(excpt, hlt_exception, ctx);
+}
+
 void spicy_sink_dtor(hlt_type_info* ti, spicy_sink* sink, hlt_execution_context* ctx)
 {
-// TODO: This is not consistnely called because HILTI is actually using
-// its own type info for the dummy struct type. We should unify that, but
-// it's not clear how .. For now, we can't rely on this running.
-#if 0
+    // TODO: This is not consistently called because HILTI is actually using
+    // its own type info for the dummy struct type. We should unify that, but
+    // it's not clear how .. For now, we can't rely on this running. Closing
+    // a sink releases its asynchronous state as well, and Spicy closes
+    // sinks along with their units.
+
     while ( sink->head )
-        __unlink_state(sink, sink->head);
+        __unlink_state(sink, sink->head, ctx);
 
     GC_CLEAR(sink->filter, spicy_filter, ctx);
 
-    __trim(sink, UINT64_MAX, user, excpt, ctx);
-    assert(! sink->first_chunk);
-    assert(! sink->last_chunk);
-#endif
+    // Unlike close(), we don't report anything still buffered, as there's
+    // no cookie to pass on anymore.
+    __chunk* c = sink->first_chunk;
+
+    while ( c ) {
+        __chunk* n = c->next;
+        __delete_chunk(c, 0, ctx);
+        c = n;
+    }
+
+    sink->first_chunk = 0;
+    sink->last_chunk = 0;
+
+    if ( sink->async ) {
+        __async_release(sink->async, ctx);
+        sink->async = 0;
+    }
 }
 
 spicy_sink* spicyhilti_sink_new(hlt_exception** excpt, hlt_execution_context* ctx)
@@ -767,6 +1166,10 @@ spicy_sink* spicyhilti_sink_new(hlt_exception** excpt, hlt_execution_context* ct
     sink->trim_rseq = 0;
     sink->first_chunk = 0;
     sink->last_chunk = 0;
+    memset(sink->skip_head, 0, sizeof(sink->skip_head));
+    sink->skip_level = 0;
+    sink->skip_rand = 0x9e3779b97f4a7c15;
+    sink->async = 0;
     return sink;
 }
 
@@ -782,6 +1185,49 @@ void spicyhilti_sink_set_initial_sequence_number(spicy_sink* sink, uint64_t init
     }
 
     sink->initial_seq = initial_seq;
+
+    if ( sink->async )
+        __async_post(sink, ASYNC_SET_INITIAL_SEQ, 0, initial_seq, 0, 0, 0, excpt, ctx);
+}
+
+void spicyhilti_sink_set_async(spicy_sink* sink, hlt_vthread_id vid, uint64_t max_pending,
+                               void* user, hlt_exception** excpt, hlt_execution_context* ctx)
+{
+    if ( ! hlt_is_multi_threaded() ) {
+        DBG_LOG("spicy-sinks", "threading not enabled, sink %p remains synchronous", sink);
+        return;
+    }
+
+    if ( sink->async ) {
+        if ( vid != sink->async->vid ) {
+            hlt_string msg =
+                hlt_string_from_asciiz("sink cannot change its virtual thread", excpt, ctx);
+            hlt_set_exception(excpt, &spicy_exception_valueerror, msg, ctx);
+            return;
+        }
+
+        sink->async->max_pending = (max_pending ? max_pending : ASYNC_DEFAULT_MAX_PENDING);
+        return;
+    }
+
+    if ( sink->head || sink->filter || sink->cur_rseq || sink->first_chunk ) {
+        spicyhilti_sink_close(sink, user, excpt, ctx);
+        hlt_string msg =
+            hlt_string_from_asciiz("sink cannot become asynchronous once in use", excpt, ctx);
+        hlt_set_exception(excpt, &spicy_exception_valueerror, msg, ctx);
+        return;
+    }
+
+    sink->async = hlt_malloc(sizeof(__sink_async));
+    sink->async->vid = vid;
+    sink->async->max_pending = (max_pending ? max_pending : ASYNC_DEFAULT_MAX_PENDING);
+    sink->async->pending = 0;
+    sink->async->twin = 0;
+
+    DBG_LOG("spicy-sinks", "sink %p is now asynchronous on vid %" PRId64, sink, vid);
+
+    if ( sink->initial_seq )
+        __async_post(sink, ASYNC_SET_INITIAL_SEQ, 0, sink->initial_seq, 0, 0, 0, excpt, ctx);
 }
 
 void spicyhilti_sink_set_policy(spicy_sink* sink, int64_t policy, void* user, hlt_exception** excpt,
@@ -818,6 +1264,16 @@ void _spicyhilti_sink_connect_intern(spicy_sink* sink, const hlt_type_info* type
                                      spicy_parser* parser, hlt_bytes* mtype, hlt_exception** excpt,
                                      hlt_execution_context* ctx)
 {
+    if ( sink->async ) {
+        // The parsing object belongs to the caller's thread, so we can't
+        // pass it on to the sink's thread.
+        hlt_string msg =
+            hlt_string_from_asciiz("asynchronous sinks support only connecting by MIME type",
+                                   excpt, ctx);
+        hlt_set_exception(excpt, &spicy_exception_notimplemented, msg, ctx);
+        return;
+    }
+
     __parser_state* state = hlt_malloc(sizeof(__parser_state));
     state->parser = parser;
     GC_CCTOR(state->parser, hlt_SpicyHilti_Parser, ctx);
@@ -1018,6 +1474,13 @@ void spicyhilti_sink_append(spicy_sink* sink, hlt_bytes* data, void* user, hlt_e
                             hlt_execution_context* ctx)
 {
     hlt_bytes_size len = hlt_bytes_len(data, excpt, ctx);
+
+    if ( sink->async ) {
+        __async_account(sink, sink->cur_rseq, len, data, excpt, ctx);
+        __async_post(sink, ASYNC_APPEND, data, 0, 0, 0, 0, excpt, ctx);
+        return;
+    }
+
     __new_block(sink, data, sink->cur_rseq, len, user, excpt, ctx);
 }
 
@@ -1028,6 +1491,13 @@ void spicyhilti_sink_write(spicy_sink* sink, hlt_bytes* data, uint64_t seq, void
         return;
 
     hlt_bytes_size len = hlt_bytes_len(data, excpt, ctx);
+
+    if ( sink->async ) {
+        __async_account(sink, (seq - sink->initial_seq), len, data, excpt, ctx);
+        __async_post(sink, ASYNC_WRITE, data, seq, len, 0, 0, excpt, ctx);
+        return;
+    }
+
     __new_block(sink, data, (seq - sink->initial_seq), len, user, excpt, ctx);
 }
 
@@ -1038,6 +1508,12 @@ void spicyhilti_sink_write_custom_length(spicy_sink* sink, hlt_bytes* data, uint
     if ( ! __check_seq(sink, seq, user, excpt, ctx) )
         return;
 
+    if ( sink->async ) {
+        __async_account(sink, (seq - sink->initial_seq), len, data, excpt, ctx);
+        __async_post(sink, ASYNC_WRITE, data, seq, len, 0, 0, excpt, ctx);
+        return;
+    }
+
     __new_block(sink, data, (seq - sink->initial_seq), len, user, excpt, ctx);
 }
 
@@ -1047,6 +1523,12 @@ void spicyhilti_sink_gap(spicy_sink* sink, uint64_t seq, uint64_t len, void* use
     if ( ! __check_seq(sink, seq, user, excpt, ctx) )
         return;
 
+    if ( sink->async ) {
+        __async_account(sink, (seq - sink->initial_seq), len, 0, excpt, ctx);
+        __async_post(sink, ASYNC_GAP, 0, seq, len, 0, 0, excpt, ctx);
+        return;
+    }
+
     __new_block(sink, 0, (seq - sink->initial_seq), len, user, excpt, ctx);
 }
 
@@ -1056,6 +1538,11 @@ void spicyhilti_sink_trim(spicy_sink* sink, uint64_t seq, void* user, hlt_except
     if ( ! __check_seq(sink, seq, user, excpt, ctx) )
         return;
 
+    if ( sink->async ) {
+        __async_post(sink, ASYNC_TRIM, 0, seq, 0, 0, 0, excpt, ctx);
+        return;
+    }
+
     __trim(sink, (seq - sink->initial_seq), user, excpt, ctx);
     spicy_dbg_reassembler_buffer(sink, "buffer after trim", excpt, ctx);
 }
@@ -1066,6 +1553,12 @@ void spicyhilti_sink_skip(spicy_sink* sink, uint64_t seq, void* user, hlt_except
     if ( ! __check_seq(sink, seq, user, excpt, ctx) )
         return;
 
+    if ( sink->async ) {
+        __async_account(sink, (seq - sink->initial_seq), 0, 0, excpt, ctx);
+        __async_post(sink, ASYNC_SKIP, 0, seq, 0, 0, 0, excpt, ctx);
+        return;
+    }
+
     __skip(sink, (seq - sink->initial_seq), user, excpt, ctx);
     spicy_dbg_reassembler_buffer(sink, "buffer after skip", excpt, ctx);
 }
@@ -1075,6 +1568,16 @@ void spicyhilti_sink_close(spicy_sink* sink, void* user, hlt_exception** excpt,
 {
     DBG_LOG("spicy-sinks", "closing sink %p", sink);
 
+    if ( sink->async ) {
+        // Closing ends asynchronous mode; release the state now rather than
+        // relying on the destructor.
+        __async_post(sink, ASYNC_CLOSE, 0, 0, 0, 0, 0, excpt, ctx);
+        __async_release(sink->async, ctx);
+        sink->async = 0;
+        sink->cur_rseq = 0;
+        return;
+    }
+
     if ( sink->filter ) {
         spicyhilti_filter_close(sink->filter, excpt, ctx);
         GC_CLEAR(sink->filter, spicy_filter, ctx);
@@ -1097,6 +1600,11 @@ void spicyhilti_sink_close(spicy_sink* sink, void* user, hlt_exception** excpt,
 void spicyhilti_sink_add_filter(spicy_sink* sink, hlt_enum ftype, hlt_exception** excpt,
                                 hlt_execution_context* ctx)
 {
+    if ( sink->async ) {
+        __async_post(sink, ASYNC_ADD_FILTER, 0, 0, 0, 0, &ftype, excpt, ctx);
+        return;
+    }
+
     spicy_filter* old_filter = sink->filter;
     sink->filter = spicyhilti_filter_add(sink->filter, ftype, excpt, ctx);
     GC_CCTOR(sink->filter, spicy_filter, ctx);
@@ -1105,6 +1613,17 @@ void spicyhilti_sink_add_filter(spicy_sink* sink, hlt_enum ftype, hlt_exception*
     DBG_LOG("spicy-sinks", "attached filter %s to sink %p", sink->filter->def->name, sink);
 }
 
+void spicyhilti_sink_add_filter_by_name(spicy_sink* sink, hlt_string name, hlt_exception** excpt,
+                                        hlt_execution_context* ctx)
+{
+    hlt_enum ftype = spicyhilti_filter_lookup(name, excpt, ctx);
+
+    if ( *excpt )
+        return;
+
+    spicyhilti_sink_add_filter(sink, ftype, excpt, ctx);
+}
+
 uint64_t spicyhilti_sink_size(spicy_sink* sink, hlt_exception** excpt, hlt_execution_context* ctx)
 {
     return sink->size;
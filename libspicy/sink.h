@@ -72,6 +72,46 @@ extern void spicyhilti_sink_set_policy(spicy_sink* sink, int64_t policy, void* u
 extern void spicyhilti_sink_set_auto_trim(spicy_sink* sink, int8_t enable, void* user,
                                           hlt_exception** excpt, hlt_execution_context* ctx);
 
+/// Switches a sink into asynchronous mode. In this mode, the sink passes
+/// all data on to a separate virtual thread, which then does reassembly,
+/// filtering, and parsing there, so that the writer doesn't have to wait for
+/// connected parsers to process the data. The writer does wait, however,
+/// once more than *max_pending* bytes are queued up. Parsers can then be
+/// connected only by MIME type, as they need to be instantiated on the
+/// sink's thread. Exceptions raised by them aren't propagated back to the
+/// writer. size() and sequence() reflect what has been written into the
+/// sink, rather than what has been delivered.
+///
+/// As the parsers run concurrently with the writer, they don't receive the
+/// writer's user cookie; hooks that the sink runs on the sink's thread get
+/// a null cookie instead. Host applications must not rely on their cookie
+/// for units parsed asynchronously. Once the sink goes away, its state gets
+/// released on the sink's thread after all data still queued there.
+///
+/// This must be called before any data is written into the sink, and before
+/// any parsers or filters are attached; doing so will throw a \a ValueError
+/// exception. If the run-time system is not configured for threading, the
+/// function does nothing and the sink remains synchronous.
+///
+/// sink: The sink to switch.
+///
+/// vid: The virtual thread to process the sink's data.
+///
+/// max_pending: The maximum number of bytes to queue up; zero for a default.
+///
+/// excpt: &
+/// ctx: &
+extern void spicyhilti_sink_set_async(spicy_sink* sink, hlt_vthread_id vid, uint64_t max_pending,
+                                      void* user, hlt_exception** excpt,
+                                      hlt_execution_context* ctx);
+
+// Internal function for mime.c that forwards connecting parsers by MIME type
+// to an asynchronous sink's thread. Returns false if the sink is not
+// asynchronous.
+extern int8_t __spicyhilti_sink_async_connect_mimetype(spicy_sink* sink, hlt_bytes* mtype,
+                                                       int8_t try_mode, hlt_exception** excpt,
+                                                       hlt_execution_context* ctx);
+
 /// Connects a parser to a sink. Note that there can be only one parser of
 /// each type. If there's already one of the same kind, the request is
 /// silently ignored.
@@ -217,6 +257,18 @@ extern void spicyhilti_sink_close(spicy_sink* sink, void* user, hlt_exception**
 extern void spicyhilti_sink_add_filter(spicy_sink* sink, hlt_enum ftype, hlt_exception** excpt,
                                        hlt_execution_context* ctx);
 
+/// Attaches a filter selected by name to a sink. Otherwise the same as
+/// spicyhilti_sink_add_filter().
+///
+/// sink: The sink to attach the filter to.
+/// name: The name the filter type was registered with.
+/// excpt: &
+/// ctx: &
+///
+/// Raises: FilterUnsupported - If no filter of that name is registered.
+extern void spicyhilti_sink_add_filter_by_name(spicy_sink* sink, hlt_string name,
+                                               hlt_exception** excpt, hlt_execution_context* ctx);
+
 /// Returns the number of bytes written to a sink so far. If the sink has
 /// filters attached, this returns the size after filtering.
 ///
@@ -436,6 +436,50 @@ void CodeGen::hiltiRunFieldHooks(shared_ptr<spicy::type::Unit> unit,
                  nullptr, false, cookie);
 }
 
+shared_ptr<hilti::Expression> CodeGen::hiltiFieldHooksImplemented(
+    shared_ptr<spicy::type::Unit> unit, shared_ptr<type::unit::Item> item, bool compose,
+    bool foreach)
+{
+    shared_ptr<hilti::Expression> result = nullptr;
+
+    for ( auto private_ : {true, false} ) {
+        if ( foreach && private_ )
+            continue;
+
+        auto name = _hiltiHookName(unit, hookForItem(unit, item, foreach, private_, compose));
+
+        if ( ! moduleBuilder()->lookupNode("hook", name) )
+            // Not triggered, see hiltiRunHook().
+            continue;
+
+        auto impl = moduleBuilder()->addTmp("hook_impl", hilti::builder::boolean::type());
+        builder()->addInstruction(impl, hilti::instruction::hook::Implemented,
+                                  hilti::builder::id::create(name));
+
+        if ( result )
+            builder()->addInstruction(impl, hilti::instruction::boolean::Or, impl, result);
+
+        result = impl;
+    }
+
+    return result ? result : hilti::builder::boolean::create(false);
+}
+
+string CodeGen::_hiltiHookName(shared_ptr<spicy::type::Unit> unit, shared_ptr<ID> id)
+{
+    auto name = id->pathAsString();
+
+    // TODO: Don't need "local" anymore I believe.
+
+    auto unit_module = unit->firstParent<Module>();
+    assert(unit_module);
+
+    if ( unit_module->id()->name() != module()->id()->name() )
+        name = util::fmt("%s::%s", unit_module->id()->name(), name);
+
+    return name;
+}
+
 void CodeGen::hiltiDefineHook(shared_ptr<ID> id, shared_ptr<Hook> hook)
 {
     auto unit = hook->unit();
@@ -487,15 +531,7 @@ shared_ptr<hilti::Expression> CodeGen::hiltiRunHook(
         builder()->addDebugMsg("spicy-verbose", msg);
     }
 
-    auto name = id->pathAsString();
-
-    // TODO: Don't need "local" anymore I believe.
-
-    auto unit_module = unit->firstParent<Module>();
-    assert(unit_module);
-
-    if ( unit_module->id()->name() != module()->id()->name() )
-        name = util::fmt("%s::%s", unit_module->id()->name(), name);
+    auto name = _hiltiHookName(unit, id);
 
     // Declare the hook if we don't have done that yet.
     if ( ! moduleBuilder()->lookupNode("hook", name) ) {
@@ -244,6 +244,27 @@ public:
                             shared_ptr<hilti::Expression> self, bool compose,
                             shared_ptr<hilti::Expression> cookie);
 
+    /// Generates code that checks whether any implementations are bound to
+    /// the field hooks that hiltiRunFieldHooks() triggers for an item. That's
+    /// determined at link time, with the result being constant from then
+    /// on. Must be called after hiltiRunFieldHooks() has been called for the
+    /// same item.
+    ///
+    /// unit: The type of the unit that the hook the hook is associated with.
+    ///
+    /// item: The item.
+    ///
+    /// compose: If true, check compose hooks; parse hooks otherwise.
+    ///
+    /// foreach: If true, check the item's foreach hooks instead. That
+    /// considers only hooks defined outside of the unit, as containers
+    /// always come with their own one internally.
+    ///
+    /// Returns: A HILTI boolean that's true if there are implementations.
+    shared_ptr<hilti::Expression> hiltiFieldHooksImplemented(shared_ptr<spicy::type::Unit> unit,
+                                                             shared_ptr<type::unit::Item> item,
+                                                             bool compose, bool foreach = false);
+
     /// Generates code to execute a hook.
 
     /// self: The self parameter to pass to the hook.
@@ -701,6 +722,10 @@ private:
     // same module; true) or cross-module (false).
     std::pair<bool, string> _hookName(const string& path);
 
+    // Returns the name of the HILTI hook corresponding to a hook ID as
+    // returned by hookForItem() or hookForUnit().
+    string _hiltiHookName(shared_ptr<spicy::type::Unit> unit, shared_ptr<ID> id);
+
     // Creates the init function that registers a parser with the Spicy runtime.
     void _hiltiCreateParserInitFunction(shared_ptr<type::Unit> unit);
 
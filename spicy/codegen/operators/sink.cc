@@ -153,6 +153,19 @@ void CodeBuilder::visit(spicy::expression::operator_::sink::AddFilter* i)
     setResult(std::make_shared<hilti::expression::Void>());
 }
 
+void CodeBuilder::visit(spicy::expression::operator_::sink::AddFilterByName* i)
+{
+    auto sink = cg()->hiltiExpression(i->op1());
+    auto name = cg()->hiltiExpression(callParameter(i->op3(), 0));
+
+    auto func = hilti::builder::id::create("SpicyHilti::sink_add_filter_by_name");
+
+    cg()->builder()->addInstruction(hilti::instruction::flow::CallVoid, func,
+                                    hilti::builder::tuple::create({sink, name}));
+
+    setResult(std::make_shared<hilti::expression::Void>());
+}
+
 void CodeBuilder::visit(expression::operator_::sink::Size* i)
 {
     auto sink = cg()->hiltiExpression(i->op1());
@@ -241,6 +254,23 @@ void CodeBuilder::visit(expression::operator_::sink::SetAutoTrim* i)
     setResult(std::make_shared<hilti::expression::Void>());
 }
 
+void CodeBuilder::visit(expression::operator_::sink::SetAsync* i)
+{
+    auto sink = cg()->hiltiExpression(i->op1());
+    auto vid = cg()->hiltiExpression(callParameter(i->op3(), 0));
+    auto max_pending = callParameter(i->op3(), 1);
+
+    auto max = max_pending ? cg()->hiltiExpression(max_pending) :
+                             hilti::builder::integer::create(0);
+
+    cg()->builder()->addInstruction(hilti::instruction::flow::CallVoid,
+                                    hilti::builder::id::create("SpicyHilti::sink_set_async"),
+                                    hilti::builder::tuple::create(
+                                        {sink, vid, max, cg()->hiltiCookie()}));
+
+    setResult(std::make_shared<hilti::expression::Void>());
+}
+
 void CodeBuilder::visit(expression::operator_::sink::SetPolicy* i)
 {
     auto sink = cg()->hiltiExpression(i->op1());
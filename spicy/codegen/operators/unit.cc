@@ -216,6 +216,24 @@ void CodeBuilder::visit(spicy::expression::operator_::unit::AddFilter* i)
     setResult(std::make_shared<hilti::expression::Void>());
 }
 
+void CodeBuilder::visit(spicy::expression::operator_::unit::AddFilterByName* i)
+{
+    auto self = cg()->hiltiExpression(i->op1());
+    auto name = cg()->hiltiExpression(callParameter(i->op3(), 0));
+
+    auto ft =
+        hilti::builder::reference::type(hilti::builder::type::byName("SpicyHilti::ParseFilter"));
+    auto head = cg()->hiltiItemGet(self, "__filter", ft, hilti::builder::reference::createNull());
+
+    cg()->builder()->addInstruction(head, hilti::instruction::flow::CallResult,
+                                    hilti::builder::id::create("SpicyHilti::filter_add_by_name"),
+                                    hilti::builder::tuple::create({head, name}));
+
+    cg()->hiltiItemSet(self, "__filter", head);
+
+    setResult(std::make_shared<hilti::expression::Void>());
+}
+
 void CodeBuilder::visit(spicy::expression::operator_::unit::Disconnect* i)
 {
     auto self = cg()->hiltiExpression(i->op1());
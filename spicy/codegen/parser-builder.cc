@@ -400,6 +400,7 @@ bool ParserBuilder::_hiltiParse(shared_ptr<Node> node, shared_ptr<hilti::Express
         try_position = cg()->builder()->addTmp("try_pos", _hiltiTypeIteratorBytes());
         cg()->builder()->addInstruction(try_position, hilti::instruction::operator_::Assign,
                                         state()->cur);
+        _hiltiPinPosition(try_position);
         cg()->builder()->beginTryCatch();
     }
 
@@ -417,6 +418,7 @@ bool ParserBuilder::_hiltiParse(shared_ptr<Node> node, shared_ptr<hilti::Express
         cg()->builder()->popCatch();
 
         cg()->builder()->endTryCatch();
+        _hiltiReleasePosition(try_position);
     }
 
     if ( pstate_length ) {
@@ -735,8 +737,16 @@ shared_ptr<hilti::Expression> ParserBuilder::_hiltiCallParseFunction(
     if ( catch_parse_error )
         cg()->builder()->beginTryCatch();
 
-    cg()->builder()->addInstruction(presult, hilti::instruction::flow::CallResult, func,
-                                    state()->hiltiArguments());
+    auto args = state()->hiltiArguments();
+
+    if ( _pinned.size() ) {
+        // The callee can't know what we may still go back to.
+        auto nstate = state()->clone();
+        nstate->trim = hilti::builder::boolean::create(false);
+        args = nstate->hiltiArguments();
+    }
+
+    cg()->builder()->addInstruction(presult, hilti::instruction::flow::CallResult, func, args);
 
     if ( catch_parse_error ) {
         // TODO: We shouldn't need to make this unique here, but we do.
@@ -893,6 +903,11 @@ shared_ptr<hilti::Expression> ParserBuilder::_newParseFunction(const string& nam
 
     pushState(std::make_shared<ParserState>(u));
 
+    // Positions pinned by the caller refer to its locals; the caller
+    // disables trimming for the call instead.
+    _pinned_outer.push_back(_pinned);
+    _pinned.clear();
+
     return std::make_shared<hilti::expression::Function>(func->function(), func->location());
 }
 
@@ -909,6 +924,9 @@ void ParserBuilder::_finishParseFunction(bool finalize_pobj)
 
     popState();
     cg()->moduleBuilder()->popFunction();
+
+    _pinned = _pinned_outer.back();
+    _pinned_outer.pop_back();
 }
 
 static shared_ptr<hilti::type::struct_::Field> _convertField(
@@ -1430,12 +1448,36 @@ void ParserBuilder::_newValueForField(shared_ptr<Production> p,
     }
 
     if ( field ) {
-        _hiltiSaveInputPostion();
-
         auto unit = field->unit() ? field->unit() : state()->unit;
-        cg()->hiltiRunFieldHooks(unit, field, state()->self, false, state()->cookie);
 
-        _hiltiUpdateInputPostion();
+        if ( cg()->options().debug > 0 ) {
+            // Always trigger, so that the debug output remains complete.
+            _hiltiSaveInputPostion();
+            cg()->hiltiRunFieldHooks(unit, field, state()->self, false, state()->cookie);
+            _hiltiUpdateInputPostion();
+        }
+
+        else {
+            // Whether anybody implements the hooks is known only at link
+            // time. Guard the hooks and the position bookkeeping around them
+            // by a check that the linker turns into a constant, so that the
+            // optimizer removes all of it for fields that nobody hooks.
+            auto run = cg()->moduleBuilder()->newBuilder("run_hooks");
+            auto cont = cg()->moduleBuilder()->newBuilder("cont");
+
+            cg()->moduleBuilder()->pushBuilder(run);
+            _hiltiSaveInputPostion();
+            cg()->hiltiRunFieldHooks(unit, field, state()->self, false, state()->cookie);
+            _hiltiUpdateInputPostion();
+            cg()->builder()->addInstruction(hilti::instruction::flow::Jump, cont->block());
+            cg()->moduleBuilder()->popBuilder(run);
+
+            auto implemented = cg()->hiltiFieldHooksImplemented(unit, field, false);
+            cg()->builder()->addInstruction(hilti::instruction::flow::IfElse, implemented,
+                                            run->block(), cont->block());
+
+            cg()->moduleBuilder()->pushBuilder(cont);
+        }
     }
 
     _last_parsed_value = value;
@@ -1581,6 +1623,7 @@ void ParserBuilder::_hiltiGetLookAhead(shared_ptr<Production> prod,
     auto ncur = cg()->moduleBuilder()->addTmp("ncur", _hiltiTypeIteratorBytes());
     cg()->builder()->addInstruction(ocur, hilti::instruction::operator_::Assign, state()->cur);
     cg()->builder()->addInstruction(ncur, hilti::instruction::operator_::Assign, state()->cur);
+    _hiltiPinPosition(ocur);
 
     // We handle regexps literals jointly first by matching them all in
     // parallel.
@@ -1733,10 +1776,92 @@ void ParserBuilder::_hiltiGetLookAhead(shared_ptr<Production> prod,
 
     cg()->moduleBuilder()->pushBuilder(done);
 
+    _hiltiReleasePosition(ocur);
+
+    if ( saved_pos )
+        _hiltiReleasePosition(saved_pos);
+
     if ( cg()->options().debug > 0 )
         cg()->builder()->addDebugMsg("spicy-verbose", "- new look-ahead is %s", state()->lahead);
 }
 
+void ParserBuilder::_hiltiGetLookAheadByFirstByte(
+    shared_ptr<production::LookAhead> prod, const std::list<shared_ptr<production::Terminal>>& terms,
+    bool must_find)
+{
+    auto done = cg()->moduleBuilder()->newBuilder("first-byte-done");
+
+    // Without any input to look at, we leave it to the standard matching
+    // to wait for more.
+    auto at_eod = _hiltiAtEod();
+    auto branches = cg()->builder()->addIf(at_eod);
+    auto no_input = std::get<0>(branches);
+    auto have_input = std::get<1>(branches);
+
+    cg()->moduleBuilder()->pushBuilder(no_input);
+    _hiltiGetLookAhead(prod, terms, must_find);
+    cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+    cg()->moduleBuilder()->popBuilder(no_input);
+
+    cg()->moduleBuilder()->pushBuilder(have_input);
+
+    cg()->builder()->addComment("Narrowing down look-ahead tokens by first byte");
+
+    auto byte = cg()->moduleBuilder()->addTmp("first_byte", hilti::builder::integer::type(8));
+    auto byte64 =
+        cg()->moduleBuilder()->addTmp("first_byte64", hilti::builder::integer::type(64));
+    cg()->builder()->addInstruction(byte, hilti::instruction::iterBytes::Deref, state()->cur);
+    cg()->builder()->addInstruction(byte64, hilti::instruction::integer::ZExt, byte);
+
+    // We build one block per distinct set of candidates, shared by all the
+    // bytes leading to it.
+    std::map<production::LookAhead::look_aheads, shared_ptr<hilti::builder::BlockBuilder>> blocks;
+
+    auto match = [&](const production::LookAhead::look_aheads& candidates) {
+        auto i = blocks.find(candidates);
+
+        if ( i != blocks.end() )
+            return i->second;
+
+        auto b = cg()->moduleBuilder()->pushBuilder("first-byte-match");
+
+        std::list<shared_ptr<production::Terminal>> cterms;
+
+        for ( auto t : terms ) {
+            if ( candidates.find(t) != candidates.end() )
+                cterms.push_back(t);
+        }
+
+        if ( cterms.size() ) {
+            _hiltiGetLookAhead(prod, cterms, must_find);
+            cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+        }
+
+        else if ( must_find )
+            _hiltiParseError("expected symbol(s) not found");
+
+        else
+            cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+
+        cg()->moduleBuilder()->popBuilder(b);
+
+        blocks[candidates] = b;
+        return b;
+    };
+
+    hilti::builder::BlockBuilder::case_list cases;
+
+    for ( auto e : prod->firstBytes() )
+        cases.push_back(std::make_pair(hilti::builder::integer::create(e.first), match(e.second)));
+
+    auto default_ = match(prod->firstBytesDefault());
+    cg()->builder()->addSwitch(byte64, default_, cases);
+
+    cg()->moduleBuilder()->popBuilder(have_input);
+
+    cg()->moduleBuilder()->pushBuilder(done); // Leave on stack.
+}
+
 shared_ptr<hilti::Expression> ParserBuilder::_hiltiMatchTokenInit(
     const string& name, const std::list<shared_ptr<production::Terminal>>& terms)
 {
@@ -1973,6 +2098,29 @@ shared_ptr<hilti::Expression> ParserBuilder::hiltiUnpack(shared_ptr<Type> target
                                                          shared_ptr<hilti::Expression> op3,
                                                          unpack_callback callback)
 {
+    auto rtype =
+        hilti::builder::tuple::type({cg()->hiltiType(target_type), _hiltiTypeIteratorBytes()});
+
+    if ( _fixed_eod ) {
+        // Part of a fixed-layout run, we know there's enough input.
+        auto result = cg()->builder()->addTmp("unpacked", rtype, nullptr, true);
+        auto result_val =
+            cg()->builder()->addTmp("unpacked_val", cg()->hiltiType(target_type), nullptr, true);
+
+        auto iters = hilti::builder::tuple::create({state()->cur, _fixed_eod});
+        cg()->builder()->addInstruction(result, hilti::instruction::operator_::Unpack, iters, op2,
+                                        op3);
+        cg()->builder()->addInstruction(result_val, hilti::instruction::tuple::Index, result,
+                                        hilti::builder::integer::create(0));
+
+        auto ncur = cg()->builder()->addTmp("ncur", _hiltiTypeIteratorBytes());
+        cg()->builder()->addInstruction(ncur, hilti::instruction::tuple::Index, result,
+                                        hilti::builder::integer::create(1));
+        _hiltiAdvanceTo(ncur);
+
+        return result_val;
+    }
+
     auto parse = cg()->moduleBuilder()->newBuilder("parse");
     auto cont = cg()->moduleBuilder()->newBuilder("cont");
     auto yield = cg()->moduleBuilder()->newBuilder("yield");
@@ -1981,8 +2129,6 @@ shared_ptr<hilti::Expression> ParserBuilder::hiltiUnpack(shared_ptr<Type> target
 
     cg()->moduleBuilder()->pushBuilder(parse);
 
-    auto rtype =
-        hilti::builder::tuple::type({cg()->hiltiType(target_type), _hiltiTypeIteratorBytes()});
     auto result = cg()->builder()->addTmp("unpacked", rtype, nullptr, true);
     auto result_val =
         cg()->builder()->addTmp("unpacked_val", cg()->hiltiType(target_type), nullptr, true);
@@ -2053,6 +2199,7 @@ shared_ptr<hilti::Expression> ParserBuilder::_hiltiInsufficientInputHandler(
     auto resume = cg()->moduleBuilder()->newBuilder("resume");
 
     auto suspend = cg()->moduleBuilder()->pushBuilder("suspend");
+    _hiltiTrimInputOnYield();
     _hiltiDebugVerbose("out of input, yielding ...");
     cg()->builder()->addInstruction(hilti::instruction::flow::YieldUntil, state()->data);
     cg()->builder()->addInstruction(hilti::instruction::flow::Jump, resume->block());
@@ -2142,6 +2289,47 @@ void ParserBuilder::_hiltiTrimInput()
     }
 }
 
+void ParserBuilder::_hiltiTrimInputOnYield()
+{
+    if ( state()->unit->buffering() )
+        return;
+
+    // Positions get pinned in the order they are saved while parsing moves
+    // forward, so the first one is the earliest we may still go back to.
+    auto pos = _pinned.size() ? _pinned.front() : state()->cur;
+
+    auto trim = cg()->builder()->addTmp("trim_on_yield", hilti::builder::boolean::type());
+    cg()->builder()->addInstruction(trim, hilti::instruction::operator_::Assign, state()->trim);
+
+    if ( state()->unit->trackLookAhead() ) {
+        // A pending look-ahead symbol still needs the input from where it
+        // starts. We can't tell statically how that relates to the pinned
+        // positions, so we don't trim at all then.
+        auto no_lah = cg()->builder()->addTmp("no_lah", hilti::builder::boolean::type());
+        cg()->builder()->addInstruction(no_lah, hilti::instruction::operator_::Equal,
+                                        state()->lahead, _hiltiLookAheadNone());
+        cg()->builder()->addInstruction(trim, hilti::instruction::boolean::And, trim, no_lah);
+    }
+
+    auto branches = cg()->builder()->addIf(trim);
+    auto do_trim = std::get<0>(branches);
+    auto done = std::get<1>(branches);
+
+    cg()->moduleBuilder()->pushBuilder(do_trim);
+    cg()->builder()->addInstruction(hilti::instruction::bytes::Trim, state()->data, pos);
+    cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+    cg()->moduleBuilder()->popBuilder(do_trim);
+
+    cg()->moduleBuilder()->pushBuilder(done); // Leave on stack.
+
+    if ( cg()->options().debug > 0 ) {
+        auto retained = cg()->builder()->addTmp("retained", hilti::builder::integer::type(64));
+        cg()->builder()->addInstruction(retained, hilti::instruction::bytes::Length,
+                                        state()->data);
+        cg()->builder()->addDebugMsg("spicy-verbose", "- retaining %s bytes of input", retained);
+    }
+}
+
 void ParserBuilder::_hiltiFilterInput(bool resume)
 {
     if ( ! state()->unit->exported() )
@@ -2408,6 +2596,10 @@ void ParserBuilder::_hiltiFinishSynchronize(Production* sync_check, shared_ptr<P
 
 shared_ptr<hilti::Expression> ParserBuilder::_hiltiEod()
 {
+    if ( _fixed_eod )
+        // Inside a fixed-layout run, the end doesn't move.
+        return _fixed_eod;
+
     auto have_end = cg()->moduleBuilder()->addTmp("have_end", hilti::builder::boolean::type());
     cg()->builder()->addInstruction(have_end, hilti::instruction::integer::Sgeq, state()->end,
                                     hilti::builder::integer::create(0));
@@ -2546,6 +2738,7 @@ ParserBuilder::InputPosition ParserBuilder::_hiltiSavePosition()
 {
     auto saved = cg()->moduleBuilder()->addTmp("saved_cur", _hiltiTypeIteratorBytes());
     cg()->builder()->addInstruction(saved, hilti::instruction::operator_::Assign, state()->cur);
+    _hiltiPinPosition(saved);
     return saved;
 }
 
@@ -2554,6 +2747,16 @@ void ParserBuilder::_hiltiRestorePosition(InputPosition pos)
     cg()->builder()->addInstruction(state()->cur, hilti::instruction::operator_::Assign, pos);
 }
 
+void ParserBuilder::_hiltiPinPosition(InputPosition pos)
+{
+    _pinned.push_back(pos);
+}
+
+void ParserBuilder::_hiltiReleasePosition(InputPosition pos)
+{
+    _pinned.remove(pos);
+}
+
 ////////// Visit methods.
 
 void ParserBuilder::visit(expression::Ctor* c)
@@ -2656,6 +2859,9 @@ void ParserBuilder::visit(constant::Integer* i)
 
     cg()->moduleBuilder()->pushBuilder(cont);
 
+    if ( ocur )
+        _hiltiReleasePosition(ocur);
+
     setResult(value);
 }
 
@@ -2733,6 +2939,9 @@ void ParserBuilder::visit(ctor::Bytes* b)
 
     cg()->moduleBuilder()->pushBuilder(cont);
 
+    if ( ocur )
+        _hiltiReleasePosition(ocur);
+
     setResult(value);
 }
 
@@ -2767,6 +2976,7 @@ void ParserBuilder::visit(ctor::RegExp* r)
     auto value = cg()->moduleBuilder()->addTmp("data", _hiltiTypeBytes());
     auto ocur = cg()->moduleBuilder()->addTmp("ocur", _hiltiTypeIteratorBytes());
     cg()->builder()->addInstruction(ocur, hilti::instruction::operator_::Assign, state()->cur);
+    _hiltiPinPosition(ocur);
 
     auto mstate = _hiltiMatchTokenInit(name, {lit->sharedPtr<production::Literal>()});
     cg()->builder()->addInstruction(hilti::instruction::flow::Jump, loop->block());
@@ -2800,6 +3010,8 @@ void ParserBuilder::visit(ctor::RegExp* r)
 
     cg()->moduleBuilder()->pushBuilder(done);
 
+    _hiltiReleasePosition(ocur);
+
     cg()->builder()->addInstruction(hilti::instruction::operator_::Clear, mresult);
     cg()->builder()->addInstruction(hilti::instruction::operator_::Clear, mstate);
 
@@ -2933,17 +3145,40 @@ void ParserBuilder::visit(production::Counter* c)
     _startingProduction(c->sharedPtr<Production>(), field);
 
     auto i = cg()->builder()->addTmp("count-i", hilti::builder::integer::type(64));
+    auto cnt = cg()->hiltiExpression(c->expression(), std::make_shared<type::Integer>(64, false));
+    cg()->builder()->addInstruction(i, hilti::instruction::operator_::Assign, cnt);
+
+    // See visit(production::Sequence) for when we can rely on the input
+    // position to not change in between elements.
+    auto size = c->pgMeta()->fixed_element;
+    bool fixed_ok = (! state()->unit->buffering() && state()->mode == ParserState::DEFAULT &&
+                     ! _fixed_eod);
+
+    if ( size && fixed_ok )
+        _hiltiParseFixedCounter(c->sharedPtr<production::Counter>(), i, size);
+    else
+        _hiltiParseCounterLoop(c->sharedPtr<production::Counter>(), i);
+
+    _newValueForField(c->sharedPtr<Production>(), field, nullptr);
+    _finishedProduction(c->sharedPtr<Production>());
+
+    // Leave builder on stack.
+}
+
+void ParserBuilder::_hiltiParseCounterLoop(shared_ptr<production::Counter> c,
+                                           shared_ptr<hilti::Expression> count)
+{
+    auto field = c->pgMeta()->field;
+
     auto b = cg()->builder()->addTmp("count-bool", hilti::builder::boolean::type());
     auto cont = cg()->moduleBuilder()->newBuilder("count-done");
     auto parse_one = cg()->moduleBuilder()->newBuilder("count-parse-one");
     auto loop = cg()->moduleBuilder()->newBuilder("count-loop");
 
-    auto cnt = cg()->hiltiExpression(c->expression(), std::make_shared<type::Integer>(64, false));
-    cg()->builder()->addInstruction(i, hilti::instruction::operator_::Assign, cnt);
     cg()->builder()->addInstruction(hilti::instruction::flow::Jump, loop->block());
 
     cg()->moduleBuilder()->pushBuilder(loop);
-    cg()->builder()->addInstruction(b, hilti::instruction::integer::Sleq, i,
+    cg()->builder()->addInstruction(b, hilti::instruction::integer::Sleq, count,
                                     hilti::builder::integer::create(0));
     cg()->builder()->addInstruction(hilti::instruction::flow::IfElse, b, cont->block(),
                                     parse_one->block());
@@ -2968,18 +3203,108 @@ void ParserBuilder::visit(production::Counter* c)
                                   cg()->hookForItem(state()->unit, field, true, false, false), {},
                                   field, true, value, false, state()->cookie);
 
-    cg()->builder()->addInstruction(i, hilti::instruction::integer::Decr, i);
+    cg()->builder()->addInstruction(count, hilti::instruction::integer::Decr, count);
     cg()->builder()->addInstruction(hilti::instruction::flow::IfElse, stop, cont->block(),
                                     loop->block());
 
     cg()->moduleBuilder()->popBuilder(parse_one);
 
-    cg()->moduleBuilder()->pushBuilder(cont);
+    cg()->moduleBuilder()->pushBuilder(cont); // Leave on stack.
+}
 
-    _newValueForField(c->sharedPtr<Production>(), field, nullptr);
-    _finishedProduction(c->sharedPtr<Production>());
+void ParserBuilder::_hiltiParseFixedCounter(shared_ptr<production::Counter> c,
+                                            shared_ptr<hilti::Expression> count, int size)
+{
+    auto field = c->pgMeta()->field;
+    auto var = ast::rtti::checkedCast<production::Variable>(c->body());
+    auto elem = var->pgMeta()->field;
+    auto itype = ast::rtti::tryCast<type::Integer>(var->type());
+    auto vector = ast::rtti::tryCast<type::unit::item::field::container::Vector>(field);
+
+    // We can fill a vector of integers directly if the only foreach hook
+    // inside the unit is the one adding the elements. We check for any
+    // external ones below.
+    bool bulk = (vector && itype && cg()->options().debug == 0);
+
+    if ( bulk ) {
+        for ( auto h : vector->hooks() ) {
+            if ( h->foreach () && h != vector->pushHook() )
+                bulk = false;
+        }
+    }
 
-    // Leave builder on stack.
+    cg()->builder()->addComment(
+        util::fmt("Container of fixed-size elements, %d bytes each%s", size, bulk ? ", bulk" : ""));
+
+    // The count comes from the input, so we compare against the number of
+    // elements available rather than multiplying it out, which could wrap.
+    auto eod = _hiltiEod();
+    auto avail = cg()->moduleBuilder()->addTmp("fixed_avail", hilti::builder::integer::type(64));
+    cg()->builder()->addInstruction(avail, hilti::instruction::bytes::Diff, state()->cur, eod);
+    cg()->builder()->addInstruction(avail, hilti::instruction::integer::Div, avail,
+                                    hilti::builder::integer::create(size));
+
+    auto enough = cg()->moduleBuilder()->addTmp("fixed_enough", hilti::builder::boolean::type());
+    auto positive =
+        cg()->moduleBuilder()->addTmp("fixed_positive", hilti::builder::boolean::type());
+    cg()->builder()->addInstruction(enough, hilti::instruction::integer::Sleq, count, avail);
+    cg()->builder()->addInstruction(positive, hilti::instruction::integer::Sgt, count,
+                                    hilti::builder::integer::create(0));
+    cg()->builder()->addInstruction(enough, hilti::instruction::boolean::And, enough, positive);
+
+    auto branches = cg()->builder()->addIfElse(enough);
+    auto fast = std::get<0>(branches);
+    auto slow = std::get<1>(branches);
+    auto done = std::get<2>(branches);
+
+    // Not enough input yet, parse element by element so that we can suspend
+    // where needed.
+    cg()->moduleBuilder()->pushBuilder(slow);
+    _hiltiParseCounterLoop(c, count);
+    cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+    cg()->moduleBuilder()->popBuilder(slow);
+
+    // All the input is there, parse the elements without checking again.
+    auto fast_loop = cg()->moduleBuilder()->pushBuilder("fixed-loop");
+    _fixed_eod = eod;
+    _hiltiParseCounterLoop(c, count);
+    _fixed_eod = nullptr;
+    cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+    cg()->moduleBuilder()->popBuilder(fast_loop);
+
+    cg()->moduleBuilder()->pushBuilder(fast);
+
+    if ( ! bulk )
+        cg()->builder()->addInstruction(hilti::instruction::flow::Jump, fast_loop->block());
+
+    else {
+        auto fill = cg()->moduleBuilder()->pushBuilder("fixed-fill");
+        _hiltiDebugVerbose(util::fmt("filling vector from %d-byte elements", size));
+
+        if ( vector->pushHook() ) {
+            auto byteorder = elem->inheritedProperty("byteorder");
+            auto fmt = cg()->hiltiIntPackFormat(itype->width(), itype->signed_(), byteorder);
+            auto container = cg()->hiltiItemGet(state()->self, field);
+
+            cg()->builder()->addInstruction(
+                hilti::instruction::flow::CallVoid,
+                hilti::builder::id::create("SpicyHilti::vector_append_unpacked"),
+                hilti::builder::tuple::create({container, state()->cur, count, fmt}));
+        }
+
+        _hiltiAdvanceBy(needed);
+        cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+        cg()->moduleBuilder()->popBuilder(fill);
+
+        // The loops above have declared the foreach hooks.
+        auto hooked = cg()->hiltiFieldHooksImplemented(state()->unit, field, false, true);
+        cg()->builder()->addInstruction(hilti::instruction::flow::IfElse, hooked,
+                                        fast_loop->block(), fill->block());
+    }
+
+    cg()->moduleBuilder()->popBuilder(fast);
+
+    cg()->moduleBuilder()->pushBuilder(done); // Leave on stack.
 }
 
 void ParserBuilder::visit(production::ByteBlock* c)
@@ -3140,7 +3465,11 @@ void ParserBuilder::visit(production::LookAhead* l)
     assert(! (defaults.first && defaults.second));
 
     bool must_find = (defaults.first && defaults.second);
-    _hiltiGetLookAhead(l->sharedPtr<production::LookAhead>(), terms, must_find);
+
+    if ( l->firstBytes().size() )
+        _hiltiGetLookAheadByFirstByte(l->sharedPtr<production::LookAhead>(), terms, must_find);
+    else
+        _hiltiGetLookAhead(l->sharedPtr<production::LookAhead>(), terms, must_find);
 
     cg()->builder()->addInstruction(hilti::instruction::flow::Jump, have_lahead->block());
     cg()->moduleBuilder()->popBuilder(no_lahead);
@@ -3246,8 +3575,29 @@ void ParserBuilder::visit(production::Sequence* s)
 {
     _startingProduction(s->sharedPtr<Production>(), nullptr);
 
-    for ( auto p : s->sequence() )
-        parse(p);
+    auto prods = s->sequence();
+
+    // If a hook can move the input position, we can't unpack a whole run
+    // of fields upfront.
+    bool fixed_ok = (! state()->unit->buffering() && state()->mode == ParserState::DEFAULT &&
+                     ! _fixed_eod);
+
+    for ( auto i = prods.begin(); i != prods.end(); ) {
+        auto run = (*i)->pgMeta()->fixed_run;
+
+        if ( fixed_ok && run > 1 && std::distance(i, prods.end()) >= run ) {
+            auto end = i;
+            std::advance(end, run);
+
+            std::list<shared_ptr<Production>> fixed(i, end);
+            _hiltiParseFixedRun(fixed, (*i)->pgMeta()->fixed_run_bytes);
+
+            i = end;
+            continue;
+        }
+
+        parse(*i++);
+    }
 
     _finishedProduction(s->sharedPtr<Production>());
 }
@@ -3474,6 +3824,54 @@ void ParserBuilder::visit(type::Bool* b)
 {
 }
 
+void ParserBuilder::_hiltiParseFixedRun(const std::list<shared_ptr<Production>>& prods,
+                                         int bytes)
+{
+    int n = prods.size();
+    cg()->builder()->addComment(util::fmt("Fixed-layout run of %d fields, %d bytes", n, bytes));
+
+    auto eod = _hiltiEod();
+    auto avail = cg()->moduleBuilder()->addTmp("fixed_avail", hilti::builder::integer::type(64));
+    cg()->builder()->addInstruction(avail, hilti::instruction::bytes::Diff, state()->cur, eod);
+
+    auto enough = cg()->moduleBuilder()->addTmp("fixed_enough", hilti::builder::boolean::type());
+    cg()->builder()->addInstruction(enough, hilti::instruction::integer::Ugeq, avail,
+                                    hilti::builder::integer::create(bytes));
+
+    auto branches = cg()->builder()->addIfElse(enough);
+    auto fast = std::get<0>(branches);
+    auto slow = std::get<1>(branches);
+    auto done = std::get<2>(branches);
+
+    // All the input is there, unpack without checking again. The hooks
+    // triggered in between can't change the input position (see the
+    // caller), so the end position remains valid throughout.
+    cg()->moduleBuilder()->pushBuilder(fast);
+    _hiltiDebugVerbose(util::fmt("parsing fixed-layout run of %d bytes", bytes));
+
+    _fixed_eod = eod;
+
+    for ( auto p : prods )
+        parse(p);
+
+    _fixed_eod = nullptr;
+
+    cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+    cg()->moduleBuilder()->popBuilder(fast);
+
+    // Not enough input yet, parse field by field so that we can suspend
+    // where needed.
+    cg()->moduleBuilder()->pushBuilder(slow);
+
+    for ( auto p : prods )
+        parse(p);
+
+    cg()->builder()->addInstruction(hilti::instruction::flow::Jump, done->block());
+    cg()->moduleBuilder()->popBuilder(slow);
+
+    cg()->moduleBuilder()->pushBuilder(done);
+}
+
 void ParserBuilder::_hiltiCheckChunk(shared_ptr<type::unit::item::Field> field)
 {
     auto chunked = field->attributes()->lookup("chunked");
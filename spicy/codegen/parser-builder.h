@@ -297,6 +297,13 @@ private:
                             const std::list<shared_ptr<production::Terminal>>& terms,
                             bool must_find);
 
+    // Like _hiltiGetLookAhead(), but first narrows down the candidates by
+    // switching on the next input byte according to the production's
+    // first-byte table.
+    void _hiltiGetLookAheadByFirstByte(shared_ptr<production::LookAhead> prod,
+                                       const std::list<shared_ptr<production::Terminal>>& terms,
+                                       bool must_find);
+
     // Generates HILTI code to initialize the matching state for finding the
     // next token.
     shared_ptr<hilti::Expression> _hiltiMatchTokenInit(
@@ -347,6 +354,11 @@ private:
     // Trim input bytes to current parsing position if we can.
     void _hiltiTrimInput();
 
+    // Trim input bytes before suspending for more input, up to the earliest
+    // position the generated code may still access. Does nothing if there's
+    // no such position we can determine statically.
+    void _hiltiTrimInputOnYield();
+
     // Turns a unit's parameters into a HILTI function parameter list, adding
     // to the given list.
     void _hiltiUnitParameters(shared_ptr<type::Unit> unit,
@@ -361,6 +373,26 @@ private:
     // parsing step for a newly instantiated parser.
     void _hiltiFilterInput(bool resume);
 
+    // Parses a run of consecutive fixed-size fields as determined by the
+    // FixedLayout pass. If the run's total number of bytes is already
+    // available, the fields are unpacked straight-line without any further
+    // checks for input; otherwise we fall back to parsing them one by one.
+    void _hiltiParseFixedRun(const std::list<shared_ptr<Production>>& prods, int bytes);
+
+    // Generates the loop parsing the body of a Counter production for the
+    // number of times given by *count*. Leaves the builder for the code
+    // following the loop on the stack.
+    void _hiltiParseCounterLoop(shared_ptr<production::Counter> c,
+                                shared_ptr<hilti::Expression> count);
+
+    // Parses a Counter production repeating a fixed-size field as
+    // determined by the FixedLayout pass. If all elements are already
+    // available, they are parsed without further checks for input, and
+    // vectors of integers are filled in one go if no foreach hooks need to
+    // run; otherwise we fall back to parsing them one by one.
+    void _hiltiParseFixedCounter(shared_ptr<production::Counter> c,
+                                 shared_ptr<hilti::Expression> count, int size);
+
     // Helper for bytes parsing, implements &chunked.
     void _hiltiCheckChunk(shared_ptr<type::unit::item::Field> field);
 
@@ -425,14 +457,26 @@ private:
     typedef shared_ptr<hilti::Expression> InputPosition;
 
     // Saves the current input position so that it can be later restored.
+    // The position stays pinned until released with _hiltiReleasePosition().
     InputPosition _hiltiSavePosition();
 
     // Restores a previoysly saved input position.
     void _hiltiRestorePosition(InputPosition pos);
 
+    // Records that the code generated from now on may go back to an input
+    // position, so that input before it must not be trimmed.
+    void _hiltiPinPosition(InputPosition pos);
+
+    // Removes a position previously recorded with _hiltiPinPosition() or
+    // _hiltiSavePosition().
+    void _hiltiReleasePosition(InputPosition pos);
+
     std::list<shared_ptr<ParserState>> _states;
     shared_ptr<hilti::Expression> _last_parsed_value;
     shared_ptr<production::Literal> _cur_literal;
+    shared_ptr<hilti::Expression> _fixed_eod = nullptr;
+    std::list<InputPosition> _pinned;
+    std::list<std::list<InputPosition>> _pinned_outer;
     int _store_values;
 };
 }
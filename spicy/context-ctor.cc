@@ -46,3 +46,13 @@ std::unique_ptr<llvm::Module> spicy::CompilerContext::linkModules(
 {
     return linkModules(output, std::move(modules), std::list<string>(), path_list(), path_list());
 }
+
+void spicy::CompilerContext::_toCacheKeyCompiler(::util::cache::FileCache::Key* key)
+{
+    hilti::CompilerContext::toCacheKeyCompiler(key);
+
+    key->hashes.insert(::util::cache::hash(configuration().version));
+    key->files.insert(configuration().runtime_library_bca);
+    key->files.insert(configuration().runtime_library_bca_dbg);
+    key->files.insert(configuration().runtime_library_hlt);
+}
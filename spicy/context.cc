@@ -24,6 +24,7 @@
 
 #include "parser/driver.h"
 
+#include "passes/fixed-layout.h"
 #include "passes/grammar-builder.h"
 #include "passes/id-resolver.h"
 #include "passes/normalizer.h"
@@ -52,7 +53,7 @@ const spicy::Options& spicy::CompilerContext::options() const
     return *_options;
 }
 
-shared_ptr<spicy::Module> spicy::CompilerContext::load(string path, bool finalize)
+string spicy::CompilerContext::_findModule(string path) const
 {
     path = util::strtolower(path);
 
@@ -61,14 +62,25 @@ shared_ptr<spicy::Module> spicy::CompilerContext::load(string path, bool finaliz
 
     string full_path = util::findInPaths(path, options().libdirs_spicy);
 
+    if ( full_path.size() == 0 )
+        return "";
+
+    char buf[PATH_MAX];
+    if ( ! realpath(full_path.c_str(), buf) )
+        return "";
+
+    return buf;
+}
+
+shared_ptr<spicy::Module> spicy::CompilerContext::load(string path, bool finalize)
+{
+    string full_path = _findModule(path);
+
     if ( full_path.size() == 0 ) {
         error(util::fmt("cannot find input file %s", path.c_str()));
         return nullptr;
     }
 
-    char buf[PATH_MAX];
-    full_path = realpath(full_path.c_str(), buf);
-
     auto m = _modules.find(full_path);
 
     if ( m != _modules.end() )
@@ -184,8 +196,9 @@ void spicy::CompilerContext::_endPass()
     auto cg_time = options().cgDebugging("time");
     auto cgpasses = options().cgDebugging("passes");
 
+    auto delta = util::currentTime() - pass.time;
+
     if ( cg_time || cgpasses ) {
-        auto delta = util::currentTime() - pass.time;
         auto indent = string(_hilti_context->passes().size(), ' ');
 
         if ( cgpasses || delta >= 0.1 )
@@ -194,6 +207,9 @@ void spicy::CompilerContext::_endPass()
                       << std::endl;
     }
 
+    if ( _hilti_context->passes().size() == 1 )
+        _hilti_context->addPassTime("spicy::" + pass.name, delta);
+
     _hilti_context->passes().pop_back();
 }
 
@@ -214,6 +230,7 @@ bool spicy::CompilerContext::finalize(shared_ptr<Module> module)
 
 bool spicy::CompilerContext::finalize(shared_ptr<Module> node, bool verify)
 {
+    passes::FixedLayout fixed_layout;
     passes::GrammarBuilder grammar_builder(std::cerr);
     passes::IDResolver id_resolver;
     passes::OverloadResolver overload_resolver(node);
@@ -340,6 +357,13 @@ bool spicy::CompilerContext::finalize(shared_ptr<Module> node, bool verify)
 
     _endPass();
 
+    _beginPass(node, fixed_layout);
+
+    if ( ! fixed_layout.run(node) )
+        return false;
+
+    _endPass();
+
     if ( verify ) {
         _beginPass(node, validator);
 
@@ -407,6 +431,29 @@ std::unique_ptr<llvm::Module> spicy::CompilerContext::compile(
     return llvm_module;
 }
 
+std::list<std::unique_ptr<llvm::Module>> spicy::CompilerContext::compile(
+    const std::list<string>& paths)
+{
+    std::list<shared_ptr<hilti::Module>> hilti_modules;
+
+    for ( auto p : paths ) {
+        auto module = load(p);
+
+        if ( ! module )
+            return std::list<std::unique_ptr<llvm::Module>>();
+
+        shared_ptr<hilti::Module> hilti_module;
+        compile(module, &hilti_module, true);
+
+        if ( ! hilti_module )
+            return std::list<std::unique_ptr<llvm::Module>>();
+
+        hilti_modules.push_back(hilti_module);
+    }
+
+    return _hilti_context->compile(hilti_modules);
+}
+
 bool spicy::CompilerContext::print(shared_ptr<Module> module, std::ostream& out)
 {
     passes::Printer printer(out);
@@ -434,8 +481,11 @@ shared_ptr<hilti::Type> spicy::CompilerContext::hiltiType(shared_ptr<spicy::Type
 void spicy::CompilerContext::toCacheKey(shared_ptr<Module> module,
                                         ::util::cache::FileCache::Key* key)
 {
-    if ( module->path() != "-" )
+    if ( module->path() != "-" ) {
+        std::ifstream in(module->path());
         key->files.insert(module->path());
+        key->hashes.insert(util::cache::hash(in));
+    }
 
     else {
         std::ostringstream s;
@@ -444,12 +494,37 @@ void spicy::CompilerContext::toCacheKey(shared_ptr<Module> module,
         key->hashes.insert(hash);
     }
 
-    for ( auto d : dependencies(module) )
+    for ( auto d : dependencies(module) ) {
+        std::ifstream in(d);
         key->files.insert(d);
+        key->hashes.insert(util::cache::hash(in));
+    }
+
+    _toCacheKeyCompiler(key);
 }
 
 std::list<string> spicy::CompilerContext::dependencies(shared_ptr<Module> module)
 {
-    // TODO: Not implementated.
-    return std::list<string>();
+    std::set<string> deps;
+    std::list<shared_ptr<Module>> todo = {module};
+
+    while ( todo.size() ) {
+        auto m = todo.front();
+        todo.pop_front();
+
+        for ( auto i : m->importedIDs() ) {
+            auto path = _findModule(i->name());
+
+            if ( path.empty() || path == module->path() || ! deps.insert(path).second )
+                continue;
+
+            // The scope builder has loaded all imports already.
+            auto j = _modules.find(path);
+
+            if ( j != _modules.end() )
+                todo.push_back(j->second);
+        }
+    }
+
+    return std::list<string>(deps.begin(), deps.end());
 }
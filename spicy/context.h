@@ -133,6 +133,18 @@ public:
     std::unique_ptr<llvm::Module> compile(const string& path,
                                           shared_ptr<hilti::Module>* hilti_module = nullptr);
 
+    /// Compiles a set of Spicy source files into LLVM modules. The
+    /// translation into HILTI proceeds one module at a time, but the HILTI
+    /// modules are then compiled into LLVM concurrently if Options::jobs
+    /// asks for that (see hilti::CompilerContext::compile()). After
+    /// compilation, the modules need to be linked with linkModules().
+    ///
+    /// paths: The relative or absolute paths to the sources to load.
+    ///
+    /// Returns: The LLVM modules, in the same order as *paths*; or an empty
+    /// list if errors are encountered with any of them.
+    std::list<std::unique_ptr<llvm::Module>> compile(const std::list<string>& paths);
+
     /// Links a set of compiled Spicy modules into a single LLVM module.
     /// All modules produced by compileModule() must be linked (and all
     /// together that will run as one executable). A module must not be
@@ -221,22 +233,30 @@ public:
     shared_ptr<hilti::CompilerContextJIT<JIT>> hiltiContext() const;
 
     /// Augments the cache key with values suitable to check if a module (or
-    /// any of its dependencies) has changed.
-    ///
-    /// \todo Dependencies aren't tracked yet.
+    /// any of its dependencies) has changed. This hashes the content of the
+    /// module and of everything it imports, and includes the compiler's
+    /// version. It does not include the options in effect, use
+    /// Options::toCacheKey() for that.
     ///
     /// module: The module to update the key for.
     ///
     /// key: The key to update.
     void toCacheKey(shared_ptr<Module> module, ::util::cache::FileCache::Key* key);
 
-    /// Returns a list of path names that this module depends on.
-    ///
-    /// \todo This is actually not yet implemented and always returns an
-    /// empty list currently.
+    /// Returns a list of path names that this module depends on. These are
+    /// the paths of all the modules it imports, directly or indirectly. The
+    /// module must have been finalized.
     std::list<string> dependencies(shared_ptr<Module> module);
 
 private:
+    // Returns the full path for a module to load, or an empty string if not
+    // found.
+    string _findModule(string path) const;
+
+    // Adds the compiler's identity to a cache key, including the Spicy
+    // runtime library.
+    static void _toCacheKeyCompiler(::util::cache::FileCache::Key* key);
+
     shared_ptr<Options> _options;
     shared_ptr<hilti::CompilerContextJIT<JIT>> _hilti_context;
 
@@ -1,8 +1,11 @@
 
+#include <cctype>
+#include <cstring>
 #include <vector>
 
 #include <util/util.h>
 
+#include "ctor.h"
 #include "expression.h"
 #include "grammar.h"
 
@@ -438,5 +441,82 @@ void Grammar::_computeTables()
         }
 
         lap->setLookAheads(v0, v1);
+        _computeFirstBytes(lap);
     }
 }
+
+// Inserts the bytes that input matching a look-ahead terminal may start with
+// into *bytes*. Returns false if we can't tell.
+static bool _firstBytes(shared_ptr<production::Terminal> t, std::set<unsigned char>* bytes)
+{
+    auto c = ast::rtti::tryCast<production::Ctor>(t);
+
+    if ( ! c )
+        return false;
+
+    if ( auto b = ast::rtti::tryCast<ctor::Bytes>(c->ctor()) ) {
+        if ( b->value().empty() )
+            return false;
+
+        bytes->insert(b->value()[0]);
+        return true;
+    }
+
+    if ( ! ast::rtti::isA<ctor::RegExp>(c->ctor()) || c->patterns().empty() )
+        return false;
+
+    // For regular expressions, we only deal with patterns starting with a
+    // plain character that must be there, and skip any with alternatives.
+    for ( auto p : c->patterns() ) {
+        if ( p.empty() || p.find('|') != string::npos )
+            return false;
+
+        auto c0 = static_cast<unsigned char>(p[0]);
+
+        if ( ! (isalnum(c0) || (c0 && strchr(" \"'!#%&,-/:;<=>@_`~", c0))) )
+            return false;
+
+        if ( p.size() > 1 && p[1] && strchr("?*{", p[1]) )
+            return false;
+
+        bytes->insert(c0);
+    }
+
+    return true;
+}
+
+void Grammar::_computeFirstBytes(shared_ptr<production::LookAhead> lap)
+{
+    production::LookAhead::first_byte_map table;
+    production::LookAhead::look_aheads unknown;
+
+    auto lahs = util::set_union(lap->lookAheads().first, lap->lookAheads().second);
+
+    for ( auto t : lahs ) {
+        std::set<unsigned char> bytes;
+
+        if ( ! _firstBytes(t, &bytes) ) {
+            unknown.insert(t);
+            continue;
+        }
+
+        for ( auto b : bytes )
+            table[b].insert(t);
+    }
+
+    // The table is only worth it if the first byte narrows down the
+    // candidates at least sometimes.
+    bool narrows = false;
+
+    for ( auto& e : table ) {
+        e.second = util::set_union(e.second, unknown);
+
+        if ( e.second.size() < lahs.size() )
+            narrows = true;
+    }
+
+    if ( ! narrows )
+        table.clear();
+
+    lap->setFirstBytes(table, unknown);
+}
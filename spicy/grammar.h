@@ -84,6 +84,7 @@ private:
     void _addProduction(shared_ptr<Production> p);
     void _simplify();
     void _computeTables();
+    void _computeFirstBytes(shared_ptr<production::LookAhead> lap);
 
     void _computeClosure(shared_ptr<Production> root, std::set<string>* used);
     bool _add(std::map<string, symbol_set>* tbl, shared_ptr<Production> dst, const symbol_set& src,
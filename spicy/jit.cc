@@ -14,6 +14,9 @@ JIT::JIT(hilti::CompilerContext* ctx) : hilti::JIT(ctx)
 
 JIT::~JIT()
 {
+    if ( ! initialized() )
+        return;
+
     auto jit_spicy_done = (void (*)())nativeFunction("__spicy_done");
     (*jit_spicy_done)();
 }
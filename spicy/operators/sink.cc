@@ -217,8 +217,10 @@ static const string _doc_add_filter =
     into the sink. If data has already been written when a filter is added,
     behaviour is undefined.
 
-    Currently, only a set of predefined filters can be used; see
-    ~~Spicy::Filter. One cannot define own filters in Spicy.
+    *t* may also be a ``string`` naming the filter, which selects any
+    filter type registered with the run-time system, including those that
+    host applications add beyond ~~Spicy::Filter. One cannot define own
+    filters in Spicy.
 
     Todo: We should probably either enables adding filters laters, or catch
     the case of adding them too late at run-time an abort with an exception.
@@ -242,6 +244,23 @@ opBegin(sink::AddFilter : MethodCall)
     }
 opEnd
 
+opBegin(sink::AddFilterByName : MethodCall)
+    opOp1(std::make_shared<type::Sink>());
+    opOp2(std::make_shared<type::MemberAttribute>(std::make_shared<ID>("add_filter")));
+    opCallArg1("t", std::make_shared<type::String>());
+
+    opDoc(_doc_add_filter);
+
+    opValidate()
+    {
+    }
+
+    opResult()
+    {
+        return std::make_shared<type::Void>();
+    }
+opEnd
+
 opBegin(sink::Size)
     opOp1(std::make_shared<type::Sink>());
 
@@ -424,6 +443,40 @@ opBegin(sink::SetAutoTrim : MethodCall)
     }
 opEnd
 
+static const string _doc_set_async =
+    R"(
+   Switches the sink into asynchronous mode, in which it hands all data over
+   to the virtual thread *vid* for reassembly and parsing. The caller then
+   no longer waits for connected units to process the data, unless more than
+   *max_pending* bytes are queued up (default is 1MB). In asynchronous mode,
+   units can only be connected by MIME type, their parse errors are not
+   reported back, and they don't see the host application's cookie. This
+   must be called before the sink is used in any other way. Closing the
+   sink switches it back to synchronous mode. If HILTI isn't running with
+   threads, the sink remains synchronous.
+   )";
+
+opBegin(sink::SetAsync : MethodCall)
+    opOp1(std::make_shared<type::Sink>());
+    opOp2(std::make_shared<type::MemberAttribute>(std::make_shared<ID>("set_async")));
+    opCallArg1("vid", std::make_shared<spicy::type::Integer>(64, true));
+    opCallArg2("max_pending", std::make_shared<type::OptionalArgument>(_makeUInt64()));
+
+    opDoc(_doc_set_async);
+
+    opValidate()
+    {
+        type_list args = {std::make_shared<spicy::type::Integer>(64, true),
+                          std::make_shared<type::OptionalArgument>(_makeUInt64())};
+        checkCallArgs(op3(), args);
+    }
+
+    opResult()
+    {
+        return std::make_shared<type::Void>();
+    }
+opEnd
+
 static const string _doc_set_policy =
     R"(
    Sets a sink's reassembly policy for ambigious input. As long as data hasn't been trimmed,
@@ -247,9 +247,10 @@ static const string _doc_add_filter =
     undefined.  Also note that filters can only be added to *exported* unit
     types.
 
-    Currently, only a set of predefined filters can be used; see
-    ~~Spicy::Filter. One cannot define own filters in Spicy (but one can
-    achieve a similar effect with sinks.)
+    The filter may also be given as a ``string`` naming it, which selects
+    any filter type registered with the run-time system, including those
+    that host applications add beyond ~~Spicy::Filter. One cannot define
+    own filters in Spicy (but one can achieve a similar effect with sinks.)
 
     Todo: We should probably either enables adding filters laters, or catch
     the case of adding them too late at run-time and abort with an exception.
@@ -273,6 +274,19 @@ opBegin(unit::AddFilter : MethodCall)
     }
 opEnd
 
+opBegin(unit::AddFilterByName : MethodCall)
+    opOp1(std::make_shared<type::Unit>());
+    opOp2(std::make_shared<type::MemberAttribute>(std::make_shared<ID>("add_filter")));
+    opCallArg1("f", std::make_shared<type::String>());
+
+    opDoc(_doc_add_filter);
+
+    opResult()
+    {
+        return std::make_shared<type::Void>();
+    }
+opEnd
+
 static const string _doc_disconnect =
     R"(
     Disconnect the unit from its parent sink. The unit gets signaled a
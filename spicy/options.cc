@@ -9,6 +9,9 @@ Options::Options()
     // Make sure we call the overridden version here.
     optimizations = optimizationLabels();
 
+    for ( auto o : optionalOptimizationLabels() )
+        optimizations.erase(o);
+
     libdirs_spicy.push_back(".");
 
     for ( auto p : spicy::configuration().spicy_library_dirs ) {
@@ -31,6 +34,9 @@ void Options::toCacheKey(::util::cache::FileCache::Key* key) const
 {
     hilti::Options::toCacheKey(key);
 
+    key->options += (generate_parsers ? "G" : "g");
+    key->options += (generate_composers ? "C" : "c");
+
     for ( auto d : libdirs_spicy )
         key->dirs.insert(d);
 }
@@ -0,0 +1,117 @@
+
+#include "fixed-layout.h"
+#include "../attribute.h"
+#include "../declaration.h"
+#include "../grammar.h"
+#include "../production.h"
+#include "../type.h"
+
+using namespace spicy;
+using namespace spicy::passes;
+
+FixedLayout::FixedLayout() : Pass<AstInfo>("spicy::FixedLayout", false)
+{
+}
+
+FixedLayout::~FixedLayout()
+{
+}
+
+bool FixedLayout::run(shared_ptr<ast::NodeBase> node)
+{
+    return processAllPreOrder(node);
+}
+
+int FixedLayout::fixedSize(shared_ptr<Production> p, bool element)
+{
+    auto var = ast::rtti::tryCast<production::Variable>(p);
+
+    if ( ! var )
+        return 0;
+
+    auto field = var->pgMeta()->field;
+
+    if ( ! field || ! field->forParsing() || field->condition() )
+        return 0;
+
+    if ( var->pgMeta()->for_each || (var->container() && ! element) )
+        return 0;
+
+    // Hooks defined inside other modules are still triggered by the
+    // generated code, but we don't specialize fields that come with their
+    // own.
+    if ( field->hooks().size() )
+        return 0;
+
+    for ( auto a : field->attributes()->attributes() ) {
+        if ( a->key() != "byteorder" && a->key() != "bitorder" )
+            return 0;
+    }
+
+    auto itype = ast::rtti::tryCast<type::Integer>(var->type());
+    auto btype = ast::rtti::tryCast<type::Bitfield>(var->type());
+
+    int width = 0;
+
+    if ( itype )
+        width = itype->width();
+
+    else if ( btype )
+        width = btype->width();
+
+    if ( width <= 0 || width % 8 != 0 )
+        return 0;
+
+    return width / 8;
+}
+
+void FixedLayout::_markRuns(shared_ptr<production::Sequence> seq)
+{
+    auto prods = seq->sequence();
+    auto i = prods.begin();
+
+    while ( i != prods.end() ) {
+        auto start = i;
+        int count = 0;
+        int bytes = 0;
+
+        for ( ; i != prods.end(); ++i ) {
+            auto size = fixedSize(*i);
+
+            if ( ! size )
+                break;
+
+            ++count;
+            bytes += size;
+        }
+
+        if ( count > 1 ) {
+            (*start)->pgMeta()->fixed_run = count;
+            (*start)->pgMeta()->fixed_run_bytes = bytes;
+        }
+
+        if ( i != prods.end() )
+            ++i;
+    }
+}
+
+void FixedLayout::visit(declaration::Type* t)
+{
+    // We are only interested in unit declarations.
+    auto unit = ast::rtti::tryCast<type::Unit>(t->type());
+
+    if ( ! unit || ! unit->grammar() )
+        return;
+
+    for ( auto p : unit->grammar()->productions() ) {
+        auto seq = ast::rtti::tryCast<production::Sequence>(p.second);
+
+        if ( seq )
+            _markRuns(seq);
+
+        auto counter = ast::rtti::tryCast<production::Counter>(p.second);
+
+        if ( counter )
+            counter->pgMeta()->fixed_element = fixedSize(counter->body(), true);
+    }
+}
@@ -0,0 +1,50 @@
+
+#ifndef SPICY_PASSES_FIXED_LAYOUT_H
+#define SPICY_PASSES_FIXED_LAYOUT_H
+
+#include <ast/pass.h>
+
+#include "../ast-info.h"
+#include "../common.h"
+
+namespace spicy {
+namespace passes {
+
+/// Finds maximal runs of consecutive fixed-size fields inside the unit
+/// grammars, as well as containers repeating a fixed-size field, and
+/// records them in the productions' parser generator meta information. The
+/// ParserBuilder uses that to parse such input with a single check for
+/// available input rather than field by field. This pass must run after
+/// the GrammarBuilder.
+class FixedLayout : public ast::Pass<AstInfo> {
+public:
+    FixedLayout();
+    virtual ~FixedLayout();
+
+    /// Annotates the grammars of all units in an AST.
+    ///
+    /// ast: The AST to process.
+    ///
+    /// Returns: True if no errors were encountered.
+    bool run(shared_ptr<ast::NodeBase> ast) override;
+
+    /// Returns the number of bytes that a production parses if it can be
+    /// part of a fixed-layout run, or zero if not. A production qualifies
+    /// if it parses an integer or bitfield field that has no condition, no
+    /// hooks attached inside its unit, and no attributes other than those
+    /// controlling the byte and bit order.
+    ///
+    /// element: If true, *p* is the body of a container production, and
+    /// the size of a single element is returned.
+    static int fixedSize(shared_ptr<Production> p, bool element = false);
+
+protected:
+    void visit(declaration::Type* t) override;
+
+private:
+    void _markRuns(shared_ptr<production::Sequence> seq);
+};
+}
+}
+
+#endif
@@ -515,6 +515,22 @@ void LookAhead::setLookAheads(const look_aheads& lah1, const look_aheads& lah2)
     _lahs = std::make_pair(lah1, lah2);
 }
 
+const LookAhead::first_byte_map& LookAhead::firstBytes() const
+{
+    return _first_bytes;
+}
+
+const LookAhead::look_aheads& LookAhead::firstBytesDefault() const
+{
+    return _first_bytes_default;
+}
+
+void LookAhead::setFirstBytes(const first_byte_map& table, const look_aheads& dflt)
+{
+    _first_bytes = table;
+    _first_bytes_default = dflt;
+}
+
 std::pair<shared_ptr<Production>, shared_ptr<Production>> LookAhead::alternatives() const
 {
     return std::make_pair(_alt1, _alt2);
@@ -5,6 +5,8 @@
 #ifndef SPICY_PGEN_PRODUCTION_H
 #define SPICY_PGEN_PRODUCTION_H
 
+#include <map>
+
 #include <ast/visitor.h>
 
 #include "common.h"
@@ -93,6 +95,19 @@ public:
         /// If the production corresponds to a for-each hook, this stores the
         /// corresponding field.
         shared_ptr<type::unit::item::Field> for_each = nullptr;
+
+        /// If the production starts a run of consecutive fixed-size fields
+        /// that can be parsed in a single step, the number of productions
+        /// in that run, including this one. Set by the FixedLayout pass.
+        int fixed_run = 0;
+
+        /// If fixed_run is set, the total number of bytes the run parses.
+        int fixed_run_bytes = 0;
+
+        /// For a Counter production repeating a fixed-size field, the
+        /// number of bytes each repetition parses. Set by the FixedLayout
+        /// pass.
+        int fixed_element = 0;
     };
 
     /// Returns a pointer to the production's meta information maintained
@@ -543,6 +558,19 @@ public:
     /// which the corresponding alternative should be selected.
     std::pair<look_aheads, look_aheads> lookAheads() const;
 
+    typedef std::map<unsigned char, look_aheads> first_byte_map;
+
+    /// Returns a table mapping the first byte of input to the look-ahead
+    /// symbols of both alternatives that can start with it. Symbols for which
+    /// we can't tell are part of all entries. The table is empty if
+    /// switching on the first byte wouldn't narrow down the candidates. Like
+    /// lookAheads(), this is computed by the ~Grammar.
+    const first_byte_map& firstBytes() const;
+
+    /// Returns the look-ahead symbols that may match input starting with a
+    /// byte not found in firstBytes().
+    const look_aheads& firstBytesDefault() const;
+
     /// Returns a boolean for each alternative indicating whether the
     /// corresponding look-ahead set is the default case. Any variable
     /// production is automatically considered a default, others may be
@@ -576,6 +604,10 @@ protected:
     /// Grammar calss when it computes the parsing tables.
     void setLookAheads(const look_aheads& lah1, const look_aheads& lah2);
 
+    /// Sets the first-byte dispatch table. Called from the Grammar class
+    /// when it computes the parsing tables.
+    void setFirstBytes(const first_byte_map& table, const look_aheads& dflt);
+
     string renderProduction() const override;
     alternative_list rhss() const override;
     bool supportsSynchronize() override;
@@ -583,6 +615,8 @@ protected:
 private:
     int _default = 0;
     std::pair<look_aheads, look_aheads> _lahs;
+    first_byte_map _first_bytes;
+    look_aheads _first_bytes_default;
     node_ptr<Production> _alt1;
     node_ptr<Production> _alt2;
 };
@@ -1481,6 +1481,7 @@ unit::item::field::Container::Container(shared_ptr<ID> id, shared_ptr<Field> fie
         auto hook_push = std::make_shared<spicy::Hook>(body_push, spicy::Hook::PARSE, 254, false,
                                                        true, parameter_list(), l);
         addHook(hook_push);
+        _push_hook = hook_push;
     }
 
     // If they have an &until/&while, they also get another (even higher
@@ -1532,6 +1533,11 @@ shared_ptr<unit::item::Field> unit::item::field::Container::field() const
     return _field;
 }
 
+shared_ptr<Hook> unit::item::field::Container::pushHook() const
+{
+    return _push_hook;
+}
+
 unit::item::field::container::List::List(shared_ptr<ID> id, shared_ptr<Field> field, Kind kind,
                                          shared_ptr<Expression> cond, const hook_list& hooks,
                                          const attribute_list& attrs, const expression_list& sinks,
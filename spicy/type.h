@@ -1680,10 +1680,15 @@ public:
     /// Returns the contained field.
     shared_ptr<Field> field() const;
 
+    /// Returns the foreach hook that the container installs to add each
+    /// parsed element, or null if the container is transient.
+    shared_ptr<Hook> pushHook() const;
+
     ACCEPT_VISITOR(Field);
 
 private:
     node_ptr<Field> _field;
+    shared_ptr<Hook> _push_hook;
 };
 
 namespace container {
@@ -0,0 +1,59 @@
+/*
+
+@TEST-EXEC:  hilti-build %INPUT -o a.out
+@TEST-EXEC:  ./a.out >output 2>&1
+@TEST-EXEC:  btest-diff output
+
+Checks that larger sub-ranges of heap-owned chunks share their storage
+with the source, while smaller ones and inline data are copied.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <libhilti.h>
+
+static int8_t* data(int len, char c)
+{
+    int8_t* d = hlt_malloc(len);
+    memset(d, c, len);
+    return d;
+}
+
+static void check(const char* what, hlt_bytes* b, int from, int to)
+{
+    hlt_execution_context* ctx = hlt_global_execution_context();
+    hlt_exception* excpt = 0;
+
+    hlt_iterator_bytes i1 = hlt_bytes_offset(b, from, &excpt, ctx);
+    hlt_iterator_bytes i2 = hlt_bytes_offset(b, to, &excpt, ctx);
+    hlt_bytes* sub = hlt_bytes_sub(i1, i2, &excpt, ctx);
+    hlt_iterator_bytes s = hlt_bytes_begin(sub, &excpt, ctx);
+
+    printf("%s: len=%d shared=%d %s\n", what, (int)hlt_bytes_len(sub, &excpt, ctx),
+           s.cur == i1.cur, excpt ? "exception" : "ok");
+}
+
+int main()
+{
+    hlt_init();
+
+    hlt_execution_context* ctx = hlt_global_execution_context();
+    hlt_exception* excpt = 0;
+
+    hlt_bytes* owned = hlt_bytes_new_from_data(data(200, 'a'), 200, &excpt, ctx);
+    check("owned, large", owned, 10, 110);
+    check("owned, small", owned, 10, 20);
+
+    hlt_bytes_append_raw(owned, data(200, 'b'), 200, &excpt, ctx);
+    check("appended owned, large", owned, 250, 350);
+    check("across chunks", owned, 150, 250);
+
+    int8_t* raw = data(200, 'c');
+    hlt_bytes* inline_ = hlt_bytes_new_from_data_copy(raw, 200, &excpt, ctx);
+    check("inline, large", inline_, 10, 110);
+    hlt_free(raw);
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+
+@TEST-EXEC:  hilti-build -v %INPUT -o a.out
+@TEST-EXEC:  ./a.out >output 2>&1
+@TEST-EXEC:  btest-diff output
+
+*/
+
+#include <libhilti.h>
+#include <assert.h>
+
+void fiber_func(hlt_fiber* fiber, void* p)
+{
+    hlt_fiber_return(fiber);
+}
+
+void run(hlt_execution_context* ctx)
+{
+    hlt_fiber* fiber = hlt_fiber_create(fiber_func, ctx, 0, ctx);
+    int rc = hlt_fiber_start(fiber, ctx);
+    assert(rc == 1);
+}
+
+int main(int argc, char** argv)
+{
+    hlt_init();
+
+    hlt_execution_context* ctx = hlt_global_execution_context();
+
+    // The first fiber needs to be created, all further ones get recycled.
+    for ( int i = 0; i < 10; i++ )
+        run(ctx);
+
+    hlt_fiber_stats stats = hlt_fiber_statistics(ctx);
+    fprintf(stderr, "hits=%lu misses=%lu\n", (unsigned long)stats.hits, (unsigned long)stats.misses);
+
+    // Hold on to more fibers than fit into the local magazines; the
+    // surplus gets deleted when they are returned.
+    size_t n = 3 * hlt_config_get()->fiber_magazine_size;
+    hlt_fiber** fibers = (hlt_fiber**)malloc(n * sizeof(hlt_fiber*));
+
+    for ( size_t i = 0; i < n; i++ )
+        fibers[i] = hlt_fiber_create(fiber_func, ctx, 0, ctx);
+
+    for ( size_t i = 0; i < n; i++ )
+        hlt_fiber_start(fibers[i], ctx);
+
+    free(fibers);
+
+    stats = hlt_fiber_statistics(ctx);
+    fprintf(stderr, "hits=%lu misses=%lu\n", (unsigned long)stats.hits, (unsigned long)stats.misses);
+
+    return 0;
+}
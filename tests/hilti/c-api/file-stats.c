@@ -0,0 +1,53 @@
+/*
+
+@TEST-EXEC:  hilti-build -v %INPUT -o a.out
+@TEST-EXEC:  ./a.out >output 2>&1
+@TEST-EXEC:  wc -l <file | tr -d ' ' >>output
+@TEST-EXEC:  btest-diff output
+
+*/
+
+#include <libhilti.h>
+#include <assert.h>
+#include <unistd.h>
+
+int main(int argc, char** argv)
+{
+    hlt_init();
+
+    hlt_execution_context* ctx = hlt_global_execution_context();
+    hlt_exception* excpt = 0;
+
+    hlt_file* f = hlt_file_new(&excpt, ctx);
+    hlt_string path = hlt_string_from_asciiz("file", &excpt, ctx);
+    hlt_file_open(f, path, Hilti_FileType_Text, Hilti_FileMode_Create, Hilti_Charset_UTF8, &excpt,
+                  ctx);
+
+    hlt_bytes* b = hlt_bytes_new_from_data_copy((const int8_t*)"ABCDE", 5, &excpt, ctx);
+
+    for ( int i = 0; i < 1000; i++ )
+        hlt_file_write_bytes(f, b, &excpt, ctx);
+
+    // The command queue thread performs the writes asynchronously, so wait
+    // until it has seen all of them.
+    hlt_file_stats stats;
+
+    for ( int i = 0; i < 1000; i++ ) {
+        stats = hlt_file_statistics(f, &excpt, ctx);
+        assert(! excpt);
+
+        if ( stats.records == 1000 )
+            break;
+
+        usleep(10000);
+    }
+
+    // Writes get coalesced, so there must be fewer syscalls than records.
+    fprintf(stderr, "records=%lu fewer-syscalls=%d\n", (unsigned long)stats.records,
+            stats.syscalls < stats.records);
+
+    hlt_file_close(f, &excpt, ctx);
+    assert(! excpt);
+
+    return 0;
+}
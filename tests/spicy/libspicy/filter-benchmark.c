@@ -0,0 +1,124 @@
+/*
+
+  We don't integrate this into the test-suite, it's for manual benchmarking
+  of the filter decoders.
+
+  @TEST-IGNORE
+  @TEST-EXEC:  hilti-build -B -v %INPUT -o a.out
+*/
+
+#include <assert.h>
+#include <sys/time.h>
+
+#include <libhilti.h>
+#include <libspicy.h>
+#include <libspicy/filter.h>
+
+double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return (double)(tv.tv_sec) + (double)(tv.tv_usec) / 1e6;
+}
+
+// Splits the input into chunks of the given size, as a sink would see them.
+hlt_bytes* make_input(const char* data, int64_t len, int64_t chunk, hlt_execution_context* ctx)
+{
+    hlt_exception* excpt = 0;
+    hlt_bytes* b = hlt_bytes_new(&excpt, ctx);
+
+    for ( int64_t i = 0; i < len; i += chunk ) {
+        int64_t n = (len - i < chunk ? len - i : chunk);
+        hlt_bytes_append_raw_copy(b, (int8_t*)data + i, n, &excpt, ctx);
+    }
+
+    return b;
+}
+
+void benchmark(const char* name, hlt_enum ftype, const char* data, int64_t len, int rounds)
+{
+    hlt_exception* excpt = 0;
+    hlt_execution_context* ctx = hlt_global_execution_context();
+
+    hlt_bytes* input = make_input(data, len, 1500, ctx);
+    int64_t total = 0;
+
+    double start = current_time();
+
+    for ( int i = 0; i < rounds; i++ ) {
+        spicy_filter* filter = spicyhilti_filter_add(0, ftype, &excpt, ctx);
+        hlt_bytes* output = spicyhilti_filter_decode(filter, input, &excpt, ctx);
+        assert(! excpt);
+        total += hlt_bytes_len(output, &excpt, ctx);
+        spicyhilti_filter_close(filter, &excpt, ctx);
+    }
+
+    double delta = current_time() - start;
+    double mbytes = (double)len * rounds / 1024 / 1024;
+
+    fprintf(stderr, "%-18s %.2fs => %.2f MB/sec input, %.2f MB/sec output\n", name, delta,
+            mbytes / delta, (double)total / 1024 / 1024 / delta);
+}
+
+int main(int argc, char** argv)
+{
+    hlt_init();
+    spicy_init();
+
+    int64_t len = 1024 * 1024;
+    int rounds = 200;
+
+    char* raw = malloc(len);
+    for ( int64_t i = 0; i < len; i++ )
+        raw[i] = (char)(i * 7 + (i >> 5));
+
+    // Base64, wrapped into lines like in MIME.
+    static const char* alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char* b64 = malloc(len * 2);
+    int64_t n = 0;
+
+    for ( int64_t i = 0; i + 3 <= len; i += 3 ) {
+        uint32_t x = ((uint8_t)raw[i] << 16) | ((uint8_t)raw[i + 1] << 8) | (uint8_t)raw[i + 2];
+        b64[n++] = alphabet[(x >> 18) & 0x3f];
+        b64[n++] = alphabet[(x >> 12) & 0x3f];
+        b64[n++] = alphabet[(x >> 6) & 0x3f];
+        b64[n++] = alphabet[x & 0x3f];
+
+        if ( (i / 3) % 19 == 18 ) {
+            b64[n++] = '\r';
+            b64[n++] = '\n';
+        }
+    }
+
+    hlt_enum base64 = {0, 1};
+    benchmark("base64", base64, b64, n, rounds);
+
+    // Hex.
+    static const char* digits = "0123456789abcdef";
+    char* hex = malloc(len * 2);
+
+    for ( int64_t i = 0; i < len; i++ ) {
+        hex[2 * i] = digits[(uint8_t)raw[i] >> 4];
+        hex[2 * i + 1] = digits[(uint8_t)raw[i] & 0x0f];
+    }
+
+    hlt_enum hexf = {0, 7};
+    benchmark("hex", hexf, hex, len * 2, rounds);
+
+    // Quoted-printable, with mostly literal text.
+    char* qp = malloc(len);
+
+    for ( int64_t i = 0; i < len; i++ )
+        qp[i] = (i % 64 == 0 ? '=' : 'a' + (i % 26));
+
+    for ( int64_t i = 0; i < len; i += 64 ) {
+        qp[i + 1] = '4';
+        qp[i + 2] = '1';
+    }
+
+    hlt_enum qpf = {0, 6};
+    benchmark("quoted-printable", qpf, qp, len, rounds);
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+
+@TEST-EXEC:  hilti-build -B %INPUT -o a.out
+@TEST-EXEC:  ./a.out >output 2>&1
+@TEST-EXEC:  btest-diff output
+
+Checks the limits of the decompressing filters, as well as output that
+fills the filter's buffers.
+
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <libhilti.h>
+#include <libspicy.h>
+#include <libspicy/filter.h>
+
+static hlt_enum zlib_filter = {0, 3};
+
+// Compresses len bytes of a repeating pattern and splits the result into
+// chunks of the given size, as a sink would see them.
+static hlt_bytes* make_input(int64_t len, int64_t chunk, hlt_execution_context* ctx)
+{
+    hlt_exception* excpt = 0;
+
+    uint8_t* raw = malloc(len);
+
+    for ( int64_t i = 0; i < len; i++ )
+        raw[i] = (uint8_t)(i % 251);
+
+    uLongf clen = compressBound(len);
+    uint8_t* compressed = malloc(clen);
+    compress2(compressed, &clen, raw, len, 9);
+
+    hlt_bytes* b = hlt_bytes_new(&excpt, ctx);
+
+    for ( int64_t i = 0; i < clen; i += chunk ) {
+        int64_t n = (clen - i < chunk ? clen - i : chunk);
+        hlt_bytes_append_raw_copy(b, (int8_t*)compressed + i, n, &excpt, ctx);
+    }
+
+    free(raw);
+    free(compressed);
+    return b;
+}
+
+// Verifies that the output matches what make_input() compressed.
+static int check_output(hlt_bytes* b, hlt_execution_context* ctx)
+{
+    hlt_exception* excpt = 0;
+    int64_t i = 0;
+    void* cookie = 0;
+    hlt_bytes_block block;
+    hlt_iterator_bytes begin = hlt_bytes_begin(b, &excpt, ctx);
+    hlt_iterator_bytes end = hlt_bytes_end(b, &excpt, ctx);
+
+    do {
+        cookie = hlt_bytes_iterate_raw(&block, cookie, begin, end, &excpt, ctx);
+
+        for ( const int8_t* p = block.start; p < block.end; p++, i++ ) {
+            if ( (uint8_t)*p != (uint8_t)(i % 251) )
+                return 0;
+        }
+    } while ( cookie );
+
+    return 1;
+}
+
+static void run(const char* name, uint64_t max_ratio, uint64_t max_size, int64_t len)
+{
+    hlt_exception* excpt = 0;
+    hlt_execution_context* ctx = hlt_global_execution_context();
+
+    spicy_set_decompression_limits(max_ratio, max_size);
+
+    hlt_bytes* input = make_input(len, 1500, ctx);
+    spicy_filter* filter = spicyhilti_filter_add(0, zlib_filter, &excpt, ctx);
+    hlt_bytes* output = spicyhilti_filter_decode(filter, input, &excpt, ctx);
+
+    if ( excpt ) {
+        char* msg = hlt_string_to_native(*(hlt_string*)excpt->arg, &excpt, ctx);
+        fprintf(stderr, "%s: %s, %s\n", name, excpt->type->name, msg);
+        hlt_free(msg);
+        GC_DTOR(excpt, hlt_exception, ctx);
+        excpt = 0;
+
+        // The filter must have been closed and not produce anything anymore.
+        output = spicyhilti_filter_decode(filter, input, &excpt, ctx);
+        fprintf(stderr, "%s: after error, %" PRId64 " bytes\n", name,
+                hlt_bytes_len(output, &excpt, ctx));
+    }
+
+    else {
+        int64_t n = hlt_bytes_len(output, &excpt, ctx);
+        fprintf(stderr, "%s: %" PRId64 " bytes, %s\n", name, n,
+                (n == len && check_output(output, ctx)) ? "ok" : "mismatch");
+    }
+
+    spicyhilti_filter_close(filter, &excpt, ctx);
+}
+
+int main(int argc, char** argv)
+{
+    hlt_init();
+    spicy_init();
+
+    // A decompression bomb stopped by the size limit.
+    run("max-size", 0, 64 * 1024, 4 * 1024 * 1024);
+
+    // A decompression bomb stopped by the ratio limit.
+    run("max-ratio", 100, 0, 16 * 1024 * 1024);
+
+    // The same input passes without limits.
+    run("unlimited", 0, 0, 16 * 1024 * 1024);
+
+    // Output that exactly fills the minimum buffer size.
+    run("full-buffer", 0, 0, 4096);
+
+    // Output spanning several buffers, each handed over once full.
+    run("multi-buffer", 0, 0, 1024 * 1024);
+
+    return 0;
+}
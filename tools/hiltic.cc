@@ -44,6 +44,12 @@ static struct option long_options[] = {{"ast", no_argument, 0, 'A'},
                                        {"opt", required_argument, 0, 'O'},
                                        {"add-stdlibs", no_argument, 0, 's'},
                                        {"disable-linker", no_argument, 0, 'C'},
+                                       {"jobs", required_argument, 0, 'J'},
+                                       {"native-runtime", no_argument, 0, 'N'},
+                                       {"pgo-generate", no_argument, 0, 'G'},
+                                       {"pgo-use", required_argument, 0, 'u'},
+                                       {"tiered", required_argument, 0, 'T'},
+                                       {"enable-opt", required_argument, 0, 'E'},
                                        {0, 0, 0, 0}};
 
 void usage()
@@ -51,6 +57,9 @@ void usage()
     auto dbglist = hilti::Options().cgDebugLabels();
     auto dbgstr = util::strjoin(dbglist.begin(), dbglist.end(), "/");
 
+    auto optlist = hilti::Options().optionalOptimizationLabels();
+    auto optstr = util::strjoin(optlist.begin(), optlist.end(), "/");
+
     cerr
         << "Usage: " << Name
         << " [options] <inputs> [ - <options for JIT main()> ]\n"
@@ -64,10 +73,16 @@ void usage()
            "used with one module.\n"
            "  -D | --cgdebug <type> Debug output during code generation; type can be "
         << dbgstr
+        << ".\n"
+           "  -E | --enable-opt <o> With -O, also apply optional optimization; o can be "
+        << optstr
         << ".\n"
            "  -F | --profile        Profile level. Each time increases level. [Default: 0]\n"
+           "  -G | --pgo-generate   Instrument code to record a profile for -u.\n"
            "  -I | --import <dir>   Search library files in <dir>. Can be given multiple times.\n"
+           "  -J | --jobs <n>       Compile *.hlt inputs with <n> parallel jobs. [Default: 1].\n"
            "  -L | --llvm-always    Like -l, but don't verify correctness first.\n"
+           "  -N | --native-runtime With -j, link against the native runtime library.\n"
            "  -O | --opt            Optimize generated code.                [Default: off].\n"
            "  -V | --llvm-first     Like -L, but print each file individually to stdout and don't "
            "link.\n"
@@ -81,11 +96,13 @@ void usage()
            "  -o | --output <file>  Specify output file.                    [Default: stdout].\n"
            "  -p | --print          Just output all parsed HILTI code again.\n"
            "  -s | --add-stdlibs    Add standard HILTI runtime libraries (implied with -j).\n"
+           "  -u | --pgo-use <file> Optimize code based on a profile recorded through -G.\n"
            "  -v | --version        Print version information.\n"
            "\n"
            "Options controlling JIT (-j) runtime behavior:\n"
            "\n"
            "  -P | --enable-profile Activate profiling support..\n"
+           "  -T | --tiered <n>     Optimize functions in the background once called <n> times.\n"
            "  -Z | --dump-libhilti-state With -j, dump global libhilti state to stderr for "
            "debugging. Use twice to print for host app, too.\n"
            "  -t | --threads        Number of worker threads; zero disables. [Default: 2.].\n"
@@ -137,7 +154,7 @@ std::unique_ptr<llvm::Module> loadLLVM(std::shared_ptr<hilti::CompilerContext> c
     return module;
 }
 
-std::unique_ptr<llvm::Module> compileHILTI(std::shared_ptr<hilti::CompilerContext> ctx, string path)
+shared_ptr<hilti::Module> loadHILTI(std::shared_ptr<hilti::CompilerContext> ctx, string path)
 {
     auto module = ctx->loadModule(path);
 
@@ -165,22 +182,35 @@ std::unique_ptr<llvm::Module> compileHILTI(std::shared_ptr<hilti::CompilerContex
         return nullptr;
     }
 
-    std::unique_ptr<llvm::Module> llvm_module(ctx->compile(module));
+    return module;
+}
 
-    if ( ! llvm_module )
-        error(path, "Aborting due to code generation error.");
+std::list<std::unique_ptr<llvm::Module>> compileHILTI(
+    std::shared_ptr<hilti::CompilerContext> ctx, const std::list<string>& paths,
+    const std::list<shared_ptr<hilti::Module>>& modules)
+{
+    auto llvm_modules = ctx->compile(modules);
+
+    if ( llvm_modules.empty() )
+        error("", "Aborting due to code generation error.");
 
     if ( output_llvm_individually ) {
-        if ( num_input_files > 1 )
-            cout << "<<< Begin " << path << endl;
+        auto p = paths.begin();
 
-        ctx->printBitcode(llvm_module.get(), cout);
+        for ( auto& m : llvm_modules ) {
+            if ( num_input_files > 1 )
+                cout << "<<< Begin " << *p << endl;
 
-        if ( num_input_files > 1 )
-            cout << ">>> End " << path << endl;
+            ctx->printBitcode(m.get(), cout);
+
+            if ( num_input_files > 1 )
+                cout << ">>> End " << *p << endl;
+
+            ++p;
+        }
     }
 
-    return llvm_module;
+    return llvm_modules;
 }
 
 bool runJIT(shared_ptr<hilti::CompilerContextJIT<hilti::JIT>> ctx,
@@ -226,7 +256,7 @@ int main(int argc, char** argv)
     hlt_config libhilti_config = *hlt_config_get();
 
     while ( true ) {
-        int c = getopt_long(argc, argv, "AdD:hjpcFWbClPt:LsVo:OvI:Z", long_options, 0);
+        int c = getopt_long(argc, argv, "AdD:E:hjpcFGWbClPt:LNsT:u:Vo:OvI:J:Z", long_options, 0);
 
         if ( c < 0 )
             break;
@@ -257,6 +287,12 @@ int main(int argc, char** argv)
             options->optimize = true;
             break;
 
+        case 'E':
+            if ( ! options->enableOptimization(optarg) )
+                error("", util::fmt("unknown optional optimization '%s'", optarg));
+
+            break;
+
         case 'p':
             output_hilti = true;
             ++num_output_types;
@@ -293,6 +329,27 @@ int main(int argc, char** argv)
             options->libdirs_hlt.push_back(optarg);
             break;
 
+        case 'J':
+            options->jobs = atoi(optarg);
+            break;
+
+        case 'N':
+            options->jit_native_runtime = true;
+            break;
+
+        case 'G':
+            options->pgo_generate = true;
+            break;
+
+        case 'T':
+            options->jit_tiered = true;
+            options->jit_tiered_threshold = atoi(optarg);
+            break;
+
+        case 'u':
+            options->pgo_use = optarg;
+            break;
+
         case 'F':
             ++options->profile;
             break;
@@ -382,12 +439,22 @@ int main(int argc, char** argv)
 
     auto ctx = std::make_shared<hilti::CompilerContextJIT<hilti::JIT>>(options);
 
-    // Go through input files and prepare LLVM modules.
+    std::list<shared_ptr<hilti::Module>> hilti_modules;
+    std::list<string> hilti_paths;
+
+    // Go through input files and prepare LLVM modules. We collect all HILTI
+    // modules first so that we can compile them in parallel.
     for ( auto input : inputs ) {
         std::unique_ptr<llvm::Module> module = 0;
 
-        if ( util::endsWith(input, ".hlt") )
-            module = compileHILTI(ctx, input);
+        if ( util::endsWith(input, ".hlt") ) {
+            auto hilti_module = loadHILTI(ctx, input);
+
+            if ( hilti_module ) {
+                hilti_modules.push_back(hilti_module);
+                hilti_paths.push_back(input);
+            }
+        }
 
         else if ( util::endsWith(input, ".ll") || util::endsWith(input, ".bc") )
             module = loadLLVM(ctx, input);
@@ -405,6 +472,13 @@ int main(int argc, char** argv)
             modules.push_back(std::move(module));
     }
 
+    if ( hilti_modules.size() ) {
+        auto compiled = compileHILTI(ctx, hilti_paths, hilti_modules);
+
+        for ( auto& m : compiled )
+            modules.push_back(std::move(m));
+    }
+
     if ( output_hilti || output_llvm_individually )
         // Done.
         return 0;
@@ -427,10 +501,12 @@ int main(int argc, char** argv)
     if ( options->jit ) {
         hlt_config_set(&libhilti_config);
 
-        if ( ! runJIT(ctx, std::move(linked_module), jitargs) )
-            return 1;
-        else
-            return 0;
+        auto success = runJIT(ctx, std::move(linked_module), jitargs);
+
+        if ( options->cgDebugging("time") )
+            ctx->printPassTimes(cerr);
+
+        return success ? 0 : 1;
     }
 
     ofstream out;
@@ -442,5 +518,8 @@ int main(int argc, char** argv)
     if ( output_bitcode )
         ctx->writeBitcode(linked_module.get(), out);
 
+    if ( options->cgDebugging("time") )
+        ctx->printPassTimes(cerr);
+
     return 0;
 }
@@ -16,6 +16,7 @@
 
 #include <errno.h>
 #include <getopt.h>
+#include <iostream>
 #include <stdio.h>
 #include <sys/resource.h>
 
@@ -100,6 +101,9 @@ static void usage(const char* prog)
 #ifdef SPICY_DRIVER_JIT
     auto dbglist = spicy::Options().cgDebugLabels();
     auto dbgstr = util::strjoin(dbglist.begin(), dbglist.end(), "/");
+
+    auto optlist = spicy::Options().optionalOptimizationLabels();
+    auto optstr = util::strjoin(optlist.begin(), optlist.end(), "/");
 #endif
 
     fprintf(stderr, "%s *.spicy [options]\n\n", prog);
@@ -115,6 +119,7 @@ static void usage(const char* prog)
     fprintf(stderr, "    -m <off>      Set mark at offset <off>; can be given multiple times\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "    -P            Enable profiling\n");
+    fprintf(stderr, "    -t <n>        Number of worker threads; zero disables. [Default: 2].\n");
     fprintf(stderr, "    -c            After parsing, compose data back to binary\n");
 #ifdef SPICY_DRIVER_JIT
     fprintf(stderr, "    -I            Add directory to import path.\n");
@@ -122,7 +127,16 @@ static void usage(const char* prog)
     fprintf(stderr, "    -D <type>     Debug output during code generation; type can be %s\n",
             dbgstr.c_str());
     fprintf(stderr, "    -O            Optimize generated code.             [Default: off].\n");
+    fprintf(stderr, "    -E <o>        With -O, also apply optional optimization; o can be %s\n",
+            optstr.c_str());
     fprintf(stderr, "    -C            Use module cache.                    [Default: off].\n");
+    fprintf(stderr, "    -J <n>        Compile modules with <n> parallel jobs. [Default: 1].\n");
+    fprintf(stderr, "    -L            Compile functions lazily on first call. [Default: off].\n");
+    fprintf(stderr,
+            "    -T <n>        Optimize functions in background once called <n> times.\n");
+    fprintf(stderr, "    -N            Link against native runtime library. [Default: off].\n");
+    fprintf(stderr, "    -G            Instrument code to record a profile for -u. [Default: off].\n");
+    fprintf(stderr, "    -u <file>     Optimize code based on a profile recorded through -G.\n");
 #endif
     fprintf(stderr, "\n");
 
@@ -509,6 +523,8 @@ void parseSingleInput(spicy_parser* p, int chunk_size, Embed* embeds)
 
 // C++ code for JIT version.
 
+static bool initParsers();
+
 bool jitSpicy(const std::list<string>& spcy, std::shared_ptr<spicy::Options> options)
 {
     hilti::init();
@@ -516,17 +532,36 @@ bool jitSpicy(const std::list<string>& spcy, std::shared_ptr<spicy::Options> opt
 
     PacContext = std::make_shared<spicy::CompilerContext>(options);
 
-    std::list<std::unique_ptr<llvm::Module>> llvm_modules;
+    // With caching enabled, we key the final code on all the sources and
+    // options. If we have compiled it before, we can skip all compilation.
+    ::util::cache::FileCache::Key key;
+    key.scope = "spicy-driver";
+    key.name = "jit";
+    options->toCacheKey(&key);
 
-    for ( auto p : spcy ) {
-        auto llvm_module = PacContext->compile(p);
+    if ( options->module_cache.size() ) {
+        for ( auto p : spcy ) {
+            auto module = PacContext->load(p);
+
+            if ( ! module ) {
+                fprintf(stderr, "loading %s failed\n", p.c_str());
+                return false;
+            }
 
-        if ( ! llvm_module ) {
-            fprintf(stderr, "compiling %p failed\n", p.c_str());
-            return false;
+            PacContext->toCacheKey(module, &key);
         }
 
-        llvm_modules.push_back(std::move(llvm_module));
+        Jit = PacContext->hiltiContext()->jitCached(key);
+
+        if ( Jit )
+            return initParsers();
+    }
+
+    auto llvm_modules = PacContext->compile(spcy);
+
+    if ( llvm_modules.empty() ) {
+        fprintf(stderr, "compiling failed\n");
+        return false;
     }
 
     auto linked_module = PacContext->linkModules("<jit analyzers>", std::move(llvm_modules));
@@ -536,13 +571,21 @@ bool jitSpicy(const std::list<string>& spcy, std::shared_ptr<spicy::Options> opt
         return false;
     }
 
-    Jit = PacContext->hiltiContext()->jit(std::move(linked_module));
+    Jit = PacContext->hiltiContext()->jit(std::move(linked_module), key);
 
     if ( ! Jit ) {
         fprintf(stderr, "jit failed");
         return false;
     }
 
+    if ( options->cgDebugging("time") )
+        PacContext->hiltiContext()->printPassTimes(std::cerr);
+
+    return initParsers();
+}
+
+static bool initParsers()
+{
     JitParsers = (spicy_parsers_func)Jit->nativeFunction("spicy_parsers");
 
     if ( ! JitParsers ) {
@@ -576,8 +619,10 @@ int main(int argc, char** argv)
     ::Options* options = &_options;
 #endif
 
+    int threads = -1;
+
     char ch;
-    while ( (ch = getopt(argc, argv, "i:p:t:v:s:dOBhD:UlTPgCI:e:m:c")) != -1 ) {
+    while ( (ch = getopt(argc, argv, "i:p:t:v:s:dOBhD:E:UlLNT:PgGu:CI:J:e:m:c")) != -1 ) {
         switch ( ch ) {
         case 'i':
             chunk_size = atoi(optarg);
@@ -603,6 +648,10 @@ int main(int argc, char** argv)
             ++options->profile;
             break;
 
+        case 't':
+            threads = atoi(optarg);
+            break;
+
         case 'l':
             list_parsers = true;
             break;
@@ -658,9 +707,42 @@ int main(int argc, char** argv)
             options->optimize = true;
             break;
 
+        case 'E':
+            if ( ! options->enableOptimization(optarg) ) {
+                fprintf(stderr, "unknown optional optimization '%s'\n", optarg);
+                exit(1);
+            }
+
+            break;
+
         case 'C':
             options->module_cache = ".cache";
             break;
+
+        case 'J':
+            options->jobs = atoi(optarg);
+            break;
+
+        case 'L':
+            options->jit_lazy = true;
+            break;
+
+        case 'T':
+            options->jit_tiered = true;
+            options->jit_tiered_threshold = atoi(optarg);
+            break;
+
+        case 'N':
+            options->jit_native_runtime = true;
+            break;
+
+        case 'G':
+            options->pgo_generate = true;
+            break;
+
+        case 'u':
+            options->pgo_use = optarg;
+            break;
 #endif
 
         case 'h':
@@ -683,6 +765,9 @@ int main(int argc, char** argv)
         cfg.profiling = 1;
     }
 
+    if ( threads >= 0 )
+        cfg.num_workers = threads;
+
     hlt_config_set(&cfg);
 
 #ifdef SPICY_DRIVER_JIT
@@ -24,6 +24,7 @@ static struct option long_options[] = {
     { "ast",     no_argument, 0, 'A' },
     { "debug",   no_argument, 0, 'd' },
     { "cgdebug", no_argument, 0, 'D' },
+    { "enable-opt", required_argument, 0, 'E' },
     { "help",    no_argument, 0, 'h' },
     { "print",   no_argument, 0, 'p' },
     { "print-always",   no_argument, 0, 'W' },
@@ -35,6 +36,8 @@ static struct option long_options[] = {
     { "optimize", no_argument, 0, 'O' },
     { "add-stdlibs", no_argument, 0, 's' },
     { "compose", no_argument, 0, 'c' },
+    { "pgo-generate", no_argument, 0, 'G' },
+    { "pgo-use", required_argument, 0, 'u' },
     { 0, 0, 0, 0 }
 };
 
@@ -43,6 +46,9 @@ void usage()
     auto dbglist = spicy::Options().cgDebugLabels();
     auto dbgstr = util::strjoin(dbglist.begin(), dbglist.end(), "/");
 
+    auto optlist = spicy::Options().optionalOptimizationLabels();
+    auto optstr = util::strjoin(optlist.begin(), optlist.end(), "/");
+
     cerr << "Usage: " << Name << " [options] <input.spicy>\n"
             "\n"
             "Options:\n"
@@ -52,6 +58,8 @@ void usage()
             "  -C | --cfg            When outputting HILTI code, include control/data flow information.\n"
             "  -d | --debug          Debug level for the generated code. Each time increases level. [Default: 0]\n"
             "  -D | --cgdebug <type> Debug output during code generation; type can be " << dbgstr << ".\n"
+            "  -E | --enable-opt <o> With -O, also apply optional optimization; o can be " << optstr << ".\n"
+            "  -G | --pgo-generate   Instrument code to record a profile for -u (for -l).\n"
             "  -h | --help           Print usage information.\n"
             "  -I | --import <dir>   Add directory to import path.\n"
             "  -n | --no-validate    Do not validate resulting Spicy or HILTI ASTs (for debugging only).\n"
@@ -63,6 +71,7 @@ void usage()
             "  -P | --prototypes     Generate C API prototypes for generated module.\n"
             "  -s | --add-stdlibs    Add standard HILTI runtime libraries (for -l).\n"
             "  -t | --type <t>       Type of code to generate: parse/compose/both [Default: parse].\n"
+            "  -u | --pgo-use <file> Optimize code based on a profile recorded through -G (for -l).\n"
             "\n";
 }
 
@@ -88,7 +97,7 @@ int main(int argc, char** argv)
     options->generate_composers = false;
 
     while ( true ) {
-        int c = getopt_long(argc, argv, "AcCdD:o:nOPWlspI:vht:", long_options, 0);
+        int c = getopt_long(argc, argv, "AcCdD:E:Go:nOPWlspI:vht:u:", long_options, 0);
 
         if ( c < 0 )
             break;
@@ -147,6 +156,20 @@ int main(int argc, char** argv)
             options->optimize = true;
             break;
 
+         case 'G':
+            options->pgo_generate = true;
+            break;
+
+         case 'u':
+            options->pgo_use = optarg;
+            break;
+
+         case 'E':
+            if ( ! options->enableOptimization(optarg) )
+                error("", util::fmt("unknown optional optimization '%s'", optarg));
+
+            break;
+
          case 'I':
             options->libdirs_spicy.push_back(optarg);
             break;